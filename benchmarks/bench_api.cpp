@@ -0,0 +1,91 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <benchmark/benchmark.h>
+#include "mastodon-cpp.hpp"
+#include "easy/entities/status.hpp"
+#include "fixtures.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    // Makes the parameter conversions accessible. Doesn't connect.
+    class exposed_api : public API
+    {
+    public:
+        exposed_api()
+        : API("example.com", "")
+        {}
+
+        using API::maptostr;
+        using API::maptoformdata;
+    };
+
+    // The parameters of a typical status with attachments.
+    const parameters status_parameters =
+    {
+        { "status", { "Café & croissants 🥐 #breakfast @someone@example.com"
+                      " https://example.com/some/long/path?with=query" }},
+        { "in_reply_to_id", { "102356486154185324" }},
+        { "media_ids", { "102356486154185325", "102356486154185326",
+                         "102356486154185327", "102356486154185328" }},
+        { "sensitive", { "false" }},
+        { "spoiler_text", { "Food" }},
+        { "visibility", { "unlisted" }},
+        { "language", { "en" }}
+    };
+}
+
+static void bench_unescape_html(benchmark::State &state)
+{
+    // Content of a status, as it is before the user sees it.
+    const string content =
+        Easy::Status(fixture("status.json")).content()
+        + "<p>Caf&eacute; &amp; croissants &#x1F950; &lt;3 &quot;Tr&egrave;s"
+          " bien&quot; &#8230; &#039;s&#039; &nbsp;&hellip;</p>";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(unescape_html(content));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()
+                                                 * content.size()));
+}
+BENCHMARK(bench_unescape_html);
+
+static void bench_maptostr(benchmark::State &state)
+{
+    exposed_api masto;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(masto.maptostr(status_parameters));
+    }
+}
+BENCHMARK(bench_maptostr);
+
+static void bench_maptoformdata(benchmark::State &state)
+{
+    exposed_api masto;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(masto.maptoformdata(status_parameters));
+    }
+}
+BENCHMARK(bench_maptoformdata);
@@ -0,0 +1,85 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <benchmark/benchmark.h>
+#include "easy/easy.hpp"
+#include "fixtures.hpp"
+
+using namespace Mastodon;
+
+// Streams with range(0) events, cycling through stream.txt.
+static void bench_parse_stream(benchmark::State &state)
+{
+    const string &events = fixture("stream.txt");
+    string stream;
+    for (std::size_t n = 0; n < static_cast<std::size_t>(state.range(0));
+         n += 3)
+    {
+        stream += events + '\n';
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Easy::parse_stream(stream));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()
+                                                 * stream.size()));
+}
+BENCHMARK(bench_parse_stream)->Arg(3)->Arg(30)->Arg(300);
+
+// Timelines with range(0) statuses. Mastodon sends 20 by default, 40 at
+// most.
+static void bench_json_array_to_vector(benchmark::State &state)
+{
+    const string timeline = repeat_array(
+        "statuses.json", static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Easy::json_array_to_vector(timeline));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()
+                                                 * timeline.size()));
+}
+BENCHMARK(bench_json_array_to_vector)->Arg(1)->Arg(20)->Arg(40);
+
+static void bench_string_to_time(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            Easy::string_to_time("2019-06-01T12:00:00.000Z"));
+    }
+}
+BENCHMARK(bench_string_to_time);
+
+static void bench_link(benchmark::State &state)
+{
+    const string header =
+        "<https://example.com/api/v1/timelines/home?max_id=102356486154185324>"
+        "; rel=\"next\", "
+        "<https://example.com/api/v1/timelines/home?min_id=102356570484364584>"
+        "; rel=\"prev\"";
+
+    for (auto _ : state)
+    {
+        Easy::Link link(header);
+        benchmark::DoNotOptimize(link.next());
+        benchmark::DoNotOptimize(link.prev());
+    }
+}
+BENCHMARK(bench_link);
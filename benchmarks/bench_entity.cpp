@@ -0,0 +1,81 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <benchmark/benchmark.h>
+#include "easy/entities/status.hpp"
+#include "fixtures.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    // Makes the protected getters of Entity accessible.
+    class exposed_status : public Easy::Status
+    {
+    public:
+        using Easy::Status::Status;
+        using Easy::Entity::get;
+        using Easy::Entity::get_string;
+    };
+}
+
+static void bench_from_string(benchmark::State &state)
+{
+    const string &json = fixture("status.json");
+    Easy::Status status;
+
+    for (auto _ : state)
+    {
+        status.from_string(json);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()
+                                                 * json.size()));
+}
+BENCHMARK(bench_from_string);
+
+static void bench_get(benchmark::State &state)
+{
+    const exposed_status status(fixture("status.json"));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.get("account.display_name"));
+    }
+}
+BENCHMARK(bench_get);
+
+static void bench_get_string(benchmark::State &state)
+{
+    const exposed_status status(fixture("status.json"));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.get_string("content"));
+    }
+}
+BENCHMARK(bench_get_string);
+
+static void bench_status_account(benchmark::State &state)
+{
+    const Easy::Status status(fixture("status.json"));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.account());
+    }
+}
+BENCHMARK(bench_status_account);
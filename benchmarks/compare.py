@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Compare two result files of Google Benchmark, written with
+--benchmark_out=<file> --benchmark_out_format=json.
+
+Exits with 1 if a benchmark got slower than the threshold allows.
+"""
+
+import argparse
+import json
+import sys
+
+UNITS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(filename):
+    """Return {name: CPU time in ns}, means of repetitions if present."""
+    with open(filename) as f:
+        benchmarks = json.load(f)["benchmarks"]
+
+    times = {}
+    for b in benchmarks:
+        if b.get("run_type") == "aggregate":
+            if b.get("aggregate_name") != "mean":
+                continue
+            name = b["run_name"]
+        elif "run_name" in b and any(
+                o.get("run_type") == "aggregate" and o["run_name"]
+                == b["run_name"] for o in benchmarks):
+            continue            # The mean is used.
+        else:
+            name = b["name"]
+        times[name] = b["cpu_time"] * UNITS[b.get("time_unit", "ns")]
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default: 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print("{:<40} {:>14} {:>14} {:>9}".format(
+        "Benchmark", "Baseline [ns]", "Current [ns]", "Change"))
+    for name in sorted(set(baseline) | set(current)):
+        if name not in baseline or name not in current:
+            print("{:<40} {:>14} {:>14} {:>9}".format(
+                name, "%.0f" % baseline[name] if name in baseline else "-",
+                "%.0f" % current[name] if name in current else "-", "n/a"))
+            continue
+
+        change = (current[name] / baseline[name] - 1) * 100
+        mark = ""
+        if change > args.threshold:
+            mark = "  <-- slower"
+            regressions += 1
+        print("{:<40} {:>14.0f} {:>14.0f} {:>+8.1f}%{}".format(
+            name, baseline[name], current[name], change, mark))
+
+    if regressions > 0:
+        print("\n%d benchmark(s) slower than %.1f%%."
+              % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
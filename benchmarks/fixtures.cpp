@@ -0,0 +1,63 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <jsoncpp/json/json.h>
+#include "fixtures.hpp"
+
+const string &fixture(const string &name)
+{
+    static std::map<string, string> cache;
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(name);
+    if (it == cache.end())
+    {
+        std::ifstream file(string(MASTODON_CPP_FIXTURES) + '/' + name);
+        if (!file.good())
+        {
+            throw std::runtime_error("Fixture not found: " + name);
+        }
+
+        std::ostringstream content;
+        content << file.rdbuf();
+        it = cache.emplace(name, content.str()).first;
+    }
+
+    return it->second;
+}
+
+const string repeat_array(const string &name, const std::size_t size)
+{
+    Json::Value elements;
+    std::istringstream(fixture(name)) >> elements;
+
+    Json::Value array(Json::arrayValue);
+    for (Json::ArrayIndex i = 0; i < size && elements.size() > 0; ++i)
+    {
+        array.append(elements[i % elements.size()]);
+    }
+
+    // Servers send compact JSON.
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, array);
+}
@@ -0,0 +1,38 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_BENCHMARK_FIXTURES_HPP
+#define MASTODON_CPP_BENCHMARK_FIXTURES_HPP
+
+#include <string>
+#include <cstddef>
+
+using std::string;
+
+/*!
+ *  @brief  Returns the content of a fixture in tests/fixtures, read once.
+ *
+ *          Throws std::runtime_error if the fixture doesn't exist.
+ */
+const string &fixture(const string &name);
+
+/*!
+ *  @brief  Returns a JSON array with the elements of the array in the
+ *          fixture, repeated until it has size elements.
+ */
+const string repeat_array(const string &name, const std::size_t size);
+
+#endif  // MASTODON_CPP_BENCHMARK_FIXTURES_HPP
@@ -6,10 +6,9 @@
 
 #include <iostream>
 #include <string>
-#include <cstdint>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
-#include <vector>
 #include "mastodon-cpp.hpp"
 #include "easy/all.hpp"
 
@@ -17,7 +16,6 @@ using std::cout;
 using std::cerr;
 using std::endl;
 using std::string;
-using std::uint8_t;
 using namespace Mastodon;
 
 int main(int argc, char *argv[])
@@ -32,33 +30,23 @@ int main(int argc, char *argv[])
     Easy::API masto(argv[1], "");
     //  Prepare a pointer to the http object, to cancel the stream later.
     std::unique_ptr<API::http> ptr;
-    // This variable is filled with the stream data.
-    string stream;
+    // Used to wake up the main thread if an error occurs.
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool error = false;
 
-    // Get the public timeline. The pointer is set here.
-    masto.get_stream(API::v1::streaming_public, ptr, stream);
-
-    // Listen to the stream for 120 seconds.
-    for (uint8_t counter = 0; counter < 120; ++counter)
-    {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-
-        // Acquire lock for the stream variable to avoid simultaneous access.
-        std::lock_guard<std::mutex> lock(ptr->get_mutex());
-        // Parse event stream into a vector.
-        std::vector<Easy::stream_event_type> events
-            = Easy::parse_stream(stream);
-        // Clear the stream buffer.
-        stream.clear();
-
-        for (const Easy::stream_event_type &event : events)
+    // Get the public timeline. The pointer is set here. The callback is
+    // called in the thread of the stream as soon as an event arrives.
+    masto.get_stream(
+        API::v1::streaming_public, ptr,
+        [&](const sse_event &event)
         {
             // Print out some information about the events.
-            switch (event.type)
+            switch (Easy::get_event_type(event))
             {
             case Easy::event_type::Update:
             {
-                Easy::Status status(event.data);
+                Easy::Status status(event.get_data());
                 cout << "[" << status.created_at().strtime("%T") << "] ";
                 cout << "Status from: " << status.account().acct()
                      << " (" << status.url() << ")\n";
@@ -66,7 +54,7 @@ int main(int argc, char *argv[])
             }
             case Easy::event_type::Notification:
             {
-                Easy::Notification notification(event.data);
+                Easy::Notification notification(event.get_data());
                 cout << "Notification involving: "
                      << notification.account().acct()
                      << " (" << notification.id() << ")\n";
@@ -74,29 +62,37 @@ int main(int argc, char *argv[])
             }
             case Easy::event_type::Delete:
             {
-                cout << "Deleted: " << event.data << endl;
+                cout << "Deleted: " << event.get_data() << endl;
                 break;
             }
             case Easy::event_type::Error:
             {
                 // Errors are reported in-stream. Print error and exit.
-                cerr << "Error: " << event.data << endl;
-                ptr->cancel_stream();
-                return 1;
+                cerr << "Error: " << event.get_data() << endl;
+                std::lock_guard<std::mutex> lock(mutex);
+                error = true;
+                cv.notify_one();
+                break;
             }
             default:
             {
                 cout << "Something undefined happened. 😱\n";
-                cout << event.data << endl;
+                cout << event.get_data() << endl;
             }
             }
-        }
+        });
+
+    // Listen to the stream for 120 seconds or until an error occurs.
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::seconds(120),
+                    [&error] { return error; });
     }
 
     // Close connection.
     ptr->cancel_stream();
 
-    return 0;
+    return (error ? 1 : 0);
 }
 
 #else
@@ -0,0 +1,175 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <exception>
+#include "debug.hpp"
+#include "mastodon-cpp.hpp"
+#include "thread_pool.hpp"
+
+using namespace Mastodon;
+using std::future;
+
+future<return_call> API::run_async(const std::function<return_call()> &call)
+{
+    // std::function needs a copyable object, std::packaged_task is not.
+    auto task = std::make_shared<std::packaged_task<return_call()>>(call);
+    future<return_call> result = task->get_future();
+
+    get_thread_pool().submit([task] { (*task)(); });
+
+    return result;
+}
+
+void API::run_async(const std::function<return_call()> &call,
+                    const callback_type &callback)
+{
+    get_thread_pool().submit(
+        [call, callback]
+        {
+            return_call ret;
+
+            try
+            {
+                ret = call();
+            }
+            catch (const std::exception &e)
+            {
+                ttlog(WARNING) << "Exception in asynchronous call: "
+                               << e.what() << '\n';
+                ret = { error::UNKNOWN, e.what(), 0, "" };
+            }
+
+            callback(ret);
+        });
+}
+
+future<return_call> API::get_async(const Mastodon::API::v1 &call)
+{
+    return run_async([this, call] { return get(call); });
+}
+
+future<return_call> API::get_async(const Mastodon::API::v1 &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return get(call, params); });
+}
+
+future<return_call> API::get_async(const Mastodon::API::v2 &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return get(call, params); });
+}
+
+future<return_call> API::get_async(const string &call)
+{
+    return run_async([this, call] { return get(call); });
+}
+
+void API::get_async(const Mastodon::API::v1 &call, const parameters &params,
+                    const callback_type &callback)
+{
+    run_async([this, call, params] { return get(call, params); }, callback);
+}
+
+void API::get_async(const Mastodon::API::v2 &call, const parameters &params,
+                    const callback_type &callback)
+{
+    run_async([this, call, params] { return get(call, params); }, callback);
+}
+
+void API::get_async(const string &call, const callback_type &callback)
+{
+    run_async([this, call] { return get(call); }, callback);
+}
+
+future<return_call> API::patch_async(const Mastodon::API::v1 &call,
+                                     const parameters &params)
+{
+    return run_async([this, call, params] { return patch(call, params); });
+}
+
+void API::patch_async(const Mastodon::API::v1 &call, const parameters &params,
+                      const callback_type &callback)
+{
+    run_async([this, call, params] { return patch(call, params); },
+              callback);
+}
+
+future<return_call> API::post_async(const Mastodon::API::v1 &call)
+{
+    return run_async([this, call] { return post(call); });
+}
+
+future<return_call> API::post_async(const Mastodon::API::v1 &call,
+                                    const parameters &params)
+{
+    return run_async([this, call, params] { return post(call, params); });
+}
+
+future<return_call> API::post_async(const string &call,
+                                    const parameters &params)
+{
+    return run_async([this, call, params] { return post(call, params); });
+}
+
+void API::post_async(const Mastodon::API::v1 &call, const parameters &params,
+                     const callback_type &callback)
+{
+    run_async([this, call, params] { return post(call, params); }, callback);
+}
+
+void API::post_async(const string &call, const parameters &params,
+                     const callback_type &callback)
+{
+    run_async([this, call, params] { return post(call, params); }, callback);
+}
+
+future<return_call> API::put_async(const Mastodon::API::v1 &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return put(call, params); });
+}
+
+future<return_call> API::put_async(const string &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return put(call, params); });
+}
+
+void API::put_async(const Mastodon::API::v1 &call, const parameters &params,
+                    const callback_type &callback)
+{
+    run_async([this, call, params] { return put(call, params); }, callback);
+}
+
+future<return_call> API::del_async(const Mastodon::API::v1 &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return del(call, params); });
+}
+
+future<return_call> API::del_async(const string &call,
+                                   const parameters &params)
+{
+    return run_async([this, call, params] { return del(call, params); });
+}
+
+void API::del_async(const Mastodon::API::v1 &call, const parameters &params,
+                    const callback_type &callback)
+{
+    run_async([this, call, params] { return del(call, params); }, callback);
+}
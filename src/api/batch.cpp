@@ -0,0 +1,115 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include "debug.hpp"
+#include "mastodon-cpp.hpp"
+
+using namespace Mastodon;
+
+const vector<return_call> API::get_batch(const vector<batch_call> &calls,
+                                         const std::size_t max_in_flight)
+{
+    vector<return_call> results(calls.size());
+
+    get_batch(calls,
+              [&results](const std::size_t index, const return_call &ret)
+              {
+                  results[index] = ret;
+              },
+              max_in_flight);
+
+    return results;
+}
+
+void API::get_batch(const vector<batch_call> &calls,
+                    const batch_callback_type &callback,
+                    const std::size_t max_in_flight)
+{
+    std::mutex mutex;           // Guards callback.
+
+    run_parallel(calls.size(), max_in_flight,
+                 [&](const std::size_t index)
+                 {
+                     const return_call ret = get(calls[index].first,
+                                                 calls[index].second);
+
+                     std::lock_guard<std::mutex> lock(mutex);
+                     callback(index, ret);
+                     return true;
+                 });
+}
+
+void API::run_parallel(
+    const std::size_t count, const std::size_t max_in_flight,
+    const std::function<bool(const std::size_t index)> &task)
+{
+    std::atomic<std::size_t> next(0);
+    std::mutex mutex;           // Guards exception.
+    std::exception_ptr exception;
+
+    // Every runner takes the next task until none are left.
+    auto runner = [&]
+    {
+        std::size_t index;
+        while ((index = next++) < count)
+        {
+            try
+            {
+                if (!task(index))
+                {
+                    next = count;
+                }
+            }
+            catch (const std::exception &)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    };
+
+    const std::size_t runners =
+        std::min(std::max<std::size_t>(max_in_flight, 1), count);
+    ttdebug << "Running " << count << " tasks with " << runners
+            << " runners.\n";
+
+    // The calling thread is one of the runners.
+    vector<std::thread> threads;
+    for (std::size_t i = 1; i < runners; ++i)
+    {
+        threads.emplace_back(runner);
+    }
+    runner();
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
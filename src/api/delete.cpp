@@ -17,12 +17,14 @@
 #include <iostream>
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "call_scope.hpp"
 
 using namespace Mastodon;
 
 return_call API::del(const Mastodon::API::v1 &call,
                      const parameters &params)
 {
+    const call_scope scope(call);
     string strcall = "";
     string strid = "";
 
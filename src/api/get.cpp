@@ -18,12 +18,14 @@
 #include <algorithm>
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "call_scope.hpp"
 
 using namespace Mastodon;
 
-const return_call API::get(const Mastodon::API::v1 &call,
-                           const parameters &params)
+return_call API::get(const Mastodon::API::v1 &call,
+                     const parameters &params)
 {
+    const call_scope scope(call);
     string strcall = "";
     string strid = "";
 
@@ -258,9 +260,10 @@ const return_call API::get(const Mastodon::API::v1 &call,
     return get(strcall);
 }
 
-const return_call API::get(const Mastodon::API::v2 &call,
-                           const parameters &params)
+return_call API::get(const Mastodon::API::v2 &call,
+                     const parameters &params)
 {
+    const call_scope scope(call);
     string strcall = "";
     string strid = "";
 
@@ -295,12 +298,27 @@ const return_call API::get(const Mastodon::API::v2 &call,
     return get(strcall);
 }
 
-const return_call API::get(const Mastodon::API::v1 &call)
+return_call API::get(const Mastodon::API::v1 &call)
 {
     return get(call, {});
 }
 
-const return_call API::get(const std::string &call)
+return_call API::get(const std::string &call)
 {
     return _http.request(http_method::GET, call);
 }
+
+return_call API::get(const std::string &call, const sink_type &sink)
+{
+    HTMLForm form;
+    return _http.request(http_method::GET, call, form, sink);
+}
+
+return_call API::get(const std::string &call, std::ostream &out)
+{
+    return get(call,
+               [&out](const char *data, const std::size_t size)
+               {
+                   out.write(data, static_cast<std::streamsize>(size));
+               });
+}
@@ -17,63 +17,162 @@
 #include <iostream>
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "stream_multiplexer.hpp"
 
 using namespace Mastodon;
 using std::cerr;
 using std::to_string;
 
+namespace
+{
+    // Returns the path of a streaming call, or "" if call is not one.
+    const string stream_path(const API::v1 &call)
+    {
+        switch (call)
+        {
+        case API::v1::streaming_user:
+        {
+            return "/api/v1/streaming/user";
+        }
+        case API::v1::streaming_public:
+        {
+            return "/api/v1/streaming/public";
+        }
+        case API::v1::streaming_public_local:
+        {
+            return "/api/v1/streaming/public/local";
+        }
+        case API::v1::streaming_hashtag:
+        {
+            return "/api/v1/streaming/hashtag";
+        }
+        case API::v1::streaming_hashtag_local:
+        {
+            return "/api/v1/streaming/hashtag/local";
+        }
+        case API::v1::streaming_list:
+        {
+            return "/api/v1/streaming/list";
+        }
+        case API::v1::streaming_direct:
+        {
+            return "/api/v1/streaming/direct";
+        }
+        default:
+        {
+            ttdebug << "ERROR: Invalid call.\n";
+            break;
+        }
+        }
+
+        return "";
+    }
+
+    // The error event for invalid calls.
+    const string invalid_call_data()
+    {
+        const uint8_t err = static_cast<uint8_t>(error::INVALID_ARGUMENT);
+        return "{\"error_code\":" + to_string(err) + "}";
+    }
+}
+
 void API::get_stream(const Mastodon::API::v1 &call,
                      const parameters &params,
                      std::unique_ptr<Mastodon::API::http> &ptr,
                      string &stream)
 {
-    string strcall = "";
-
-    switch (call)
+    string strcall = stream_path(call);
+    if (strcall.empty())
     {
-    case Mastodon::API::v1::streaming_user:
-    {
-        strcall = "/api/v1/streaming/user";
-        break;
-    }
-    case v1::streaming_public:
-    {
-        strcall = "/api/v1/streaming/public";
-        break;
+        stream = "event: ERROR\ndata: " + invalid_call_data() + "\n";
+        return;
     }
-    case v1::streaming_public_local:
+
+    if (params.size() > 0)
     {
-        strcall = "/api/v1/streaming/public/local";
-        break;
+        strcall += maptostr(params);
     }
-    case v1::streaming_hashtag:
+
+    return get_stream(strcall, ptr, stream);
+}
+
+void API::get_stream(const Mastodon::API::v1 &call,
+                     std::unique_ptr<Mastodon::API::http> &ptr,
+                     string &stream)
+{
+    return get_stream(call, {}, ptr, stream);
+}
+
+void API::get_stream(const std::string &call, std::unique_ptr<http> &ptr,
+                     string &stream)
+{
+    string access_token;
     {
-        strcall = "/api/v1/streaming/hashtag";
-        break;
+        std::lock_guard<std::mutex> lock(_settings_mutex);
+        access_token = _access_token;
     }
-    case v1::streaming_hashtag_local:
+
+    ptr = std::make_unique<http>(*this, _instance, access_token);
+    // Including the ones of scoped_timeouts in this thread.
+    ptr->set_timeouts(_http.get_timeouts());
+    return ptr->request_stream(call, stream);
+}
+
+void API::get_stream(const Mastodon::API::v1 &call,
+                     const parameters &params,
+                     std::unique_ptr<Mastodon::API::http> &ptr,
+                     const stream_callback_type &callback,
+                     const executor_type &executor)
+{
+    string strcall = stream_path(call);
+    if (strcall.empty())
     {
-        strcall = "/api/v1/streaming/hashtag/local";
-        break;
+        const string data = invalid_call_data();
+        callback({ "ERROR", 5, data.data(), data.size() });
+        return;
     }
-    case v1::streaming_list:
+
+    if (params.size() > 0)
     {
-        strcall = "/api/v1/streaming/list";
-        break;
+        strcall += maptostr(params);
     }
-    case v1::streaming_direct:
+
+    return get_stream(strcall, ptr, callback, executor);
+}
+
+void API::get_stream(const Mastodon::API::v1 &call,
+                     std::unique_ptr<Mastodon::API::http> &ptr,
+                     const stream_callback_type &callback,
+                     const executor_type &executor)
+{
+    return get_stream(call, {}, ptr, callback, executor);
+}
+
+void API::get_stream(const std::string &call, std::unique_ptr<http> &ptr,
+                     const stream_callback_type &callback,
+                     const executor_type &executor)
+{
+    string access_token;
     {
-        strcall = "/api/v1/streaming/direct";
-        break;
+        std::lock_guard<std::mutex> lock(_settings_mutex);
+        access_token = _access_token;
     }
-    default:
+
+    ptr = std::make_unique<http>(*this, _instance, access_token);
+    ptr->set_timeouts(_http.get_timeouts());
+    return ptr->request_stream(call, callback, executor);
+}
+
+std::uint64_t API::subscribe_stream(const Mastodon::API::v1 &call,
+                                    const parameters &params,
+                                    const stream_callback_type &callback)
+{
+    string strcall = stream_path(call);
+    if (strcall.empty())
     {
-        const uint8_t err = static_cast<uint8_t>(error::INVALID_ARGUMENT);
-        ttdebug << "ERROR: Invalid call.\n";
-        stream = "event: ERROR\ndata: "
-            "{\"error_code\":" + to_string(err) + "}\n";
-        return;
-    }
+        const string data = invalid_call_data();
+        callback({ "ERROR", 5, data.data(), data.size() });
+        return 0;
     }
 
     if (params.size() > 0)
@@ -81,19 +180,55 @@ void API::get_stream(const Mastodon::API::v1 &call,
         strcall += maptostr(params);
     }
 
-    return get_stream(strcall, ptr, stream);
+    return subscribe_stream(strcall, callback);
 }
 
-void API::get_stream(const Mastodon::API::v1 &call,
-                     std::unique_ptr<Mastodon::API::http> &ptr,
-                     string &stream)
+std::uint64_t API::subscribe_stream(const Mastodon::API::v1 &call,
+                                    const stream_callback_type &callback)
 {
-    return get_stream(call, {}, ptr, stream);
+    return subscribe_stream(call, {}, callback);
 }
 
-void API::get_stream(const std::string &call, std::unique_ptr<http> &ptr,
-                     string &stream)
+std::uint64_t API::subscribe_stream(const string &call,
+                                    const stream_callback_type &callback)
 {
-    ptr = std::make_unique<http>(*this, _instance, _access_token);
-    return ptr->request_stream(call, stream);
+    stream_connection connection;
+    return_call ret;
+
+    try
+    {
+        ret = _http.open_stream(call, connection);
+    }
+    catch (const std::exception &e)
+    {
+        ttdebug << "Exception while opening stream: " << e.what() << '\n';
+        ret = { error::UNKNOWN, e.what(), 0, "" };
+    }
+
+    if (!connection.session)
+    {                           // Report errors like get_stream() does.
+        if (ret.error_code == 0)
+        {
+            ret.error_code = static_cast<uint8_t>(error::UNKNOWN);
+        }
+        const string data = "{\"error_code\":" + to_string(ret.error_code)
+            + ",\"http_error\":" + to_string(ret.http_error_code) + "}";
+        callback({ "ERROR", 5, data.data(), data.size() });
+        return 0;
+    }
+
+    return get_multiplexer().add(std::move(connection), callback);
+}
+
+void API::unsubscribe_stream(const std::uint64_t id)
+{
+    {
+        std::lock_guard<std::mutex> lock(_multiplexer_mutex);
+        if (!_multiplexer)
+        {
+            return;
+        }
+    }
+
+    get_multiplexer().remove(id);
 }
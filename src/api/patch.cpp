@@ -17,6 +17,7 @@
 #include <iostream>
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "call_scope.hpp"
 
 using namespace Mastodon;
 using std::cerr;
@@ -24,6 +25,7 @@ using std::cerr;
 return_call API::patch(const Mastodon::API::v1 &call,
                        const parameters &params)
 {
+    const call_scope scope(call);
     string strcall = "";
     switch (call)
     {
@@ -0,0 +1,111 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef WITH_BROTLI
+
+#include <stdexcept>
+#include <string>
+#include "brotli_stream.hpp"
+
+using namespace Mastodon;
+using std::string;
+
+brotli_streambuf::brotli_streambuf(std::istream &source)
+: _source(source)
+, _state(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr))
+, _next_in(nullptr)
+, _avail_in(0)
+, _finished(false)
+{
+    if (_state == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+}
+
+brotli_streambuf::~brotli_streambuf()
+{
+    BrotliDecoderDestroyInstance(_state);
+}
+
+brotli_streambuf::int_type brotli_streambuf::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    while (!_finished)
+    {
+        if (_avail_in == 0)
+        {
+            _source.read(_in.data(), static_cast<std::streamsize>(_in.size()));
+            _avail_in = static_cast<std::size_t>(_source.gcount());
+            _next_in = reinterpret_cast<const std::uint8_t *>(_in.data());
+        }
+
+        std::size_t avail_out = _out.size();
+        std::uint8_t *next_out = reinterpret_cast<std::uint8_t *>(_out.data());
+        const BrotliDecoderResult result =
+            BrotliDecoderDecompressStream(_state, &_avail_in, &_next_in,
+                                          &avail_out, &next_out, nullptr);
+        const std::size_t produced = _out.size() - avail_out;
+
+        switch (result)
+        {
+        case BROTLI_DECODER_RESULT_ERROR:
+        {
+            throw std::runtime_error(
+                string("Brotli decoder error: ")
+                + BrotliDecoderErrorString(BrotliDecoderGetErrorCode(_state)));
+        }
+        case BROTLI_DECODER_RESULT_SUCCESS:
+        {
+            _finished = true;
+            break;
+        }
+        case BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT:
+        {
+            if (_avail_in == 0 && !_source.good())
+            {
+                throw std::runtime_error("Brotli stream is truncated");
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+
+        if (produced > 0)
+        {
+            setg(_out.data(), _out.data(), _out.data() + produced);
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+
+    return traits_type::eof();
+}
+
+brotli_input_stream::brotli_input_stream(std::istream &source)
+: std::istream(nullptr)
+, _buf(source)
+{
+    rdbuf(&_buf);
+}
+
+#endif  // WITH_BROTLI
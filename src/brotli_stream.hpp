@@ -0,0 +1,77 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_BROTLI_STREAM_HPP
+#define MASTODON_CPP_BROTLI_STREAM_HPP
+
+#ifdef WITH_BROTLI
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <istream>
+#include <streambuf>
+#include <brotli/decode.h>
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Stream buffer that decompresses brotli-compressed data read
+     *          from another stream.
+     *
+     *  @since  0.112.0
+     */
+    class brotli_streambuf : public std::streambuf
+    {
+    public:
+        explicit brotli_streambuf(std::istream &source);
+        ~brotli_streambuf();
+
+        brotli_streambuf(const brotli_streambuf &) = delete;
+        brotli_streambuf &operator=(const brotli_streambuf &) = delete;
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        std::istream &_source;
+        BrotliDecoderState *_state;
+        std::array<char, 8192> _in;
+        std::array<char, 8192> _out;
+        const std::uint8_t *_next_in;
+        std::size_t _avail_in;
+        bool _finished;
+    };
+
+    /*!
+     *  @brief  Input stream that decompresses brotli-compressed data read
+     *          from another stream. Like Poco::InflatingInputStream.
+     *
+     *  @since  0.112.0
+     */
+    class brotli_input_stream : public std::istream
+    {
+    public:
+        explicit brotli_input_stream(std::istream &source);
+
+    private:
+        brotli_streambuf _buf;
+    };
+}
+
+#endif  // WITH_BROTLI
+
+#endif  // MASTODON_CPP_BROTLI_STREAM_HPP
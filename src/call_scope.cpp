@@ -0,0 +1,56 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "call_scope.hpp"
+
+using namespace Mastodon;
+
+thread_local const call_scope *call_scope::_current = nullptr;
+
+call_scope::call_scope(const API::v1 call)
+: _previous(_current)
+, _version(1)
+, _v1(call)
+, _v2()
+{
+    _current = this;
+}
+
+call_scope::call_scope(const API::v2 call)
+: _previous(_current)
+, _version(2)
+, _v1()
+, _v2(call)
+{
+    _current = this;
+}
+
+call_scope::~call_scope()
+{
+    _current = _previous;
+}
+
+void call_scope::apply(request_record &record)
+{
+    if (_current == nullptr)
+    {
+        return;
+    }
+
+    record.api_version = _current->_version;
+    record.call_v1 = _current->_v1;
+    record.call_v2 = _current->_v2;
+}
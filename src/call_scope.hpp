@@ -0,0 +1,60 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_CALL_SCOPE_HPP
+#define MASTODON_CPP_CALL_SCOPE_HPP
+
+#include <cstdint>
+#include "mastodon-cpp.hpp"
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Remembers which API call the calling thread makes, so that
+     *          the request_record can name it.
+     *
+     *          Nested scopes hide the outer scope until they are
+     *          destroyed.
+     *
+     *  @since  0.112.0
+     */
+    class call_scope
+    {
+    public:
+        explicit call_scope(const API::v1 call);
+        explicit call_scope(const API::v2 call);
+        ~call_scope();
+
+        call_scope(const call_scope &) = delete;
+        call_scope &operator=(const call_scope &) = delete;
+
+        /*!
+         *  @brief  Set the call of the current scope in record. Does
+         *          nothing outside of a scope.
+         */
+        static void apply(request_record &record);
+
+    private:
+        const call_scope *const _previous;
+        const std::uint8_t _version;
+        const API::v1 _v1;
+        const API::v2 _v2;
+
+        static thread_local const call_scope *_current;
+    };
+}
+
+#endif  // MASTODON_CPP_CALL_SCOPE_HPP
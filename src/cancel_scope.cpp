@@ -0,0 +1,52 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cancel_scope.hpp"
+
+using namespace Mastodon;
+
+thread_local const cancel_scope *cancel_scope::_current = nullptr;
+
+cancel_scope::cancel_scope(const std::atomic<bool> &cancelled)
+: _previous(_current)
+, _cancelled(cancelled)
+{
+    _current = this;
+}
+
+cancel_scope::~cancel_scope()
+{
+    _current = _previous;
+}
+
+bool cancel_scope::active()
+{
+    return (_current != nullptr);
+}
+
+bool cancel_scope::cancelled()
+{
+    for (const cancel_scope *scope = _current; scope != nullptr;
+         scope = scope->_previous)
+    {
+        if (scope->_cancelled)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
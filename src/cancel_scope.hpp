@@ -0,0 +1,64 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_CANCEL_SCOPE_HPP
+#define MASTODON_CPP_CANCEL_SCOPE_HPP
+
+#include <atomic>
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Lets another thread cancel the requests the calling thread
+     *          makes.
+     *
+     *          A cancelled request stops sending its body and fails. Nested
+     *          scopes are cancelled if any of them is.
+     *
+     *  @since  0.112.0
+     */
+    class cancel_scope
+    {
+    public:
+        /*!
+         *  @param  cancelled  Set to true to cancel. Must outlive the
+         *                     scope.
+         */
+        explicit cancel_scope(const std::atomic<bool> &cancelled);
+        ~cancel_scope();
+
+        cancel_scope(const cancel_scope &) = delete;
+        cancel_scope &operator=(const cancel_scope &) = delete;
+
+        /*!
+         *  @brief  True if the calling thread is in a scope.
+         */
+        static bool active();
+
+        /*!
+         *  @brief  True if a scope of the calling thread was cancelled.
+         */
+        static bool cancelled();
+
+    private:
+        const cancel_scope *const _previous;
+        const std::atomic<bool> &_cancelled;
+
+        static thread_local const cancel_scope *_current;
+    };
+}
+
+#endif  // MASTODON_CPP_CANCEL_SCOPE_HPP
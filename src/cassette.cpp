@@ -0,0 +1,254 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <thread>
+#include <exception>
+#include "debug.hpp"
+#include "cassette.hpp"
+
+using namespace Mastodon;
+using std::chrono::microseconds;
+
+namespace
+{
+    const string magic = "mastodon-cpp cassette 1";
+}
+
+cassette::cassette()
+{}
+
+bool cassette::set_config(const cassette_config &config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _config = cassette_config();
+    _out.close();
+    _tracks.clear();
+
+    switch (config.mode)
+    {
+    case cassette_mode::RECORD:
+    {
+        bool empty;
+        {
+            std::ifstream in(config.file);
+            empty = (!in.good()
+                     || in.peek() == std::ifstream::traits_type::eof());
+        }
+
+        _out.open(config.file, std::ios::app | std::ios::binary);
+        if (!_out.good())
+        {
+            ttdebug << "Could not open cassette: " << config.file << '\n';
+            _out.close();
+            return false;
+        }
+        if (empty)
+        {
+            _out << magic << '\n';
+        }
+        break;
+    }
+    case cassette_mode::REPLAY:
+    {
+        if (!load(config.file))
+        {
+            ttdebug << "Could not read cassette: " << config.file << '\n';
+            _tracks.clear();
+            return false;
+        }
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+
+    _config = config;
+    return true;
+}
+
+cassette_mode cassette::get_mode() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config.mode;
+}
+
+void cassette::record(const http_method &meth, const string &path,
+                      const return_call &ret, const string &body,
+                      const microseconds duration)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_config.mode != cassette_mode::RECORD)
+    {
+        return;
+    }
+
+    _out << make_key(meth, path) << '\n'
+         << static_cast<unsigned>(ret.error_code) << ' '
+         << ret.http_error_code << ' '
+         << duration.count() << ' '
+         << ret.headers.size() << ' '
+         << ret.error_message.size() << ' '
+         << body.size() << '\n';
+    for (const auto &header : ret.headers)
+    {
+        _out << header.first << ": " << header.second << '\n';
+    }
+    _out << ret.error_message << body << '\n';
+
+    // Keep what we have if the program crashes.
+    _out.flush();
+}
+
+return_call cassette::replay(const http_method &meth, const string &path,
+                             const sink_type &sink)
+{
+    entry played;
+    bool keep_timing;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _tracks.find(make_key(meth, path));
+        if (it == _tracks.end())
+        {
+            ttdebug << "Not in cassette: " << make_key(meth, path) << '\n';
+            return { error::CONNECTION_REFUSED,
+                     "Request was not recorded", 0, "" };
+        }
+
+        track &played_track = it->second;
+        played = played_track.entries[played_track.next];
+        played_track.next = (played_track.next + 1)
+            % played_track.entries.size();
+        keep_timing = _config.keep_timing;
+    }
+
+    if (keep_timing)
+    {
+        std::this_thread::sleep_for(played.duration);
+    }
+
+    return_call &ret = played.ret;
+    if (sink && ret.http_error_code / 100 == 2)
+    {
+        sink(ret.answer.data(), ret.answer.size());
+        ret.answer.clear();
+    }
+
+    return ret;
+}
+
+const string cassette::make_key(const http_method &meth, const string &path)
+{
+    switch (meth)
+    {
+    case http_method::GET:
+    {
+        return "GET " + path;
+    }
+    case http_method::PATCH:
+    {
+        return "PATCH " + path;
+    }
+    case http_method::POST:
+    {
+        return "POST " + path;
+    }
+    case http_method::PUT:
+    {
+        return "PUT " + path;
+    }
+    case http_method::DELETE:
+    {
+        return "DELETE " + path;
+    }
+    default:
+    {
+        return "STREAM " + path;
+    }
+    }
+}
+
+bool cassette::load(const string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    string line;
+    if (!std::getline(in, line) || line != magic)
+    {
+        return false;
+    }
+
+    string key;
+    while (std::getline(in, key))
+    {
+        if (key.empty())
+        {
+            continue;
+        }
+
+        unsigned error_code;
+        std::size_t headers;
+        std::size_t message_size;
+        std::size_t body_size;
+        long long duration;
+        entry recorded;
+
+        if (!std::getline(in, line))
+        {
+            return false;
+        }
+        std::istringstream sizes(line);
+        if (!(sizes >> error_code >> recorded.ret.http_error_code
+              >> duration >> headers >> message_size >> body_size))
+        {
+            return false;
+        }
+        recorded.ret.error_code = static_cast<uint8_t>(error_code);
+        recorded.duration = microseconds(duration);
+
+        for (std::size_t i = 0; i < headers; ++i)
+        {
+            if (!std::getline(in, line))
+            {
+                return false;
+            }
+            const std::size_t pos = line.find(": ");
+            if (pos == string::npos)
+            {
+                return false;
+            }
+            recorded.ret.headers.emplace(line.substr(0, pos),
+                                         line.substr(pos + 2));
+        }
+
+        recorded.ret.error_message.resize(message_size);
+        recorded.ret.answer.resize(body_size);
+        in.read(&recorded.ret.error_message[0],
+                static_cast<std::streamsize>(message_size));
+        in.read(&recorded.ret.answer[0],
+                static_cast<std::streamsize>(body_size));
+        if (!in.good())
+        {
+            return false;
+        }
+
+        _tracks[key].entries.push_back(std::move(recorded));
+    }
+
+    ttdebug << "Loaded " << _tracks.size() << " requests from cassette.\n";
+    return true;
+}
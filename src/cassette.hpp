@@ -0,0 +1,132 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_CASSETTE_HPP
+#define MASTODON_CPP_CASSETTE_HPP
+
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <functional>
+
+#include "types.hpp"
+#include "return_types.hpp"
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Records requests to a file and replays them. Used by
+     *          API::http.
+     *
+     *          The file starts with the line `mastodon-cpp cassette 1`,
+     *          followed by one entry per request:
+     *
+     *          @code
+     *          <method> <path>
+     *          <error> <status> <µs> <headers> <message size> <body size>
+     *          <name>: <value>
+     *          [...]
+     *          <error message><body>
+     *          @endcode
+     *
+     *          The sizes are in bytes, the body is followed by a newline.
+     *
+     *  @since  0.112.0
+     */
+    class cassette
+    {
+    public:
+        using sink_type = std::function<void(const char *data,
+                                             const std::size_t size)>;
+
+        cassette();
+
+        /*!
+         *  @brief  Set the mode and open the file.
+         *
+         *          RECORD appends to the file, REPLAY reads all entries.
+         *
+         *  @return false if the file could not be opened or parsed. The
+         *          cassette is switched off then.
+         */
+        bool set_config(const cassette_config &config);
+
+        /*!
+         *  @brief  Returns the mode.
+         */
+        cassette_mode get_mode() const;
+
+        /*!
+         *  @brief  Append a request and its answer to the file.
+         *
+         *  @param  meth      The HTTP method.
+         *  @param  path      The path, including the query string.
+         *  @param  ret       The answer.
+         *  @param  body      The body of the answer.
+         *  @param  duration  How long the request took.
+         */
+        void record(const http_method &meth, const string &path,
+                    const return_call &ret, const string &body,
+                    const std::chrono::microseconds duration);
+
+        /*!
+         *  @brief  Returns the next recorded answer to a request.
+         *
+         *  @param  meth  The HTTP method.
+         *  @param  path  The path, including the query string.
+         *  @param  sink  Receives the body of successful answers instead of
+         *                return_call::answer, if set.
+         */
+        return_call replay(const http_method &meth, const string &path,
+                           const sink_type &sink);
+
+    private:
+        typedef struct entry
+        {
+            return_call ret;
+            std::chrono::microseconds duration;
+        } entry;
+
+        typedef struct track
+        {
+            std::vector<entry> entries;
+            std::size_t next = 0;
+        } track;
+
+        cassette_config _config;
+        std::ofstream _out;
+        std::map<string, track> _tracks;
+        mutable std::mutex _mutex;
+
+        /*!
+         *  @brief  Returns "<method> <path>".
+         */
+        static const string make_key(const http_method &meth,
+                                     const string &path);
+
+        /*!
+         *  @brief  Read all entries from file into _tracks.
+         */
+        bool load(const string &file);
+    };
+}
+
+#endif  // MASTODON_CPP_CASSETTE_HPP
@@ -0,0 +1,278 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <utility>
+#include <Poco/Net/Socket.h>
+#include <Poco/Timespan.h>
+#include <Poco/Exception.h>
+#include <Poco/Net/NetException.h>
+#include <Poco/Net/SSLException.h>
+#include "debug.hpp"
+#include "connection_pool.hpp"
+
+using namespace Mastodon;
+using std::move;
+using std::chrono::steady_clock;
+using Poco::Net::Socket;
+
+connection_pool::lease::lease(connection_pool &pool, const string &host,
+                              session_ptr session)
+: _pool(&pool)
+, _host(host)
+, _session(move(session))
+, _reused(static_cast<bool>(_session))
+, _keep_alive(false)
+{}
+
+connection_pool::lease::lease(lease &&other)
+: _pool(other._pool)
+, _host(move(other._host))
+, _session(move(other._session))
+, _reused(other._reused)
+, _keep_alive(other._keep_alive)
+{
+    other._pool = nullptr;
+}
+
+connection_pool::lease::~lease()
+{
+    if (_pool != nullptr)
+    {
+        _pool->release(_host, move(_session), _keep_alive);
+    }
+}
+
+HTTPClientSession &connection_pool::lease::session()
+{
+    if (!_session)
+    {
+        renew();
+    }
+
+    return *_session;
+}
+
+bool connection_pool::lease::reused() const
+{
+    return _reused;
+}
+
+void connection_pool::lease::renew()
+{
+    _session.reset();
+    _reused = false;
+    _session = _pool->_factory(_host);
+}
+
+void connection_pool::lease::keep_alive(const bool value)
+{
+    _keep_alive = value;
+}
+
+connection_pool::connection_pool(const factory_type &factory)
+: _factory(factory)
+{}
+
+connection_pool::~connection_pool()
+{
+    clear();
+}
+
+void connection_pool::set_config(const connection_pool_config &config)
+{
+    std::vector<session_ptr> garbage;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _config = config;
+
+        for (auto &host : _hosts)
+        {
+            std::deque<idle_session> &idle = host.second.idle;
+            while (idle.size() > _config.max_idle)
+            {
+                garbage.push_back(move(idle.front().session));
+                idle.pop_front();
+            }
+        }
+    }
+
+    // Waiting requests may proceed if max_per_host was raised.
+    _cv.notify_all();
+}
+
+const connection_pool_config connection_pool::get_config() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config;
+}
+
+connection_pool::lease connection_pool::acquire(const string &host)
+{
+    // Closing a session may block, so we collect them and close them after
+    // the lock is released.
+    std::vector<session_ptr> garbage;
+    std::unique_lock<std::mutex> lock(_mutex);
+    host_entry &entry = _hosts[host];
+
+    _cv.wait(lock, [this, &entry]
+             {
+                 return (_config.max_per_host == 0
+                         || entry.active < _config.max_per_host);
+             });
+    ++entry.active;
+
+    const auto now = steady_clock::now();
+    while (!entry.idle.empty())
+    {
+        // Take the most recently used session, it is the least likely to be
+        // closed by the server.
+        idle_session idle = move(entry.idle.back());
+        entry.idle.pop_back();
+
+        if (now - idle.since < _config.idle_timeout
+            && is_alive(*idle.session))
+        {
+            ttdebug << "Reusing connection to " << host << ".\n";
+            lock.unlock();
+            return lease(*this, host, move(idle.session));
+        }
+
+        ttdebug << "Discarding stale connection to " << host << ".\n";
+        garbage.push_back(move(idle.session));
+    }
+    lock.unlock();
+
+    // The session is created on first use, so that the slot is given back if
+    // the factory throws.
+    return lease(*this, host, nullptr);
+}
+
+void connection_pool::clear()
+{
+    std::vector<session_ptr> garbage;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &host : _hosts)
+    {
+        for (idle_session &idle : host.second.idle)
+        {
+            garbage.push_back(move(idle.session));
+        }
+        host.second.idle.clear();
+    }
+}
+
+void connection_pool::release(const string &host, session_ptr session,
+                              const bool keep)
+{
+    std::vector<session_ptr> garbage;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        host_entry &entry = _hosts[host];
+        const auto now = steady_clock::now();
+
+        --entry.active;
+
+        // Drop expired sessions, the oldest are at the front.
+        while (!entry.idle.empty()
+               && now - entry.idle.front().since >= _config.idle_timeout)
+        {
+            garbage.push_back(move(entry.idle.front().session));
+            entry.idle.pop_front();
+        }
+
+        if (keep && session && _config.max_idle > 0)
+        {
+            entry.idle.push_back({ move(session), now });
+            while (entry.idle.size() > _config.max_idle)
+            {
+                garbage.push_back(move(entry.idle.front().session));
+                entry.idle.pop_front();
+            }
+        }
+    }
+
+    _cv.notify_all();
+}
+
+bool connection_pool::is_alive(HTTPClientSession &session)
+{
+    try
+    {
+        return (session.connected()
+                && !session.socket().poll(Poco::Timespan(0),
+                                          Socket::SELECT_READ));
+    }
+    catch (const Poco::Exception &)
+    {
+        return false;
+    }
+}
+
+bool connection_pool::is_reusable(const HTTPResponse &response)
+{
+    if (!response.getKeepAlive())
+    {
+        return false;
+    }
+
+    // Without length or chunked encoding, the body ends when the connection
+    // is closed.
+    switch (response.getStatus())
+    {
+    case HTTPResponse::HTTP_NO_CONTENT:
+    case HTTPResponse::HTTP_NOT_MODIFIED:
+    {
+        return true;
+    }
+    default:
+    {
+        return (response.hasContentLength()
+                || response.getChunkedTransferEncoding());
+    }
+    }
+}
+
+bool connection_pool::is_closed_connection(const Poco::Exception &e)
+{
+    using namespace Poco::Net;
+
+    return (dynamic_cast<const NoMessageException *>(&e) != nullptr
+            || dynamic_cast<const ConnectionResetException *>(&e) != nullptr
+            || dynamic_cast<const ConnectionAbortedException *>(&e) != nullptr
+            || dynamic_cast<const SSLConnectionUnexpectedlyClosedException *>
+               (&e) != nullptr);
+}
+
+bool connection_pool::is_idempotent(const http_method &meth)
+{
+    switch (meth)
+    {
+    case http_method::GET:
+    case http_method::PUT:
+    case http_method::DELETE:
+    {
+        return true;
+    }
+    default:
+    {
+        return false;
+    }
+    }
+}
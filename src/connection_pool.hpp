@@ -0,0 +1,191 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_CONNECTION_POOL_HPP
+#define MASTODON_CPP_CONNECTION_POOL_HPP
+
+#include <string>
+#include <memory>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Exception.h>
+
+#include "types.hpp"
+
+using std::string;
+using std::unique_ptr;
+using Poco::Net::HTTPClientSession;
+using Poco::Net::HTTPResponse;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Pool of keep-alive sessions, grouped by host. Used by
+     *          API::http.
+     *
+     *  @since  0.112.0
+     */
+    class connection_pool
+    {
+    public:
+        using session_ptr = unique_ptr<HTTPClientSession>;
+        using factory_type = std::function<session_ptr(const string &host)>;
+
+        /*!
+         *  @brief  A session checked out of the pool.
+         *
+         *          The session is returned to the pool when the lease is
+         *          destroyed. It is only kept if keep_alive() was set.
+         *
+         *  @since  0.112.0
+         */
+        class lease
+        {
+        public:
+            lease(lease &&other);
+            lease(const lease &) = delete;
+            lease &operator=(const lease &) = delete;
+            ~lease();
+
+            /*!
+             *  @brief  The session.
+             */
+            HTTPClientSession &session();
+
+            /*!
+             *  @brief  true if the session was used before.
+             */
+            bool reused() const;
+
+            /*!
+             *  @brief  Discard the session and open a new one.
+             *
+             *          The slot in the pool is kept.
+             */
+            void renew();
+
+            /*!
+             *  @brief  Keep the session open for reuse after the lease ends.
+             */
+            void keep_alive(const bool value);
+
+        private:
+            friend class connection_pool;
+
+            lease(connection_pool &pool, const string &host,
+                  session_ptr session);
+
+            connection_pool *_pool;
+            string _host;
+            session_ptr _session;
+            bool _reused;
+            bool _keep_alive;
+        };
+
+        /*!
+         *  @brief  Constructs a new pool.
+         *
+         *  @param  factory Called to open a new session to a host.
+         */
+        explicit connection_pool(const factory_type &factory);
+        ~connection_pool();
+
+        /*!
+         *  @brief  Set the pool settings.
+         *
+         *          Surplus idle sessions are closed.
+         */
+        void set_config(const connection_pool_config &config);
+
+        /*!
+         *  @brief  Returns the current pool settings.
+         */
+        const connection_pool_config get_config() const;
+
+        /*!
+         *  @brief  Check out a session to host.
+         *
+         *          Idle sessions are reused if they are still open, otherwise
+         *          a new one is created. Blocks if
+         *          connection_pool_config::max_per_host is reached.
+         */
+        lease acquire(const string &host);
+
+        /*!
+         *  @brief  Close all idle sessions.
+         */
+        void clear();
+
+        /*!
+         *  @brief  Returns true if the connection can be used again after
+         *          the whole body of response was read.
+         */
+        static bool is_reusable(const HTTPResponse &response);
+
+        /*!
+         *  @brief  Returns true if the exception means that the server
+         *          closed the connection before sending a response.
+         */
+        static bool is_closed_connection(const Poco::Exception &e);
+
+        /*!
+         *  @brief  Returns true if the request can safely be sent twice.
+         *
+         *          See RFC 7231, section 4.2.2. The body is not considered,
+         *          a request with an upload can't be sent twice.
+         */
+        static bool is_idempotent(const http_method &meth);
+
+    private:
+        typedef struct idle_session
+        {
+            session_ptr session;
+            std::chrono::steady_clock::time_point since;
+        } idle_session;
+
+        typedef struct host_entry
+        {
+            std::deque<idle_session> idle;
+            std::size_t active = 0;
+        } host_entry;
+
+        const factory_type _factory;
+        connection_pool_config _config;
+        mutable std::mutex _mutex;
+        std::condition_variable _cv;
+        std::map<string, host_entry> _hosts;
+
+        void release(const string &host, session_ptr session,
+                     const bool keep);
+
+        /*!
+         *  @brief  Returns false if the server has closed the session.
+         *
+         *          An idle keep-alive connection has nothing to read. If the
+         *          socket is readable, the server has sent EOF, a reset or
+         *          data we did not ask for.
+         */
+        static bool is_alive(HTTPClientSession &session);
+    };
+}
+
+#endif  // MASTODON_CPP_CONNECTION_POOL_HPP
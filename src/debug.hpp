@@ -17,13 +17,15 @@
 #ifndef MACROS_HPP
 #define MACROS_HPP
 
-#include <iostream>
+#include "log.hpp"
 
-#ifdef DEBUG
-    #define ttdebug \
-            std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] DEBUG: "
-#else
-    #define ttdebug false && std::cerr
-#endif
+// Logs a message if level is enabled, the message is not evaluated
+// otherwise. Example: ttlog(WARNING) << "Something happened.\n";
+#define ttlog(level)                                                    \
+    if (!Mastodon::log_line::enabled(Mastodon::log_level::level)) {}    \
+    else Mastodon::log_line(Mastodon::log_level::level, __FILE__, __LINE__)
+
+// Traces what the library does.
+#define ttdebug ttlog(TRACE)
 
 #endif // MACROS_HPP
@@ -18,6 +18,7 @@
 #define MASTODON_CPP_EASY_ALL_HPP
 
 #include "easy.hpp"
+#include "managed_stream.hpp"
 #include "entities/account.hpp"
 #include "entities/application.hpp"
 #include "entities/attachment.hpp"
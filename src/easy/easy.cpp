@@ -20,6 +20,7 @@
 #include <regex>
 #include <algorithm>
 #include "easy.hpp"
+#include "sse_parser.hpp"
 #include "debug.hpp"
 
 using namespace Mastodon;
@@ -52,36 +53,37 @@ const std::vector<string> Easy::json_array_to_vector(const string &json)
 const vector<Easy::stream_event_type> Easy::parse_stream(
     const std::string &streamdata)
 {
-    string stream = streamdata;
-    std::regex reevent("event: (update|notification|delete|filters_changed"
-                       "|ERROR)\ndata: (.*)\n");
-    std::smatch match;
     std::vector<stream_event_type> vec = {};
 
-    while (std::regex_search(stream, match, reevent))
-    {
-        const string &event = match[1].str();
-        const string &data = match[2].str();
-        event_type type = event_type::Undefined;
-
-        if (event == "update")
-            type = event_type::Update;
-        else if (event == "notification")
-            type = event_type::Notification;
-        else if (event == "delete")
-            type = event_type::Delete;
-        else if (event == "ERROR")
-            type = event_type::Error;
-        else if (event == "filters_changed")
-            type = event_type::Filters_changed;
-
-        vec.push_back({ type, data });
-        stream = match.suffix().str();
-    }
+    sse_parser parser(
+        [&vec](const sse_event &event)
+        {
+            vec.push_back({ get_event_type(event), event.get_data() });
+        });
+
+    // The data may end before the empty line after the last event.
+    parser.feed(streamdata);
+    parser.finish();
 
     return vec;
 }
 
+Easy::event_type Easy::get_event_type(const sse_event &event)
+{
+    if (event.is("update"))
+        return event_type::Update;
+    else if (event.is("notification"))
+        return event_type::Notification;
+    else if (event.is("delete"))
+        return event_type::Delete;
+    else if (event.is("ERROR"))
+        return event_type::Error;
+    else if (event.is("filters_changed"))
+        return event_type::Filters_changed;
+
+    return event_type::Undefined;
+}
+
 const Easy::time_type Easy::string_to_time(const string &strtime)
 {
     std::stringstream sstime(strtime);
@@ -115,6 +115,11 @@ namespace Easy
     /*!
      *  @brief  Split stream into a vector of events
      *
+     *          Events with unknown names have the type
+     *          event_type::Undefined. If you read the stream in pieces,
+     *          use a Mastodon::sse_parser, it keeps events that are split
+     *          between pieces.
+     *
      *  @param  streamdata  Data from get_stream()
      *
      *  @return vector of Easy::stream_event
@@ -123,6 +128,15 @@ namespace Easy
      */
     const vector<stream_event_type> parse_stream(const std::string &streamdata);
 
+    /*!
+     *  @brief  Returns the type of an event of a stream.
+     *
+     *          For the callbacks of Mastodon::API::get_stream().
+     *
+     *  @since  0.112.0
+     */
+    event_type get_event_type(const sse_event &event);
+
     /*!
      *  @brief Convert ISO 8601 time string to Easy::time.
      *
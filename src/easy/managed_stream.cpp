@@ -0,0 +1,475 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <random>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <exception>
+#include <jsoncpp/json/json.h>
+#include "managed_stream.hpp"
+#include "debug.hpp"
+
+using namespace Mastodon;
+using std::chrono::milliseconds;
+
+namespace
+{
+    // Number of events that are remembered to skip duplicates.
+    const std::size_t seen_size = 1000;
+    // Maximum number of entries of timelines.
+    const Json::ArrayIndex page_size = 40;
+
+    // The stream whose callback runs in this thread.
+    thread_local const Easy::managed_stream *delivering = nullptr;
+
+    // IDs are sorted by length first, numeric IDs may have different
+    // lengths.
+    bool is_newer(const string &id, const string &than)
+    {
+        if (id.size() != than.size())
+        {
+            return id.size() > than.size();
+        }
+        return id > than;
+    }
+
+    bool parse(const string &json, Json::Value &value)
+    {
+        Json::CharReaderBuilder builder;
+        std::istringstream stream(json);
+        string errors;
+        return Json::parseFromStream(builder, stream, &value, &errors);
+    }
+
+    // Returns the ID of the status or notification in event.
+    const string get_id(const sse_event &event)
+    {
+        // Mastodon sends the ID first, avoid parsing the whole status.
+        static const char prefix[] = "{\"id\":\"";
+        const std::size_t prefix_size = sizeof(prefix) - 1;
+        if (event.data_size > prefix_size
+            && std::memcmp(event.data, prefix, prefix_size) == 0)
+        {
+            const char *begin = event.data + prefix_size;
+            const char *end = std::find(begin, event.data + event.data_size,
+                                        '"');
+            if (end != event.data + event.data_size)
+            {
+                return string(begin, end);
+            }
+        }
+
+        Json::Value value;
+        if (parse(event.get_data(), value) && value.isObject())
+        {
+            return value["id"].asString();
+        }
+        return "";
+    }
+}
+
+Easy::managed_stream::managed_stream(
+    Mastodon::API &api, const Mastodon::API::v1 &call,
+    const parameters &params,
+    const Mastodon::API::stream_callback_type &callback,
+    const reconnect_config &config)
+: _api(api)
+, _call(call)
+, _params(params)
+, _callback(callback)
+, _config(config)
+, _cancelled(false)
+, _ended(false)
+, _received(false)
+, _backfilling(false)
+, _reconnects(0)
+{
+    using v1 = Mastodon::API::v1;
+
+    parameters local = {{ "local", { "true" }}};
+    parameters tag;
+    auto it = params.find("tag");
+    if (it != params.end())
+    {
+        tag.push_back({ "tag", it->values });
+    }
+
+    switch (call)
+    {
+    case v1::streaming_user:
+    {
+        _sources.push_back({ v1::timelines_home, {}, "update" });
+        _sources.push_back({ v1::notifications, {}, "notification" });
+        break;
+    }
+    case v1::streaming_public:
+    {
+        _sources.push_back({ v1::timelines_public, {}, "update" });
+        break;
+    }
+    case v1::streaming_public_local:
+    {
+        _sources.push_back({ v1::timelines_public, local, "update" });
+        break;
+    }
+    case v1::streaming_hashtag:
+    {
+        _sources.push_back({ v1::timelines_tag_hashtag, tag, "update" });
+        break;
+    }
+    case v1::streaming_hashtag_local:
+    {
+        tag.push_back(local.front());
+        _sources.push_back({ v1::timelines_tag_hashtag, tag, "update" });
+        break;
+    }
+    case v1::streaming_list:
+    {
+        it = params.find("list");
+        if (it != params.end())
+        {
+            _sources.push_back({ v1::timelines_list_list_id,
+                                 {{ "id", it->values }}, "update" });
+        }
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+
+    _thread = std::thread(&managed_stream::run, this);
+}
+
+Easy::managed_stream::~managed_stream()
+{
+    cancel();
+}
+
+void Easy::managed_stream::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cancelled = true;
+    }
+    _cv.notify_all();
+
+    if (delivering == this)
+    {                           // The thread would wait for itself.
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_http_mutex);
+        if (_http)
+        {
+            _http->cancel_stream();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_thread_mutex);
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+std::uint32_t Easy::managed_stream::reconnects() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _reconnects;
+}
+
+void Easy::managed_stream::run()
+{
+    std::uint32_t attempt = 0;
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+
+    while (true)
+    {
+        bool backfill;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_cancelled)
+            {
+                return;
+            }
+            _ended = false;
+            _received = false;
+            _error.clear();
+            backfill = (_reconnects > 0 && _config.backfill_pages > 0
+                        && !_sources.empty());
+            _backfilling = backfill;
+        }
+
+        {
+            unique_ptr<Mastodon::API::http> http;
+            _api.get_stream(_call, _params, http,
+                            [this](const sse_event &event)
+                            {
+                                on_event(event);
+                            });
+            std::lock_guard<std::mutex> lock(_http_mutex);
+            _http = std::move(http);
+        }
+
+        if (backfill)
+        {
+            try
+            {
+                this->backfill();
+            }
+            catch (const std::exception &e)
+            {
+                ttlog(WARNING) << "Exception while backfilling stream: "
+                               << e.what() << '\n';
+            }
+
+            // Pass on the events that arrived in the meantime.
+            while (true)
+            {
+                vector<std::pair<string, string>> buffer;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_buffer.empty())
+                    {
+                        _backfilling = false;
+                        break;
+                    }
+                    buffer.swap(_buffer);
+                }
+
+                for (const auto &event : buffer)
+                {
+                    deliver({ event.first.data(), event.first.size(),
+                              event.second.data(), event.second.size() });
+                }
+            }
+        }
+
+        string error;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return (_ended || _cancelled); });
+            if (_received)
+            {
+                attempt = 0;
+            }
+            error = _error;
+        }
+
+        {
+            // Destroyed outside of the lock, the destructor waits for the
+            // thread of the connection.
+            unique_ptr<Mastodon::API::http> http;
+            {
+                std::lock_guard<std::mutex> lock(_http_mutex);
+                http = std::move(_http);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_cancelled)
+        {
+            return;
+        }
+
+        if (is_permanent(error))
+        {
+            lock.unlock();
+            ttlog(WARNING) << "Stream failed: " << error << '\n';
+            deliver({ "ERROR", 5, error.data(), error.size() });
+            return;
+        }
+
+        // min(max_delay, base_delay * 2^attempt)
+        milliseconds ceiling = std::min(_config.base_delay, _config.max_delay);
+        for (std::uint32_t i = 0; i < attempt && ceiling < _config.max_delay;
+             ++i)
+        {
+            ceiling = std::min(ceiling * 2, _config.max_delay);
+        }
+        std::uniform_int_distribution<milliseconds::rep>
+            distribution(0, std::max<milliseconds::rep>(ceiling.count(), 0));
+        const milliseconds delay(distribution(engine));
+
+        ++attempt;
+        ++_reconnects;
+        ttlog(INFO) << "Stream ended (" << error << "), reconnecting in "
+                    << delay.count() << " ms.\n";
+        _cv.wait_for(lock, delay, [this] { return _cancelled; });
+    }
+}
+
+void Easy::managed_stream::on_event(const sse_event &event)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_cancelled)
+    {
+        return;
+    }
+
+    if (event.is("ERROR"))
+    {
+        _error = event.get_data();
+        _ended = true;
+        lock.unlock();
+        _cv.notify_all();
+        return;
+    }
+
+    _received = true;
+    if (_backfilling)
+    {
+        _buffer.emplace_back(event.get_name(), event.get_data());
+        return;
+    }
+
+    lock.unlock();
+    deliver(event);
+}
+
+void Easy::managed_stream::deliver(const sse_event &event)
+{
+    std::lock_guard<std::mutex> lock(_deliver_mutex);
+
+    if (event.is("update") || event.is("notification"))
+    {
+        const string id = get_id(event);
+        if (!id.empty())
+        {
+            const string name = event.get_name();
+            const string key = name + ':' + id;
+            if (!_seen.insert(key).second)
+            {
+                ttdebug << "Skipping " << key << ", it was passed on.\n";
+                return;
+            }
+
+            _seen_order.push_back(key);
+            if (_seen_order.size() > seen_size)
+            {
+                _seen.erase(_seen_order.front());
+                _seen_order.pop_front();
+            }
+
+            string &last = _last_id[name];
+            if (is_newer(id, last))
+            {
+                last = id;
+            }
+        }
+    }
+
+    delivering = this;
+    try
+    {
+        _callback(event);
+    }
+    catch (...)
+    {
+        delivering = nullptr;
+        throw;
+    }
+    delivering = nullptr;
+}
+
+void Easy::managed_stream::backfill()
+{
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+
+    for (const source &timeline : _sources)
+    {
+        string min_id;
+        {
+            std::lock_guard<std::mutex> lock(_deliver_mutex);
+            const auto it = _last_id.find(timeline.event);
+            if (it == _last_id.end())
+            {                   // Nothing was passed on yet.
+                continue;
+            }
+            min_id = it->second;
+        }
+
+        for (std::uint16_t page = 0; page < _config.backfill_pages; ++page)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_cancelled)
+                {
+                    return;
+                }
+            }
+
+            parameters params = timeline.params;
+            params.push_back({ "min_id", { min_id }});
+            params.push_back({ "limit", { std::to_string(page_size) }});
+            const return_call ret = _api.get(timeline.call, params);
+
+            Json::Value entries;
+            if (!ret || !parse(ret.answer, entries) || !entries.isArray())
+            {
+                ttlog(WARNING) << "Could not backfill stream: "
+                               << ret.error_message << '\n';
+                break;
+            }
+            ttdebug << "Backfilling " << entries.size() << ' '
+                    << timeline.event << " events after " << min_id << ".\n";
+
+            // Timelines are sorted newest first.
+            for (Json::ArrayIndex i = entries.size(); i-- > 0;)
+            {
+                const string id = entries[i]["id"].asString();
+                const string data = Json::writeString(writer, entries[i]);
+                deliver({ timeline.event.data(), timeline.event.size(),
+                          data.data(), data.size() });
+                if (is_newer(id, min_id))
+                {
+                    min_id = id;
+                }
+            }
+
+            if (entries.size() < page_size)
+            {
+                break;
+            }
+        }
+    }
+}
+
+bool Easy::managed_stream::is_permanent(const string &data) const
+{
+    Json::Value value;
+    if (!parse(data, value) || !value.isObject())
+    {
+        return false;
+    }
+
+    const std::uint32_t code = value["error_code"].asUInt();
+    const std::uint32_t http = value["http_error"].asUInt();
+    if (code == static_cast<std::uint32_t>(error::INVALID_ARGUMENT)
+        || code == static_cast<std::uint32_t>(error::URL_CHANGED))
+    {
+        return true;
+    }
+
+    // Client errors, except timeouts and rate limits.
+    return (http / 100 == 4 && http != 408 && http != 429);
+}
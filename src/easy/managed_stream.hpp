@@ -0,0 +1,177 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MASTODON_CPP_EASY_MANAGED_STREAM_HPP
+#define MASTODON_CPP_EASY_MANAGED_STREAM_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+#include "../mastodon-cpp.hpp"
+#include "types_easy.hpp"
+
+using std::string;
+using std::vector;
+
+namespace Mastodon
+{
+namespace Easy
+{
+    /*!
+     *  @brief  A stream that reconnects when the connection drops and
+     *          fetches the events it missed in the meantime.
+     *
+     *          After a reconnect, statuses and notifications that arrived
+     *          while the stream was down are fetched from the matching
+     *          timeline, starting after the newest ID that was passed on.
+     *          They are passed on oldest first, before the events of the
+     *          new connection. Events that were already passed on are
+     *          skipped.
+     *
+     *          | Stream                    | Timelines                     |
+     *          |:--------------------------|:------------------------------|
+     *          | streaming_user            | timelines_home, notifications |
+     *          | streaming_public(_local)  | timelines_public              |
+     *          | streaming_hashtag(_local) | timelines_tag_hashtag         |
+     *          | streaming_list            | timelines_list_list_id        |
+     *
+     *          Other streams are reconnected without backfilling. Errors
+     *          that won't go away by reconnecting, like an invalid call or
+     *          an invalid access token, are passed as an `ERROR` event and
+     *          end the stream.
+     *
+     *          The callback is called from the thread of the current
+     *          connection or from the thread of the managed_stream, never
+     *          from two threads at once. It may call cancel(), but must not
+     *          destroy the managed_stream.
+     *
+     *          Example:
+     *          @code
+     *          Mastodon::Easy::managed_stream stream(
+     *              masto, Mastodon::API::v1::streaming_user, {},
+     *              [](const Mastodon::sse_event &event)
+     *              {
+     *                  if (event.is("update"))
+     *                  {
+     *                      Mastodon::Easy::Status status(event.get_data());
+     *                  }
+     *              });
+     *          @endcode
+     *
+     *  @since  0.112.0
+     */
+    class managed_stream
+    {
+    public:
+        /*!
+         *  @brief  Starts the stream.
+         *
+         *  @param  api       Used for the stream and for backfilling. Must
+         *                    outlive the managed_stream.
+         *  @param  call      A streaming call defined in Mastodon::API::v1.
+         *  @param  params    Parameters of the stream, like `tag` or `list`.
+         *  @param  callback  Receives the events.
+         *  @param  config    When to reconnect and how much to backfill.
+         */
+        explicit managed_stream(
+            Mastodon::API &api, const Mastodon::API::v1 &call,
+            const parameters &params,
+            const Mastodon::API::stream_callback_type &callback,
+            const reconnect_config &config = reconnect_config());
+
+        /*!
+         *  @brief  Cancels the stream.
+         */
+        ~managed_stream();
+
+        managed_stream(const managed_stream &) = delete;
+        managed_stream &operator=(const managed_stream &) = delete;
+
+        /*!
+         *  @brief  Cancels the stream and waits until it has ended.
+         *
+         *          Can be called from any thread and more than once. If
+         *          called from the callback, it returns without waiting.
+         */
+        void cancel();
+
+        /*!
+         *  @brief  Returns how often the stream was reconnected.
+         */
+        std::uint32_t reconnects() const;
+
+    private:
+        // A timeline that has the events of the stream.
+        typedef struct source
+        {
+            Mastodon::API::v1 call;
+            parameters params;
+            string event;
+        } source;
+
+        Mastodon::API &_api;
+        const Mastodon::API::v1 _call;
+        const parameters _params;
+        const Mastodon::API::stream_callback_type _callback;
+        const reconnect_config _config;
+        vector<source> _sources;
+
+        // Guards the state of the connection.
+        mutable std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _cancelled;
+        bool _ended;
+        bool _received;
+        bool _backfilling;
+        string _error;
+        // Events that arrived during backfilling, name and data.
+        vector<std::pair<string, string>> _buffer;
+        std::uint32_t _reconnects;
+
+        // Guards _http, which is only replaced by the thread.
+        std::mutex _http_mutex;
+        unique_ptr<Mastodon::API::http> _http;
+
+        // Guards the callback and what was passed on.
+        std::mutex _deliver_mutex;
+        // The newest ID that was passed on, by event name.
+        std::map<string, string> _last_id;
+        // Recently passed on events, as name:ID.
+        std::set<string> _seen;
+        std::deque<string> _seen_order;
+
+        std::mutex _thread_mutex;
+        std::thread _thread;
+
+        void run();
+        void on_event(const sse_event &event);
+        void deliver(const sse_event &event);
+        void backfill();
+        bool is_permanent(const string &data) const;
+    };
+}
+}
+
+#endif  // MASTODON_CPP_EASY_MANAGED_STREAM_HPP
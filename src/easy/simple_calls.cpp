@@ -15,8 +15,12 @@
  */
 
 #include <algorithm>
+#include <vector>
+#include <atomic>
+#include <utility>
 #include "easy.hpp"
 #include "debug.hpp"
+#include "cancel_scope.hpp"
 #include "easy/entities/status.hpp"
 #include "easy/entities/attachment.hpp"
 #include "easy/entities/notification.hpp"
@@ -84,7 +88,8 @@ const return_entity<Status> API::send_post(const Status &status)
     }
     if (!status.media_attachments().empty())
     {
-        std::vector<string> media_ids;
+        // Check all attachments before uploading anything.
+        std::vector<parameters> uploads;
         for (const Attachment &att : status.media_attachments())
         {
             parameters param_att;
@@ -109,19 +114,52 @@ const return_entity<Status> API::send_post(const Status &status)
                                       { std::to_string(att.focus()[0]) + ',' +
                                         std::to_string(att.focus()[1]) }});
             }
+            uploads.push_back(param_att);
+        }
 
-            return_call ret = post(API::v1::media, param_att);
-            if (ret.error_code == 0)
-            {
-                Attachment attachment(ret.answer);
-                media_ids.push_back(attachment.id());
-            }
-            else
-            {
-                ttdebug << "ERROR: Could not upload file.\n";
-                return { ret.error_code, ret.error_message,
-                         ret.http_error_code, Status(ret.answer) };
-            }
+        // Upload concurrently. The first failure cancels the uploads that
+        // are still running, they stop sending and are not reported.
+        const std::size_t max_uploads = 4;
+        std::vector<string> media_ids(uploads.size());
+        std::atomic<bool> cancelled(false);
+        return_call failed;
+
+        run_parallel(uploads.size(), max_uploads,
+                     [&](const std::size_t index)
+                     {
+                         const cancel_scope scope(cancelled);
+                         return_call ret;
+                         try
+                         {
+                             ret = post(API::v1::media, uploads[index]);
+                         }
+                         catch (const std::exception &)
+                         {
+                             if (!cancelled.exchange(true))
+                             {
+                                 throw;
+                             }
+                             return false;
+                         }
+                         if (ret.error_code == 0)
+                         {
+                             media_ids[index] = Attachment(ret.answer).id();
+                             return true;
+                         }
+
+                         // Only the first failure is reported.
+                         if (!cancelled.exchange(true))
+                         {
+                             ttdebug << "ERROR: Could not upload file.\n";
+                             failed = std::move(ret);
+                         }
+                         return false;
+                     });
+
+        if (failed.error_code != 0)
+        {
+            return { failed.error_code, failed.error_message,
+                     failed.http_error_code, Status(failed.answer) };
         }
 
         params.push_back({ "media_ids", media_ids });
@@ -234,6 +234,33 @@ namespace Easy
         string title;
         uint64_t votes_count = 0;
     } poll_options_type;
+
+    /*!
+     *  @brief  Settings for Easy::managed_stream.
+     *
+     *          The delay before reconnect n is a random time between 0 and
+     *          min(max_delay, base_delay * 2^(n-1)).
+     *
+     *  @since  0.112.0
+     */
+    typedef struct reconnect_config
+    {
+        /*!
+         *  @brief  Delay before the first reconnect, before jitter.
+         */
+        std::chrono::milliseconds base_delay = std::chrono::seconds(1);
+
+        /*!
+         *  @brief  Upper limit of the delay between reconnects.
+         */
+        std::chrono::milliseconds max_delay = std::chrono::seconds(60);
+
+        /*!
+         *  @brief  Maximum number of pages of 40 that are fetched from
+         *          each timeline after a reconnect. 0 disables backfilling.
+         */
+        std::uint16_t backfill_pages = 10;
+    } reconnect_config;
 }
 }
 #endif  // MASTODON_CPP_EASY_TYPES_EASY_HPP
@@ -0,0 +1,151 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <Poco/Path.h>
+#include <Poco/Exception.h>
+#include "file_part_source.hpp"
+
+using namespace Mastodon;
+
+file_part_source::file_streambuf::file_streambuf(const int fd,
+                                                 const std::size_t size)
+: _fd(fd)
+, _size(size)
+, _pos(0)
+{
+    setg(_buffer, _buffer, _buffer);
+}
+
+file_part_source::file_streambuf::int_type
+file_part_source::file_streambuf::underflow()
+{
+    const std::size_t got = read(_buffer, sizeof(_buffer));
+    if (got == 0)
+    {
+        return traits_type::eof();
+    }
+
+    setg(_buffer, _buffer, _buffer + got);
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize file_part_source::file_streambuf::xsgetn(char *s,
+                                                         std::streamsize n)
+{
+    // What underflow() buffered first.
+    std::streamsize done = std::min<std::streamsize>(n, egptr() - gptr());
+    std::memcpy(s, gptr(), static_cast<std::size_t>(done));
+    gbump(static_cast<int>(done));
+
+    if (done < n)
+    {                           // Read the rest directly into s.
+        done += static_cast<std::streamsize>(
+            read(s + done, static_cast<std::size_t>(n - done)));
+    }
+
+    return done;
+}
+
+std::size_t file_part_source::file_streambuf::read(char *target,
+                                                   std::size_t size)
+{
+    size = std::min(size, _size - _pos);
+
+    std::size_t done = 0;
+    while (done < size)
+    {
+        const ssize_t got = ::pread(_fd, target + done, size - done,
+                                    static_cast<off_t>(_pos + done));
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got < 0)
+        {
+            throw Poco::ReadFileException(std::strerror(errno));
+        }
+        if (got == 0)
+        {
+            throw Poco::IOException("File got shorter while it was read");
+        }
+
+        done += static_cast<std::size_t>(got);
+    }
+    _pos += done;
+
+    return done;
+}
+
+file_part_source::file_part_source(const string &path)
+: PartSource("application/octet-stream")
+, _filename(Poco::Path(path).getFileName())
+, _size(0)
+, _fd(open(path, _size))
+, _buffer(_fd, _size)
+, _stream(&_buffer)
+{
+    // Report errors of the buffer instead of ending the part early.
+    _stream.exceptions(std::ios::badbit);
+}
+
+file_part_source::~file_part_source()
+{
+    ::close(_fd);
+}
+
+std::istream &file_part_source::stream()
+{
+    return _stream;
+}
+
+const string &file_part_source::filename() const
+{
+    return _filename;
+}
+
+#if POCO_VERSION >= 0x01070000
+std::streamsize file_part_source::getContentLength() const
+{
+    return static_cast<std::streamsize>(_size);
+}
+#endif
+
+int file_part_source::open(const string &path, std::size_t &size)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw Poco::OpenFileException(path);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode))
+    {
+        ::close(fd);
+        throw Poco::OpenFileException(path);
+    }
+
+    size = static_cast<std::size_t>(status.st_size);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    return fd;
+}
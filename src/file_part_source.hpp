@@ -0,0 +1,96 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_FILE_PART_SOURCE_HPP
+#define MASTODON_CPP_FILE_PART_SOURCE_HPP
+
+#include <cstddef>
+#include <string>
+#include <istream>
+#include <streambuf>
+#include <sys/types.h>
+#include <Poco/Version.h>
+#include <Poco/Net/PartSource.h>
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Part of a multipart form, read from a file with pread().
+     *          Used for file uploads.
+     *
+     *          The size is taken when the file is opened and reported by
+     *          getContentLength(). If the file gets shorter while it is
+     *          read, reading throws Poco::IOException.
+     *
+     *  @since  0.112.0
+     */
+    class file_part_source : public Poco::Net::PartSource
+    {
+    public:
+        /*!
+         *  @brief  Opens the file.
+         *
+         *          Throws Poco::OpenFileException if the file can not be
+         *          opened.
+         *
+         *  @param  path  The file.
+         */
+        explicit file_part_source(const string &path);
+        ~file_part_source();
+
+        file_part_source(const file_part_source &) = delete;
+        file_part_source &operator=(const file_part_source &) = delete;
+
+        std::istream &stream() override;
+        const string &filename() const override;
+#if POCO_VERSION >= 0x01070000
+        std::streamsize getContentLength() const override;
+#endif
+
+    private:
+        // Reads the first size bytes of a file that is owned by someone
+        // else.
+        class file_streambuf : public std::streambuf
+        {
+        public:
+            file_streambuf(const int fd, const std::size_t size);
+
+        protected:
+            int_type underflow() override;
+            std::streamsize xsgetn(char *s, std::streamsize n) override;
+
+        private:
+            const int _fd;
+            const std::size_t _size;
+            std::size_t _pos;
+            char _buffer[65536];
+
+            std::size_t read(char *target, std::size_t size);
+        };
+
+        string _filename;
+        std::size_t _size;
+        int _fd;
+        file_streambuf _buffer;
+        std::istream _stream;
+
+        static int open(const string &path, std::size_t &size);
+    };
+}
+
+#endif  // MASTODON_CPP_FILE_PART_SOURCE_HPP
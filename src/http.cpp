@@ -19,17 +19,36 @@
 #include <exception>
 #include <thread>
 #include <regex>
+#include <algorithm>
+#include <random>
+#include <cctype>
+#include <sstream>
 #include <Poco/Net/HTTPSClientSession.h>
 #include <Poco/Net/HTTPRequest.h>
 #include <Poco/Net/HTTPResponse.h>
-#include <Poco/StreamCopier.h>
 #include <Poco/URI.h>
 #include <Poco/Environment.h>
 #include <Poco/Exception.h>
 #include <Poco/Net/NetException.h>
 #include <Poco/Net/SSLException.h>
+#include <Poco/Timespan.h>
+#include <Poco/InflatingStream.h>
+#include <Poco/Version.h>
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "connection_pool.hpp"
+#include "rate_limiter.hpp"
+#include "tls_cache.hpp"
+#include "progress_stream.hpp"
+#include "single_flight.hpp"
+#include "response_cache.hpp"
+#include "cassette.hpp"
+#include "timed_session.hpp"
+#include "call_scope.hpp"
+#include "cancel_scope.hpp"
+#include "metrics.hpp"
+#include "brotli_stream.hpp"
+#include "stream_multiplexer.hpp"
 
 using namespace Mastodon;
 using std::cerr;
@@ -40,20 +59,75 @@ using std::regex;
 using std::regex_search;
 using std::smatch;
 using Poco::Net::HTTPSClientSession;
+using Poco::Net::HTTPClientSession;
 using Poco::Net::HTTPRequest;
 using Poco::Net::HTTPResponse;
 using Poco::Net::HTTPMessage;
-using Poco::StreamCopier;
 using Poco::Environment;
+using Poco::InflatingInputStream;
+using Poco::InflatingStreamBuf;
 
 API::http::http(const API &api, const string &instance,
                 const string &access_token)
 : parent(api)
 , _instance(instance)
 , _access_token(access_token)
+, _https(true)
+, _port(HTTPSClientSession::HTTPS_PORT)
 , _cancel_stream(false)
+, _pool(make_unique<connection_pool>(
+            [this](const string &)
+            {
+                auto session = make_session();
+                const std::chrono::seconds timeout =
+                    _pool->get_config().idle_timeout;
+
+                session->setKeepAlive(true);
+                session->setKeepAliveTimeout(
+                    Poco::Timespan(static_cast<long>(timeout.count()), 0));
+
+                return connection_pool::session_ptr(move(session));
+            }))
+, _rate_limiter(make_unique<rate_limiter>())
+, _single_flight(make_unique<single_flight>())
+, _cache(make_unique<response_cache>())
+, _cassette(make_unique<cassette>())
+, _metrics(make_unique<metrics_registry>())
 {
     Poco::Net::initializeSSL();
+    _tls = make_unique<tls_cache>();
+
+    // The instance is [http(s)://]host[:port].
+    {
+        _authority = _instance;
+        size_t pos = _authority.find("://");
+        if (pos != string::npos)
+        {
+            _https = (_authority.substr(0, pos) != "http");
+            _authority = _authority.substr(pos + 3);
+            if (!_https)
+            {
+                _port = HTTPClientSession::HTTP_PORT;
+            }
+        }
+        _authority = _authority.substr(0, _authority.find('/'));
+
+        // IPv6 addresses are enclosed in brackets.
+        const size_t bracket = _authority.find(']');
+        pos = _authority.find(':', (bracket == string::npos ? 0 : bracket));
+        _host = _authority.substr(0, pos);
+        if (pos != string::npos)
+        {
+            _port = static_cast<std::uint16_t>(
+                std::stoul(_authority.substr(pos + 1)));
+        }
+        if (!_host.empty() && _host.front() == '[')
+        {
+            _host = _host.substr(1, _host.size() - 2);
+        }
+    }
+    ttdebug << "Host: " << _host << ", port: " << _port
+            << (_https ? ", TLS.\n" : ".\n");
 
     try
     {
@@ -90,6 +164,20 @@ API::http::http(const API &api, const string &instance,
 
 API::http::~http()
 {
+    if (_streamthread.joinable()
+        && _streamthread.get_id() == std::this_thread::get_id())
+    {
+        // The thread of the stream would use the object after it is gone.
+        ttlog(ERROR) << "API::http destroyed from the callback of its "
+                     << "stream.\n";
+        std::terminate();
+    }
+
+    cancel_stream();
+
+    // The sessions have to be closed before SSL is uninitialized.
+    _pool.reset();
+    _tls.reset();
     Poco::Net::uninitializeSSL();
 }
 
@@ -134,6 +222,138 @@ void API::http::set_proxy(const string &hostport, const string &userpw)
     }
 }
 
+unique_ptr<HTTPClientSession> API::http::make_session()
+{
+    if (_https)
+    {
+        return _tls->make_session(_host, _port);
+    }
+
+    return make_unique<timed_http_session>(_host, _port);
+}
+
+void API::http::set_connection_pool(const connection_pool_config &config)
+{
+    _pool->set_config(config);
+}
+
+void API::http::set_retry(const retry_config &config)
+{
+    std::lock_guard<std::mutex> lock(_retry_mutex);
+    _retry = config;
+}
+
+void API::http::set_timeouts(const timeout_config &config)
+{
+    std::lock_guard<std::mutex> lock(_timeouts_mutex);
+    _timeouts = config;
+}
+
+const timeout_config API::http::get_timeouts() const
+{
+    std::lock_guard<std::mutex> lock(_timeouts_mutex);
+    const auto it = _thread_timeouts.find(std::this_thread::get_id());
+    if (it != _thread_timeouts.end())
+    {
+        return it->second;
+    }
+
+    return _timeouts;
+}
+
+bool API::http::set_thread_timeouts(const timeout_config *config)
+{
+    std::lock_guard<std::mutex> lock(_timeouts_mutex);
+    const std::thread::id id = std::this_thread::get_id();
+    const bool had_override = (_thread_timeouts.erase(id) > 0);
+
+    if (config != nullptr)
+    {
+        _thread_timeouts.emplace(id, *config);
+    }
+
+    return had_override;
+}
+
+void API::http::set_progress_callback(
+    const progress_callback_type &callback)
+{
+    std::lock_guard<std::mutex> lock(_progress_mutex);
+    _progress = callback;
+}
+
+void API::http::set_observer(const observer_type &observer)
+{
+    std::shared_ptr<const observer_type> ptr;
+    if (observer)
+    {
+        ptr = std::make_shared<const observer_type>(observer);
+    }
+
+    std::lock_guard<std::mutex> lock(_observer_mutex);
+    _observer = move(ptr);
+}
+
+void API::http::set_metrics(const bool enabled)
+{
+    _metrics->set_enabled(enabled);
+}
+
+const string API::http::get_metrics() const
+{
+    return _metrics->render();
+}
+
+double API::http::callback_progress(double dltotal, double dlnow,
+                                    double ultotal, double ulnow)
+{
+    progress_callback_type callback;
+    {
+        std::lock_guard<std::mutex> lock(_progress_mutex);
+        callback = _progress;
+    }
+
+    if (callback)
+    {
+        callback(static_cast<std::uint64_t>(dltotal),
+                 static_cast<std::uint64_t>(dlnow),
+                 static_cast<std::uint64_t>(ultotal),
+                 static_cast<std::uint64_t>(ulnow));
+    }
+
+    return 0;
+}
+
+void API::http::set_single_flight(const bool enabled)
+{
+    _single_flight->set_enabled(enabled);
+}
+
+void API::http::set_cache(const cache_config &config)
+{
+    _cache->set_config(config);
+}
+
+const cache_stats API::http::get_cache_stats() const
+{
+    return _cache->get_stats();
+}
+
+bool API::http::set_cassette(const cassette_config &config)
+{
+    return _cassette->set_config(config);
+}
+
+void API::http::set_rate_limit(const rate_limit_config &config)
+{
+    _rate_limiter->set_config(config);
+}
+
+const rate_limit_status API::http::get_rate_limit() const
+{
+    return _rate_limiter->get_status();
+}
+
 return_call API::http::request(const http_method &meth, const string &path)
 {
     HTMLForm form;
@@ -143,23 +363,388 @@ return_call API::http::request(const http_method &meth, const string &path)
 return_call API::http::request(const http_method &meth, const string &path,
                                HTMLForm &formdata)
 {
-    string answer;
-    return request_common(meth, path, formdata, answer);
+    return request(meth, path, formdata, sink_type());
+}
+
+return_call API::http::request(const http_method &meth, const string &path,
+                               HTMLForm &formdata, const sink_type &sink)
+{
+    switch (_cassette->get_mode())
+    {
+    case cassette_mode::REPLAY:
+    {
+        const return_call ret = _cassette->replay(meth, path, sink);
+        if (ret.http_error_code != 0)
+        {                       // Like an answer from the server.
+            std::lock_guard<std::mutex> lock(_headers_mutex);
+            _headers = ret.headers;
+        }
+        return ret;
+    }
+    case cassette_mode::RECORD:
+    {
+        // Keep a copy of the data that goes to the sink.
+        string body;
+        sink_type recording_sink;
+        if (sink)
+        {
+            recording_sink = [&body, &sink](const char *data,
+                                            const std::size_t size)
+            {
+                body.append(data, size);
+                sink(data, size);
+            };
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const return_call ret =
+            request_dispatch(meth, path, formdata, recording_sink);
+        // Only successful answers go to the sink, see cassette::replay().
+        const bool sunk = (sink && ret.http_error_code / 100 == 2);
+        _cassette->record(meth, path, ret, (sunk ? body : ret.answer),
+                          std::chrono::duration_cast<
+                              std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - start));
+        return ret;
+    }
+    default:
+    {
+        return request_dispatch(meth, path, formdata, sink);
+    }
+    }
+}
+
+return_call API::http::request_dispatch(const http_method &meth,
+                                        const string &path,
+                                        HTMLForm &formdata,
+                                        const sink_type &sink)
+{
+    // The query string is part of path for GET requests.
+    if (meth != http_method::GET || sink || !formdata.empty())
+    {
+        return request_with_retries(meth, path, formdata, sink, {});
+    }
+
+    auto make = [&]
+    {
+        if (_cache->enabled())
+        {
+            return request_cached(path, formdata);
+        }
+        return request_with_retries(meth, path, formdata, sink, {});
+    };
+
+    if (_single_flight->enabled())
+    {
+        return _single_flight->run(path, make);
+    }
+
+    return make();
+}
+
+return_call API::http::request_cached(const string &path, HTMLForm &formdata)
+{
+    // Every http has its own access token, so it needn't be in the key.
+    const string key = "GET " + path;
+    return_call ret;
+    header_map validators;
+
+    if (_cache->get(key, ret, validators))
+    {
+        ttdebug << "Answering from cache: " << path << '\n';
+        return ret;
+    }
+
+    ret = request_with_retries(http_method::GET, path, formdata, sink_type(),
+                               validators);
+    if (ret.http_error_code == 304 && !validators.empty())
+    {
+        return_call cached;
+        if (_cache->revalidated(key, ret.headers, cached))
+        {
+            return cached;
+        }
+
+        // The entry was evicted while we were waiting for the server.
+        ret = request_with_retries(http_method::GET, path, formdata,
+                                   sink_type(), {});
+    }
+
+    if (ret.error_code == 0 && ret.http_error_code == 200)
+    {
+        _cache->store(key, ret);
+    }
+    else
+    {
+        _cache->miss();
+    }
+
+    return ret;
+}
+
+return_call API::http::request_with_retries(const http_method &meth,
+                                            const string &path,
+                                            HTMLForm &formdata,
+                                            const sink_type &sink,
+                                            const header_map &headers)
+{
+    retry_config config;
+    {
+        std::lock_guard<std::mutex> lock(_retry_mutex);
+        config = _retry;
+    }
+
+    const timeout_config timeouts = get_timeouts();
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (timeouts.total.count() > 0)
+    {
+        deadline = std::chrono::steady_clock::now() + timeouts.total;
+    }
+
+    bool retry = false;
+    switch (meth)
+    {
+    case http_method::GET:
+    case http_method::PUT:
+    case http_method::DELETE:
+    {
+        retry = true;
+        break;
+    }
+    case http_method::POST:
+    case http_method::PATCH:
+    {
+        retry = config.retry_post;
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+
+    // Data that was passed to the sink can't be taken back.
+    bool written = false;
+    sink_type tracked_sink;
+    if (sink)
+    {
+        tracked_sink = [&sink, &written](const char *data,
+                                         const std::size_t size)
+        {
+            written = true;
+            sink(data, size);
+        };
+    }
+
+    std::shared_ptr<const observer_type> observer;
+    {
+        std::lock_guard<std::mutex> lock(_observer_mutex);
+        observer = _observer;
+    }
+
+    const bool measure = _metrics->enabled();
+    auto report = [&](const request_record &record)
+    {
+        if (measure)
+        {
+            _metrics->record(record);
+        }
+        if (observer)
+        {
+            (*observer)(record);
+        }
+    };
+
+    // Makes one attempt and reports it to the observer and the metrics.
+    auto attempt_once = [&](const std::uint8_t attempt, string &answer)
+    {
+        if (!observer && !measure)
+        {
+            return request_common(meth, path, formdata, answer, tracked_sink,
+                                  timeouts, deadline, headers);
+        }
+
+        request_record record;
+        record.method = meth;
+        record.path = path;
+        record.retries = static_cast<std::uint8_t>(attempt - 1);
+        record.start = request_record::clock::now();
+        call_scope::apply(record);
+
+        return_call ret;
+        try
+        {
+            ret = request_common(meth, path, formdata, answer, tracked_sink,
+                                 timeouts, deadline, headers, &record);
+        }
+        catch (const std::exception &)
+        {                       // Only thrown if exceptions are enabled.
+            record.error_code = static_cast<uint8_t>(error::UNKNOWN);
+            report(record);
+            throw;
+        }
+
+        record.error_code = ret.error_code;
+        record.http_status = ret.http_error_code;
+        report(record);
+
+        return ret;
+    };
+
+    for (std::uint8_t attempt = 1; ; ++attempt)
+    {
+        string answer;
+        if (!retry || attempt >= config.max_attempts)
+        {
+            return attempt_once(attempt, answer);
+        }
+
+        return_call ret;
+        try
+        {
+            ret = attempt_once(attempt, answer);
+        }
+        catch (const Poco::Net::ConnectionRefusedException &e)
+        {                       // Only thrown if exceptions are enabled.
+            ret = { error::CONNECTION_REFUSED, e.displayText(), 0, "" };
+        }
+        catch (const Poco::TimeoutException &e)
+        {
+            ret = { error::CONNECTION_TIMEOUT, e.displayText(), 0, "" };
+        }
+
+        if (!is_transient(ret) || written)
+        {
+            return ret;
+        }
+
+        const std::chrono::milliseconds delay =
+            retry_delay(config, attempt, ret);
+        if (delay.count() < 0)
+        {
+            ttdebug << "Server asks us to wait too long, giving up.\n";
+            return ret;
+        }
+        if (std::chrono::steady_clock::now() + delay >= deadline)
+        {
+            ttdebug << "No time left for another attempt.\n";
+            return ret;
+        }
+
+        ttlog(INFO) << "Attempt " << static_cast<int>(attempt) << " failed ("
+                    << ret.error_message << ", HTTP " << ret.http_error_code
+                    << "), retrying in " << delay.count() << " ms.\n";
+        std::this_thread::sleep_for(delay);
+    }
+}
+
+bool API::http::is_transient(const return_call &ret)
+{
+    if (ret.error_code == static_cast<uint8_t>(error::CONNECTION_TIMEOUT))
+    {
+        return true;
+    }
+
+    if (ret.error_code == static_cast<uint8_t>(error::CONNECTION_REFUSED))
+    {
+        switch (ret.http_error_code)
+        {
+        case 0:                 // Refused by the operating system.
+        case 429:               // HTTPResponse::HTTP_TOO_MANY_REQUESTS
+        case HTTPResponse::HTTP_BAD_GATEWAY:
+        case HTTPResponse::HTTP_SERVICE_UNAVAILABLE:
+        case HTTPResponse::HTTP_GATEWAY_TIMEOUT:
+        {
+            return true;
+        }
+        default:
+        {
+            return false;
+        }
+        }
+    }
+
+    return false;
+}
+
+std::chrono::milliseconds API::http::retry_delay(const retry_config &config,
+                                                 const std::uint8_t attempt,
+                                                 const return_call &ret)
+{
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    // min(max_delay, base_delay * 2^(attempt - 1))
+    milliseconds ceiling = std::min(config.base_delay, config.max_delay);
+    for (std::uint8_t i = 1; i < attempt && ceiling < config.max_delay; ++i)
+    {
+        ceiling = std::min(ceiling * 2, config.max_delay);
+    }
+
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+    std::uniform_int_distribution<milliseconds::rep>
+        distribution(0, std::max<milliseconds::rep>(ceiling.count(), 0));
+    milliseconds delay(distribution(engine));
+
+    const auto it = ret.headers.find("Retry-After");
+    if (it != ret.headers.end())
+    {
+        const string &value = it->second;
+        std::chrono::seconds after_seconds;
+        rate_limiter::clock::time_point after;
+        rate_limiter::clock::time_point date;
+        milliseconds wanted(-1);
+
+        if (rate_limiter::parse_seconds(value, after_seconds))
+        {                       // Compared first, to convert it safely.
+            if (after_seconds.count() > config.max_delay.count() / 1000)
+            {
+                return milliseconds(-1);
+            }
+            wanted = after_seconds;
+        }
+        else if (rate_limiter::parse_time(value, after))
+        {                       // HTTP date.
+            const auto date_it = ret.headers.find("Date");
+            if (date_it != ret.headers.end()
+                && rate_limiter::parse_time(date_it->second, date))
+            {
+                wanted = duration_cast<milliseconds>(after - date);
+            }
+            else
+            {
+                wanted = duration_cast<milliseconds>(
+                    after - rate_limiter::clock::now());
+            }
+        }
+
+        if (wanted > config.max_delay)
+        {
+            return milliseconds(-1);
+        }
+        delay = std::max(delay, wanted);
+    }
+
+    return delay;
 }
 
 void API::http::request_stream(const string &path, string &stream)
 {
-    static return_call ret;
     _streamthread = std::thread(
-        [&, path]               // path is captured by value because it may be
-        {                       // deleted before we access it.
-            HTMLForm form;
-            ret = request_common(http_method::GET_STREAM, path,
-                                 form, stream);
-            ttdebug << "Remaining content of the stream: " << stream << '\n';
-            if (!ret)
+        [this, path, &stream]   // path is captured by value because it may
+        {                       // be deleted before we access it.
+            const return_call ret = run_stream(
+                path,
+                [this, &stream](const char *data, const std::size_t size)
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    stream.append(data, size);
+                });
+
+            if (!ret && !_cancel_stream)
             {
                 // Embed the HTTP status code in stream on error.
+                std::lock_guard<std::mutex> lock(_mutex);
                 stream += "event: ERROR\ndata: {\"error_code\":"
                     + std::to_string(ret.error_code) +  ",\"http_error\":"
                     + std::to_string(ret.http_error_code) + "}\n";
@@ -167,10 +752,136 @@ void API::http::request_stream(const string &path, string &stream)
         });
 }
 
-return_call API::http::request_common(const http_method &meth,
-                                      const string &path,
-                                      HTMLForm &formdata,
-                                      string &answer)
+void API::http::request_stream(const string &path,
+                               const stream_callback_type &callback,
+                               const executor_type &executor)
+{
+    stream_callback_type deliver = callback;
+    if (executor)
+    {
+        // The event points into buffers of the parser, which are reused
+        // before the executor runs the task.
+        deliver = [callback, executor](const sse_event &event)
+        {
+            const auto copy = std::make_shared<std::pair<string, string>>(
+                event.get_name(), event.get_data());
+            executor([callback, copy]
+                     {
+                         callback({ copy->first.data(), copy->first.size(),
+                                    copy->second.data(), copy->second.size() });
+                     });
+        };
+    }
+
+    _streamthread = std::thread(
+        [this, path, deliver]
+        {
+            sse_parser parser(deliver);
+            const return_call ret = run_stream(
+                path,
+                [&parser](const char *data, const std::size_t size)
+                {
+                    parser.feed(data, size);
+                });
+
+            if (_cancel_stream)
+            {
+                return;
+            }
+            parser.finish();
+
+            // Report errors like the other request_stream() does. Streams
+            // don't end on their own, so the end is reported too.
+            const string data = "{\"error_code\":"
+                + std::to_string(ret.error_code) + ",\"http_error\":"
+                + std::to_string(ret.http_error_code) + "}";
+            deliver({ "ERROR", 5, data.data(), data.size() });
+        });
+}
+
+return_call API::http::run_stream(const string &path, const sink_type &sink)
+{
+    HTMLForm form;
+    string answer;
+
+    try
+    {
+        return request_common(
+            http_method::GET_STREAM, path, form, answer,
+            [this, &sink](const char *data, const std::size_t size)
+            {
+                // Data that was read before the connection was shut down
+                // is dropped.
+                if (!_cancel_stream)
+                {
+                    sink(data, size);
+                }
+            },
+            get_timeouts(), std::chrono::steady_clock::time_point::max());
+    }
+    catch (const std::exception &e)
+    {
+        // Exceptions can't leave the thread of the stream.
+        ttdebug << "Exception in stream: " << e.what() << '\n';
+        return { error::UNKNOWN, e.what(), 0, "" };
+    }
+}
+
+return_call API::http::open_stream(const string &path,
+                                   stream_connection &connection)
+{
+    HTMLForm form;
+    string answer;
+    const timeout_config timeouts = get_timeouts();
+    connection.idle_timeout = timeouts.receive;
+
+    return request_common(http_method::GET_STREAM, path, form, answer,
+                          nullptr, timeouts,
+                          std::chrono::steady_clock::time_point::max(), {},
+                          nullptr, &connection);
+}
+
+bool API::http::set_stream_abort(const Poco::Net::StreamSocket &socket)
+{
+    std::lock_guard<std::mutex> lock(_stream_abort_mutex);
+    if (_cancel_stream)
+    {
+        return false;
+    }
+
+    // The copy keeps the socket alive until clear_stream_abort().
+    _stream_abort = [socket]
+    {
+        try
+        {
+            // Shut down the socket, not the TLS connection. Writing the
+            // close notification from this thread would race with the
+            // thread of the stream, which is reading. Linux aborts
+            // connection attempts too.
+            socket.impl()->Poco::Net::SocketImpl::shutdown();
+        }
+        catch (const Poco::Exception &e)
+        {
+            ttdebug << "Could not shut down stream: " << e.displayText()
+                    << '\n';
+        }
+    };
+
+    return true;
+}
+
+void API::http::clear_stream_abort()
+{
+    std::lock_guard<std::mutex> lock(_stream_abort_mutex);
+    _stream_abort = nullptr;
+}
+
+return_call API::http::request_common(
+    const http_method &meth, const string &path, HTMLForm &formdata,
+    string &answer, const sink_type &sink, const timeout_config &timeouts,
+    const std::chrono::steady_clock::time_point deadline,
+    const header_map &extra_headers, request_record *record,
+    stream_connection *connection)
 {
     ttdebug << "Path is: " << path << '\n';
 
@@ -213,7 +924,6 @@ return_call API::http::request_common(const http_method &meth,
         }
         }
 
-        HTTPSClientSession session(_instance);
         HTTPRequest request(method, path, HTTPMessage::HTTP_1_1);
         request.set("User-Agent", parent.get_useragent());
 
@@ -222,35 +932,432 @@ return_call API::http::request_common(const http_method &meth,
             request.set("Authorization", " Bearer " + _access_token);
         }
 
+        for (const auto &header : extra_headers)
+        {
+            request.set(header.first, header.second);
+        }
+
+        if (meth != http_method::GET_STREAM)
+        {
+#ifdef WITH_BROTLI
+            request.set("Accept-Encoding", "br, gzip, deflate");
+#else
+            request.set("Accept-Encoding", "gzip, deflate");
+#endif
+        }
+
         if (!formdata.empty())
         {
             ttdebug << "Size of HTMLForm is " << formdata.size() << '\n';
+            // Only once, it appends the parameters to the URI of GET and
+            // DELETE requests.
+#if POCO_VERSION >= 0x01070000
+            // Uses chunked transfer encoding if a part doesn't know its size.
+            formdata.prepareSubmit(request, HTMLForm::OPT_USE_CONTENT_LENGTH);
+#else
             formdata.prepareSubmit(request);
-            formdata.write(session.sendRequest(request));
+#endif
         }
-        else
+
+        bool report_progress = false;
+        if (meth != http_method::GET_STREAM)
         {
-            session.sendRequest(request);
+            std::lock_guard<std::mutex> lock(_progress_mutex);
+            report_progress = static_cast<bool>(_progress);
         }
 
         HTTPResponse response;
-        istream &body_stream = session.receiveResponse(response);
+
+        // Sets the timeouts, shortened to the time left until deadline.
+        auto apply_timeouts = [&timeouts, &deadline](HTTPClientSession &session)
+        {
+            using std::chrono::microseconds;
+            using std::chrono::duration_cast;
+            using std::chrono::steady_clock;
+
+            microseconds left = microseconds::max();
+            if (deadline != steady_clock::time_point::max())
+            {
+                left = duration_cast<microseconds>(deadline
+                                                   - steady_clock::now());
+                if (left.count() <= 0)
+                {
+                    throw Poco::TimeoutException("Deadline exceeded");
+                }
+            }
+
+            // 0 means no timeout, but Poco would not wait at all to connect.
+            auto timespan = [left](const std::chrono::milliseconds timeout,
+                                   const bool is_connect)
+            {
+                microseconds value = timeout;
+                if (value.count() == 0)
+                {
+                    value = (is_connect ? std::chrono::hours(24)
+                             : microseconds(0));
+                }
+                if (value.count() == 0 || value > left)
+                {
+                    value = left;
+                }
+                if (value == microseconds::max())
+                {
+                    value = microseconds(0);
+                }
+                return Poco::Timespan(value.count());
+            };
+
+            const Poco::Timespan connect = timespan(timeouts.connect, true);
+            const Poco::Timespan send = timespan(timeouts.send, false);
+            const Poco::Timespan receive = timespan(timeouts.receive, false);
+
+#if POCO_VERSION >= 0x01070000
+            session.setTimeout(connect, send, receive);
+#else
+            // Older versions use one timeout for everything.
+            session.setTimeout(receive);
+#endif
+            if (session.connected())
+            {                   // Reused connections are already set up.
+                session.socket().setSendTimeout(send);
+                session.socket().setReceiveTimeout(receive);
+            }
+        };
+
+        // The answer was received, the request must not be sent again.
+        bool answered = false;
+
+        // Sends the request and reads the whole answer.
+        auto transfer = [&](HTTPClientSession &session)
+        {
+            if (cancel_scope::cancelled())
+            {
+                throw Poco::Net::NetException("Request cancelled");
+            }
+            apply_timeouts(session);
+            response.clear();
+            answered = false;
+
+            const std::uint64_t ultotal = (request.hasContentLength()
+                                           ? static_cast<std::uint64_t>(
+                                               request.getContentLength64())
+                                           : 0);
+            std::uint64_t ulnow = 0;
+
+            const connection_timing *timing = nullptr;
+            std::uint64_t connects = 0;
+            bool was_connected = false;
+            if (record != nullptr)
+            {
+                timing = get_timing(session);
+                connects = (timing != nullptr ? timing->connects : 0);
+                was_connected = session.connected();
+            }
+
+            if (!formdata.empty())
+            {
+                std::ostream &out = session.sendRequest(request);
+                if (report_progress || record != nullptr
+                    || cancel_scope::active())
+                {
+                    // Throwing makes counter bad, which stops the copy.
+                    progress_ostream counter(
+                        out, [&](const std::uint64_t written)
+                        {
+                            ulnow = written;
+                            if (cancel_scope::cancelled())
+                            {
+                                throw Poco::Net::NetException(
+                                    "Request cancelled");
+                            }
+                            if (report_progress)
+                            {
+                                callback_progress(0, 0, ultotal, ulnow);
+                            }
+                        });
+                    formdata.write(counter);
+                    counter.flush();
+                    if (cancel_scope::cancelled())
+                    {           // The connection is not reused.
+                        throw Poco::Net::NetException("Request cancelled");
+                    }
+                }
+                else
+                {
+                    formdata.write(out);
+                }
+            }
+            else
+            {
+                session.sendRequest(request);
+            }
+
+            // Cancelled while connecting. Connections for the stream
+            // multiplexer are not cancelled.
+            if (meth == http_method::GET_STREAM && connection == nullptr
+                && _cancel_stream)
+            {
+                throw Poco::Net::ConnectionAbortedException(
+                    "Stream cancelled");
+            }
+
+            if (record != nullptr)
+            {
+                record->sent = request_record::clock::now();
+                if (timing != nullptr && timing->connects != connects)
+                {
+                    record->dns = timing->dns;
+                    record->connect = timing->connect;
+                    record->tls = timing->tls;
+                    record->reused = false;
+                }
+                else
+                {
+                    record->dns = record->queued;
+                    record->connect = record->queued;
+                    record->tls = record->queued;
+                    record->reused = (timing != nullptr || was_connected);
+                }
+
+                std::ostringstream head;
+                request.write(head);
+                record->bytes_sent = static_cast<std::uint64_t>(head.tellp())
+                    + ulnow;
+            }
+
+            istream &body_stream = session.receiveResponse(response);
+            answered = true;
+            _tls->store(_host, session);
+
+            if (connection != nullptr
+                && response.getStatus() == HTTPResponse::HTTP_OK)
+            {           // The body is read by the stream multiplexer.
+                connection->chunked = response.getChunkedTransferEncoding();
+                connection->buffered = take_buffered(session);
+                return;
+            }
+
+            // Only successful answers go to the sink, errors are returned.
+            answer.clear();
+            // Answers without a body may name an encoding anyway, but an
+            // empty body is not valid gzip.
+            const uint16_t status = response.getStatus();
+            const bool has_body =
+                !(status / 100 == 1 || status == 204 || status == 304
+                  || (response.hasContentLength()
+                      && response.getContentLength64() == 0));
+            const string encoding =
+                (has_body ? response.get("Content-Encoding", "") : "");
+            sink_type body_sink = sink;
+            if (!sink || response.getStatus() / 100 != 2)
+            {
+                body_sink = [&answer](const char *data,
+                                      const std::size_t size)
+                {
+                    answer.append(data, size);
+                };
+            }
+
+            if (report_progress)
+            {
+                // The length of compressed bodies doesn't help the user.
+                const std::uint64_t dltotal =
+                    (response.hasContentLength() && encoding.empty()
+                     ? static_cast<std::uint64_t>(
+                         response.getContentLength64())
+                     : 0);
+                std::uint64_t dlnow = 0;
+                const sink_type inner = move(body_sink);
+
+                body_sink = [&, inner, dltotal](const char *data,
+                                                const std::size_t size)
+                {
+                    inner(data, size);
+                    dlnow += size;
+                    callback_progress(dltotal, dlnow, ultotal, ulnow);
+                };
+            }
+
+            // Streams are counted by the metrics of the API object.
+            metrics_registry &registry = *parent._http._metrics;
+            stream_meter meter(registry);
+            if (meth == http_method::GET_STREAM && registry.enabled())
+            {
+                const sink_type inner = move(body_sink);
+                body_sink = [&meter, inner](const char *data,
+                                            const std::size_t size)
+                {
+                    inner(data, size);
+                    meter.feed(data, size);
+                };
+            }
+
+            // Reports the error of the connection instead of the one of
+            // read_body(), like a timeout.
+            auto read = [&](istream &in)
+            {
+                try
+                {
+                    read_body(in, encoding, body_sink, deadline,
+                              meth == http_method::GET_STREAM);
+                }
+                catch (const Poco::Exception &)
+                {
+                    const Poco::Exception *network =
+                        session.networkException();
+                    if (network != nullptr)
+                    {
+                        network->rethrow();
+                    }
+                    throw;
+                }
+            };
+
+            if (record == nullptr)
+            {
+                read(body_stream);
+                return;
+            }
+
+            record->first_byte = request_record::clock::now();
+            record->http_status = response.getStatus();
+
+            std::ostringstream head;
+            response.write(head);
+            std::uint64_t received = 0;
+            progress_istream counter(body_stream,
+                                     [&received](const std::uint64_t read)
+                                     {
+                                         received = read;
+                                     });
+            read(counter);
+
+            record->end = request_record::clock::now();
+            record->bytes_received =
+                static_cast<std::uint64_t>(head.tellp()) + received;
+        };
+
+        if (meth == http_method::GET_STREAM)
+        {                       // Streams block their connection.
+            unique_ptr<HTTPClientSession> session = make_session();
+            if (record != nullptr)
+            {
+                record->queued = request_record::clock::now();
+            }
+
+            // Forget the connection before the session closes it.
+            struct abort_guard
+            {
+                http &self;
+                ~abort_guard()
+                {
+                    self.clear_stream_abort();
+                }
+            } guard{ *this };
+            if (connection == nullptr)
+            {
+                set_connect_hook(
+                    *session, [this](const Poco::Net::StreamSocket &socket)
+                    {
+                        if (!set_stream_abort(socket))
+                        {
+                            throw Poco::Net::ConnectionAbortedException(
+                                "Stream cancelled");
+                        }
+                    });
+            }
+            transfer(*session);
+
+            if (connection != nullptr
+                && response.getStatus() == HTTPResponse::HTTP_OK)
+            {
+                connection->session = std::move(session);
+            }
+        }
+        else
+        {
+            // Wait for the rate limit before taking a connection.
+            rate_limiter::permit permit = _rate_limiter->acquire();
+            connection_pool::lease lease = _pool->acquire(_instance);
+            if (record != nullptr)
+            {
+                record->queued = request_record::clock::now();
+            }
+
+            while (true)
+            {
+                try
+                {
+                    transfer(lease.session());
+                    break;
+                }
+                catch (const Poco::Exception &e)
+                {
+                    // The server may close an idle connection at the same
+                    // time we send a request. Retry once with a new
+                    // connection, if it is safe to send the request again.
+                    // The parts of a form are streams that were already
+                    // read, so requests with a body are not sent again.
+                    if (lease.reused() && !answered && formdata.empty()
+                        && connection_pool::is_idempotent(meth)
+                        && connection_pool::is_closed_connection(e))
+                    {
+                        ttlog(INFO) << "Reused connection was closed by the "
+                                    << "server, retrying: " << e.displayText()
+                                    << '\n';
+                        lease.renew();
+                        continue;
+                    }
+                    throw;
+                }
+            }
+
+            lease.keep_alive(connection_pool::is_reusable(response));
+            permit.update(response);
+        }
 
         const uint16_t http_code = response.getStatus();
         ttdebug << "Response code: " << http_code << '\n';
 
-        answer.clear();
-        StreamCopier::copyToString(body_stream, answer);
+        // Headers are returned with every answer, so that concurrent
+        // requests don't have to share them.
+        header_map headers;
+        for (const auto &header : response)
+        {
+            string &value = headers[header.first];
+            if (!value.empty())
+            {                   // Join repeated headers like RFC 7230 does.
+                value += ", ";
+            }
+            value += header.second;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_headers_mutex);
+            _headers = headers;
+        }
+
+        auto with_headers = [&headers](return_call ret)
+        {
+            ret.headers = std::move(headers);
+            return ret;
+        };
 
-        std::ostringstream headers_stream;
-        response.write(headers_stream);
-        _headers = headers_stream.str();
+        // The answer is moved into the return value, unless it is the
+        // string of a stream.
+        auto take_answer = [&meth, &answer]() -> string
+        {
+            if (meth == http_method::GET_STREAM)
+            {
+                return answer;
+            }
+            return std::move(answer);
+        };
 
         switch (http_code)
         {
         case HTTPResponse::HTTP_OK:
         {
-            return { error::OK, "", http_code, answer };
+            return with_headers({ error::OK, "", http_code, take_answer() });
         }
         // Not using the constants because some are too new for Debian stretch.
         case 301:               // HTTPResponse::HTTP_MOVED_PERMANENTLY
@@ -267,11 +1374,12 @@ return_call API::http::request_common(const http_method &meth,
                 size_t pos1 = location.find("//") + 2;
                 size_t pos2 = location.find('/', pos1);
 
-                if (location.substr(pos1, pos2 - pos1) != _instance)
+                if (location.substr(pos1, pos2 - pos1) != _authority)
                 {               // Return new location if the domain changed.
                     ttdebug << "New location is on another domain.\n";
-                    return { error::URL_CHANGED, "Remote address changed",
-                             http_code, location };
+                    return with_headers({ error::URL_CHANGED,
+                                          "Remote address changed",
+                                          http_code, location });
                 }
 
                 location = location.substr(pos2);
@@ -279,19 +1387,27 @@ return_call API::http::request_common(const http_method &meth,
 
             if (http_code == 301 || http_code == 308)
             {                   // Return new location for permanent redirects.
-                return { error::URL_CHANGED, "Remote address changed",
-                         http_code, location };
+                return with_headers({ error::URL_CHANGED,
+                                      "Remote address changed",
+                                      http_code, location });
             }
             else
             {
                 ttdebug << "Following temporary redirect: " << location << '\n';
-                return request_common(meth, location, formdata, answer);
+                if (record != nullptr)
+                {
+                    record->path = location;
+                }
+                return request_common(meth, location, formdata, answer, sink,
+                                      timeouts, deadline, extra_headers,
+                                      record, connection);
             }
         }
         default:
         {
-            return { error::CONNECTION_REFUSED, "Connection refused",
-                     http_code, answer };
+            return with_headers({ error::CONNECTION_REFUSED,
+                                  "Connection refused", http_code,
+                                  take_answer() });
         }
         }
     }
@@ -325,6 +1441,16 @@ return_call API::http::request_common(const http_method &meth,
         ttdebug << e.displayText() << "\n";
         return { error::ENCRYPTION, e.displayText(), 0, "" };
     }
+    catch (const Poco::TimeoutException &e)
+    {
+        if (parent.exceptions())
+        {
+            e.rethrow();
+        }
+
+        ttdebug << "Timeout: " << e.displayText() << "\n";
+        return { error::CONNECTION_TIMEOUT, e.displayText(), 0, "" };
+    }
     catch (const Poco::Net::NetException &e)
     {
         if (parent.exceptions())
@@ -347,15 +1473,144 @@ return_call API::http::request_common(const http_method &meth,
     }
 }
 
+void API::http::read_body(istream &body, const string &encoding,
+                          const sink_type &sink,
+                          const std::chrono::steady_clock::time_point deadline,
+                          const bool partial)
+{
+    string enc = encoding;
+    std::transform(enc.begin(), enc.end(), enc.begin(),
+                   [](const unsigned char c)
+                   {
+                       return static_cast<char>(std::tolower(c));
+                   });
+
+    // Copies in chunks and checks the deadline after every chunk, the
+    // socket timeouts only limit the time between two chunks. Returns false
+    // if reading failed, istream swallows the exceptions.
+    auto copy_raw = [&deadline, partial](istream &in, const sink_type &out)
+    {
+        char buffer[8192];
+
+        if (partial)
+        {
+            // read() would wait until the buffer is full. peek() waits
+            // for the next piece, readsome() takes what has arrived.
+            while (in.peek() != istream::traits_type::eof())
+            {
+                const std::streamsize got = in.readsome(buffer,
+                                                        sizeof(buffer));
+                if (out && got > 0)
+                {
+                    out(buffer, static_cast<std::size_t>(got));
+                }
+            }
+            return !in.bad();
+        }
+
+        while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0)
+        {
+            if (out)
+            {
+                out(buffer, static_cast<std::size_t>(in.gcount()));
+            }
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                throw Poco::TimeoutException("Deadline exceeded");
+            }
+        }
+        return !in.bad();
+    };
+
+    // Decompresses while copying, there is no copy of the compressed body.
+    auto copy = [&body, &sink, &copy_raw](istream &decoder)
+    {
+        if (!copy_raw(decoder, sink))
+        {
+            if (body.bad())
+            {           // The decoder could not read the body.
+                throw Poco::IOException("Could not read answer");
+            }
+            throw Poco::DataFormatException("Could not decompress answer");
+        }
+
+        // Leave nothing behind on connections that are reused.
+        if (!copy_raw(body, sink_type()))
+        {
+            throw Poco::IOException("Could not read answer");
+        }
+    };
+
+    if (enc == "gzip" || enc == "x-gzip")
+    {
+        InflatingInputStream inflater(body, InflatingStreamBuf::STREAM_GZIP);
+        copy(inflater);
+    }
+    else if (enc == "deflate")
+    {
+        InflatingInputStream inflater(body, InflatingStreamBuf::STREAM_ZLIB);
+        copy(inflater);
+    }
+#ifdef WITH_BROTLI
+    else if (enc == "br")
+    {
+        brotli_input_stream decoder(body);
+        copy(decoder);
+    }
+#endif
+    else
+    {
+        if (!enc.empty() && enc != "identity")
+        {
+            ttlog(WARNING) << "Unknown Content-Encoding: " << encoding
+                           << '\n';
+        }
+        if (!copy_raw(body, sink))
+        {
+            throw Poco::IOException("Could not read answer");
+        }
+    }
+}
+
 void API::http::get_headers(string &headers) const
 {
-    headers = _headers;
+    std::lock_guard<std::mutex> lock(_headers_mutex);
+    headers.clear();
+    for (const auto &header : _headers)
+    {
+        headers += header.first + ": " + header.second + "\r\n";
+    }
+}
+
+const string API::http::get_header(const string &name) const
+{
+    std::lock_guard<std::mutex> lock(_headers_mutex);
+    const auto it = _headers.find(name);
+    if (it != _headers.end())
+    {
+        return it->second;
+    }
+
+    return "";
 }
 
 void API::http::cancel_stream()
 {
-    _cancel_stream = true;
-    _streamthread.join();
+    {
+        std::lock_guard<std::mutex> lock(_stream_abort_mutex);
+        _cancel_stream = true;
+        if (_stream_abort)
+        {
+            _stream_abort();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_streamthread_mutex);
+    if (_streamthread.joinable()
+        && _streamthread.get_id() != std::this_thread::get_id())
+    {
+        _streamthread.join();
+    }
 }
 
 std::mutex &API::http::get_mutex()
@@ -0,0 +1,244 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include "mastodon-cpp.hpp"
+#include "log.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    // The sink, nullptr means stderr. Threads keep a copy and fetch it
+    // again when the generation changes.
+    std::mutex sink_mutex;
+    std::shared_ptr<const log_sink_type> sink;
+    std::atomic<std::uint64_t> sink_generation(0);
+
+    // Messages can be logged while another message is put together, for
+    // example by an operator<< or by the sink. Every nesting level gets its
+    // own buffer.
+    typedef struct thread_state
+    {
+        std::vector<std::unique_ptr<std::ostringstream>> buffers;
+        std::size_t depth = 0;
+        std::uint64_t generation = ~std::uint64_t(0);
+        std::shared_ptr<const log_sink_type> sink;
+    } thread_state;
+
+    thread_state &get_thread_state()
+    {
+        static thread_local thread_state state;
+        return state;
+    }
+
+    std::ostringstream &next_buffer()
+    {
+        thread_state &state = get_thread_state();
+        if (state.depth == state.buffers.size())
+        {
+            state.buffers.emplace_back(new std::ostringstream);
+        }
+
+        std::ostringstream &buffer = *state.buffers[state.depth++];
+        buffer.str("");
+        buffer.clear();
+        return buffer;
+    }
+
+    const char *level_name(const log_level level)
+    {
+        switch (level)
+        {
+        case log_level::ERROR:
+        {
+            return "ERROR";
+        }
+        case log_level::WARNING:
+        {
+            return "WARNING";
+        }
+        case log_level::INFO:
+        {
+            return "INFO";
+        }
+        case log_level::TRACE:
+        {
+            return "TRACE";
+        }
+        default:
+        {
+            return "";
+        }
+        }
+    }
+
+    void write_stderr(const log_record &record)
+    {
+        // One write per message, so that threads don't mix their lines.
+        const string line = "[" + string(record.file) + ":"
+            + std::to_string(record.line) + "] " + level_name(record.level)
+            + ": " + record.message + '\n';
+        std::fwrite(line.data(), 1, line.size(), stderr);
+    }
+}
+
+std::atomic<int> log_line::_threshold(-1);
+
+log_line::log_line(const log_level level, const char *file, const int line)
+: _level(level)
+, _file(file)
+, _line(line)
+, _stream(next_buffer())
+{}
+
+log_line::~log_line()
+{
+    thread_state &state = get_thread_state();
+
+    log_record record;
+    record.level = _level;
+    record.time = std::chrono::system_clock::now();
+    record.thread = std::this_thread::get_id();
+    record.file = _file;
+    record.line = _line;
+    record.message = state.buffers[--state.depth]->str();
+    while (!record.message.empty() && record.message.back() == '\n')
+    {
+        record.message.pop_back();
+    }
+
+    const std::uint64_t generation =
+        sink_generation.load(std::memory_order_acquire);
+    if (generation != state.generation)
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        state.sink = sink;
+        state.generation = generation;
+    }
+
+    // A message logged by the sink may replace state.sink.
+    const std::shared_ptr<const log_sink_type> current = state.sink;
+    try
+    {
+        if (current)
+        {
+            (*current)(record);
+        }
+        else
+        {
+            write_stderr(record);
+        }
+    }
+    catch (...)
+    {                           // Logging must never break a request.
+    }
+}
+
+log_line &log_line::operator<<(std::ostream &(*manipulator)(std::ostream &))
+{
+    manipulator(_stream);
+    return *this;
+}
+
+log_level log_line::threshold()
+{
+    int threshold = _threshold.load(std::memory_order_relaxed);
+    if (threshold < 0)
+    {
+        threshold = load_threshold();
+    }
+
+    return static_cast<log_level>(threshold);
+}
+
+void log_line::set_threshold(const log_level level)
+{
+    _threshold = static_cast<int>(level);
+}
+
+void log_line::set_sink(const log_sink_type &new_sink)
+{
+    std::shared_ptr<const log_sink_type> ptr;
+    if (new_sink)
+    {
+        ptr = std::make_shared<const log_sink_type>(new_sink);
+    }
+
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    sink = std::move(ptr);
+    ++sink_generation;
+}
+
+int log_line::load_threshold()
+{
+#ifdef DEBUG
+    int threshold = static_cast<int>(log_level::TRACE);
+#else
+    int threshold = static_cast<int>(log_level::OFF);
+#endif
+
+    const char *env = std::getenv("MASTODON_CPP_LOG_LEVEL");
+    if (env != nullptr)
+    {
+        const string value = env;
+        for (const log_level level : { log_level::OFF, log_level::ERROR,
+                                       log_level::WARNING, log_level::INFO,
+                                       log_level::TRACE })
+        {
+            string name = (level == log_level::OFF
+                           ? "OFF" : level_name(level));
+            for (char &c : name)
+            {
+                c = static_cast<char>(std::tolower(c));
+            }
+            if (value == name)
+            {
+                threshold = static_cast<int>(level);
+            }
+        }
+    }
+
+    // Another thread may have set the level in the meantime.
+    int expected = -1;
+    _threshold.compare_exchange_strong(expected, threshold);
+    return _threshold.load();
+}
+
+void Mastodon::set_log_level(const log_level level)
+{
+    log_line::set_threshold(level);
+}
+
+log_level Mastodon::get_log_level()
+{
+    return log_line::threshold();
+}
+
+void Mastodon::set_log_sink(const log_sink_type &sink)
+{
+    log_line::set_sink(sink);
+}
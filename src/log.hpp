@@ -0,0 +1,88 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_LOG_HPP
+#define MASTODON_CPP_LOG_HPP
+
+#include <ostream>
+#include <atomic>
+#include "types.hpp"
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Puts a log message together and passes it to the log sink
+     *          when it is destroyed. Used by ttlog and ttdebug.
+     *
+     *          The message is written to a buffer that belongs to the
+     *          calling thread and the nesting level, no lock is taken
+     *          before the sink is called.
+     *
+     *  @since  0.112.0
+     */
+    class log_line
+    {
+    public:
+        log_line(const log_level level, const char *file, const int line);
+        ~log_line();
+
+        log_line(const log_line &) = delete;
+        log_line &operator=(const log_line &) = delete;
+
+        template <typename T>
+        log_line &operator<<(const T &value)
+        {
+            _stream << value;
+            return *this;
+        }
+
+        /*!
+         *  @brief  For manipulators like std::endl.
+         */
+        log_line &operator<<(std::ostream &(*manipulator)(std::ostream &));
+
+        /*!
+         *  @brief  Returns true if messages of level are logged.
+         */
+        static bool enabled(const log_level level)
+        {
+            const int threshold = _threshold.load(std::memory_order_relaxed);
+            if (threshold < 0)
+            {
+                return (level <= log_line::threshold());
+            }
+
+            return (static_cast<int>(level) <= threshold);
+        }
+
+        static log_level threshold();
+        static void set_threshold(const log_level level);
+        static void set_sink(const log_sink_type &sink);
+
+    private:
+        const log_level _level;
+        const char *const _file;
+        const int _line;
+        std::ostream &_stream;
+
+        // The log level, -1 until it was read from the environment.
+        static std::atomic<int> _threshold;
+
+        static int load_threshold();
+    };
+}
+
+#endif  // MASTODON_CPP_LOG_HPP
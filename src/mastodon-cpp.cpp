@@ -21,15 +21,16 @@
 #include <iostream>
 #include <exception>
 #include <algorithm>
-#include <Poco/Net/FilePartSource.h>
 #include <Poco/URI.h>
 #include "version.hpp"
 #include "debug.hpp"
 #include "mastodon-cpp.hpp"
+#include "thread_pool.hpp"
+#include "stream_multiplexer.hpp"
+#include "file_part_source.hpp"
 
 using namespace Mastodon;
 using std::make_unique;
-using Poco::Net::FilePartSource;
 
 API::API(const string &instance, const string &access_token)
 : _instance(instance)
@@ -37,6 +38,8 @@ API::API(const string &instance, const string &access_token)
 , _useragent(string("mastodon-cpp/") + global::version)
 , _http(*this, instance, access_token)
 , _exceptions(false)
+, _async_threads(4)
+, _stream_threads(1)
 {
     bool fash = false;
     const std::regex re_gab("(?:\\.|^)gab\\.[^\\.]+$");
@@ -62,11 +65,13 @@ API::~API()
 
 void API::set_useragent(const std::string &useragent)
 {
+    std::lock_guard<std::mutex> lock(_settings_mutex);
     _useragent = useragent;
 }
 
 const string API::get_useragent() const
 {
+    std::lock_guard<std::mutex> lock(_settings_mutex);
     return _useragent;
 }
 
@@ -146,8 +151,8 @@ unique_ptr<HTMLForm> API::maptoformdata(const parameters &map)
 
                 try
                 {
-                    formdata->addPart(key,
-                                     new FilePartSource(it.values.front()));
+                    formdata->addPart(
+                        key, new file_part_source(it.values.front()));
                 }
                 catch (const std::exception &e)
                 {
@@ -212,7 +217,8 @@ return_call API::register_app1(const string &client_name,
         std::regex_search(ret.answer, match, resecret);
         client_secret = match[1].str();
 
-        url = "https://" + _instance + "/oauth/authorize" +
+        url = (_instance.find("://") == string::npos ? "https://" : "")
+            + _instance + "/oauth/authorize" +
             "?scope=" + ::urlencode(scopes) + "&response_type=code" +
             "&redirect_uri=" + ::urlencode(redirect_uri) +
             "&client_id=" + client_id;
@@ -256,6 +262,8 @@ return_call API::register_app2(const string &client_id,
 
         std::regex_search(ret.answer, match, retoken);
         access_token = match[1].str();
+
+        std::lock_guard<std::mutex> lock(_settings_mutex);
         _access_token = access_token;
     }
     else
@@ -268,24 +276,7 @@ return_call API::register_app2(const string &client_id,
 
 const string API::get_header(std::string header) const
 {
-    string headers;
-    string headers_lower;
-    _http.get_headers(headers);
-    headers_lower.resize(headers.size());
-
-    std::transform(headers.begin(), headers.end(),
-                   headers_lower.begin(), ::tolower);
-    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
-
-    size_t startpos = headers_lower.find(header + ':');
-    if (startpos != std::string::npos)
-    {
-        startpos = headers.find(':', startpos) + 2;
-        size_t endpos = headers.find("\r\n", startpos);
-        return headers.substr(startpos, endpos - startpos);
-    }
-
-    return "";
+    return _http.get_header(header);
 }
 
 bool API::exceptions(const bool &value)
@@ -304,6 +295,131 @@ void API::set_proxy(const string &hostport, const string &userpw)
     _http.set_proxy(hostport, userpw);
 }
 
+void API::set_connection_pool(const connection_pool_config &config)
+{
+    _http.set_connection_pool(config);
+}
+
+void API::set_rate_limit(const rate_limit_config &config)
+{
+    _http.set_rate_limit(config);
+}
+
+const rate_limit_status API::get_rate_limit() const
+{
+    return _http.get_rate_limit();
+}
+
+void API::set_retry(const retry_config &config)
+{
+    _http.set_retry(config);
+}
+
+void API::set_timeouts(const timeout_config &config)
+{
+    _http.set_timeouts(config);
+}
+
+void API::set_progress_callback(const progress_callback_type &callback)
+{
+    _http.set_progress_callback(callback);
+}
+
+void API::set_observer(const observer_type &observer)
+{
+    _http.set_observer(observer);
+}
+
+void API::set_metrics(const bool enabled)
+{
+    _http.set_metrics(enabled);
+}
+
+const string API::get_metrics() const
+{
+    return _http.get_metrics();
+}
+
+void API::set_single_flight(const bool enabled)
+{
+    _http.set_single_flight(enabled);
+}
+
+void API::set_cache(const cache_config &config)
+{
+    _http.set_cache(config);
+}
+
+const cache_stats API::get_cache_stats() const
+{
+    return _http.get_cache_stats();
+}
+
+bool API::set_cassette(const cassette_config &config)
+{
+    return _http.set_cassette(config);
+}
+
+API::scoped_timeouts::scoped_timeouts(API &api,
+                                      const timeout_config &timeouts)
+: _api(api)
+, _previous(api._http.get_timeouts())
+, _had_previous(api._http.set_thread_timeouts(&timeouts))
+{}
+
+API::scoped_timeouts::~scoped_timeouts()
+{
+    _api._http.set_thread_timeouts(_had_previous ? &_previous : nullptr);
+}
+
+void API::set_async_threads(const std::size_t threads)
+{
+    std::lock_guard<std::mutex> lock(_async_mutex);
+    _async_threads = threads;
+
+    if (_thread_pool)
+    {
+        _thread_pool->resize(threads);
+    }
+}
+
+thread_pool &API::get_thread_pool()
+{
+    std::lock_guard<std::mutex> lock(_async_mutex);
+
+    if (!_thread_pool)
+    {
+        ttdebug << "Starting " << _async_threads << " worker threads.\n";
+        _thread_pool = make_unique<thread_pool>(_async_threads);
+    }
+
+    return *_thread_pool;
+}
+
+void API::set_stream_threads(const std::size_t threads)
+{
+    std::lock_guard<std::mutex> lock(_multiplexer_mutex);
+    _stream_threads = threads;
+
+    if (_multiplexer)
+    {
+        _multiplexer->resize(threads);
+    }
+}
+
+stream_multiplexer &API::get_multiplexer()
+{
+    std::lock_guard<std::mutex> lock(_multiplexer_mutex);
+
+    if (!_multiplexer)
+    {
+        ttdebug << "Starting " << _stream_threads << " stream threads.\n";
+        _multiplexer = make_unique<stream_multiplexer>(_stream_threads);
+    }
+
+    return *_multiplexer;
+}
+
 const parameters API::delete_params(const parameters &params,
                                     const vector<string> &keys)
 {
@@ -21,20 +21,36 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <map>
 #include <mutex>
 #include <ostream>
+#include <istream>
 #include <thread>
 #include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <utility>
 #include <Poco/Net/HTMLForm.h>
 
 #include "return_types.hpp"
 #include "types.hpp"
+#include "sse_parser.hpp"
 
 using std::string;
 using std::uint8_t;
 using std::unique_ptr;
 using Poco::Net::HTMLForm;
 
+namespace Poco
+{
+    namespace Net
+    {
+        class HTTPClientSession;
+    }
+}
+
 /*!
  *  @example example01_get_public_timeline.cpp
  *  @example example02_stream.cpp
@@ -46,6 +62,18 @@ using Poco::Net::HTMLForm;
  */
 namespace Mastodon
 {
+    class connection_pool;
+    class rate_limiter;
+    class tls_cache;
+    class single_flight;
+    class response_cache;
+    class cassette;
+    class metrics_registry;
+    class thread_pool;
+    class stream_multiplexer;
+    struct request_record;
+    struct stream_connection;
+
     /*!
      *  @brief  Interface to the Mastodon API.
      *
@@ -69,6 +97,54 @@ namespace Mastodon
     class API
     {
     public:
+        /*!
+         *  @brief  Receives the body of an answer in pieces, see
+         *          get(const string &, const sink_type &).
+         *
+         *  @since  0.112.0
+         */
+        using sink_type = std::function<void(const char *data,
+                                             const std::size_t size)>;
+
+        /*!
+         *  @brief  Receives the progress of requests, see
+         *          set_progress_callback().
+         *
+         *          Totals are 0 if they are not known.
+         *
+         *  @since  0.112.0
+         */
+        using progress_callback_type =
+            std::function<void(const std::uint64_t dltotal,
+                               const std::uint64_t dlnow,
+                               const std::uint64_t ultotal,
+                               const std::uint64_t ulnow)>;
+
+        /*!
+         *  @brief  Receives a record of every request, see set_observer().
+         *
+         *  @since  0.112.0
+         */
+        using observer_type = std::function<void(const request_record &)>;
+
+        /*!
+         *  @brief  Receives the events of a stream, see get_stream().
+         *
+         *          The event is valid until the callback returns.
+         *
+         *  @since  0.112.0
+         */
+        using stream_callback_type = std::function<void(const sse_event &)>;
+
+        /*!
+         *  @brief  Runs a task somewhere else, for example in a thread pool
+         *          or an event loop.
+         *
+         *  @since  0.112.0
+         */
+        using executor_type =
+            std::function<void(const std::function<void()> &task)>;
+
         /*!
          *  @brief  http class. Do not use this directly.
          *
@@ -88,6 +164,14 @@ namespace Mastodon
              */
             explicit http(const API &api, const string &instance,
                           const string &access_token);
+
+            /*!
+             *  @brief  Cancels the stream and waits for its thread.
+             *
+             *          Must not be called from the callback of the stream,
+             *          the thread would still use the object afterwards.
+             *          The program is terminated if it is.
+             */
             ~http();
             return_call request(const http_method &meth, const string &path);
 
@@ -104,6 +188,25 @@ namespace Mastodon
                                 const string &path,
                                 HTMLForm &formdata);
 
+            /*!
+             *  @brief  HTTP Request that writes the body of a successful
+             *          answer to sink.
+             *
+             *          return_call::answer contains the body only if the
+             *          request was not successful.
+             *
+             *  @param  meth      A method defined in http::method.
+             *  @param  path      The API call as string.
+             *  @param  formdata  The form data for PATCH and POST requests.
+             *  @param  sink      Receives the body.
+             *
+             *  @since  0.112.0
+             */
+            return_call request(const http_method &meth,
+                                const string &path,
+                                HTMLForm &formdata,
+                                const sink_type &sink);
+
             /*!
              *  @brief HTTP Request for streams.
              *
@@ -115,16 +218,64 @@ namespace Mastodon
             void request_stream(const string &path, string &stream);
 
             /*!
-             *  @brief  Get all headers in a string
+             *  @brief  HTTP Request for streams that passes every event to
+             *          callback as soon as it is complete.
+             *
+             *  @param  path      The API call as string.
+             *  @param  callback  Receives the events.
+             *  @param  executor  Runs callback. If empty, callback is called
+             *                    in the thread of the stream.
+             *
+             *  @since  0.112.0
+             */
+            void request_stream(const string &path,
+                                const stream_callback_type &callback,
+                                const executor_type &executor);
+
+            /*!
+             *  @brief  Connect to a stream and receive the headers, but
+             *          not the body.
+             *
+             *          If the answer is 200, the session is moved into
+             *          connection, for a stream_multiplexer.
+             *
+             *  @param  path        The API call as string.
+             *  @param  connection  Receives the connection.
+             *
+             *  @since  0.112.0
+             */
+            return_call open_stream(const string &path,
+                                    stream_connection &connection);
+
+            /*!
+             *  @brief  Get all headers of the last answer in a string
              */
             void get_headers(string &headers) const;
 
+            /*!
+             *  @brief  Get a header of the last answer. Case insensitive.
+             *
+             *  @param  name  The name of the header.
+             *
+             *  @return The value of the header, or "".
+             *
+             *  @since  0.112.0
+             */
+            const string get_header(const string &name) const;
+
             /*!
              *  @brief  Cancels the stream. Use only with streams.
              *
-             *          Cancels the stream next time data comes in. Can take a
-             *          few seconds.  This works only with streams, because only
-             *          streams have an own http object.
+             *          Shuts the connection down and waits for the thread of
+             *          the stream to finish. No events are passed on
+             *          afterwards. If the connection is being established,
+             *          the stream ends as soon as it is. This works only with
+             *          streams, because only streams have an own http object.
+             *
+             *          Can be called from any thread and more than once. If
+             *          called from the callback of the stream, it returns
+             *          without waiting. The object must not be destroyed
+             *          from the callback.
              *
              *  @since  0.12.2
              */
@@ -152,23 +303,327 @@ namespace Mastodon
              */
             void set_proxy(const string &hostport, const string &userpw = "");
 
+            /*!
+             *  @brief  Set connection pool settings. Do not call this
+             *          directly.
+             *
+             *  @param  config  The settings.
+             *
+             *  @since  0.112.0
+             */
+            void set_connection_pool(const connection_pool_config &config);
+
+            /*!
+             *  @brief  Set rate limit scheduler settings. Do not call this
+             *          directly.
+             *
+             *  @param  config  The settings.
+             *
+             *  @since  0.112.0
+             */
+            void set_rate_limit(const rate_limit_config &config);
+
+            /*!
+             *  @brief  Get the state of the rate limit scheduler. Do not call
+             *          this directly.
+             *
+             *  @since  0.112.0
+             */
+            const rate_limit_status get_rate_limit() const;
+
+            /*!
+             *  @brief  Set retry settings. Do not call this directly.
+             *
+             *  @param  config  The settings.
+             *
+             *  @since  0.112.0
+             */
+            void set_retry(const retry_config &config);
+
+            /*!
+             *  @brief  Set timeouts. Do not call this directly.
+             *
+             *  @param  config  The timeouts.
+             *
+             *  @since  0.112.0
+             */
+            void set_timeouts(const timeout_config &config);
+
+            /*!
+             *  @brief  Get the timeouts for requests from the calling
+             *          thread. Do not call this directly.
+             *
+             *  @since  0.112.0
+             */
+            const timeout_config get_timeouts() const;
+
+            /*!
+             *  @brief  Override the timeouts for requests from the calling
+             *          thread. Do not call this directly, use
+             *          API::scoped_timeouts.
+             *
+             *  @param  config  The timeouts, nullptr removes the override.
+             *
+             *  @return true if there was an override before.
+             *
+             *  @since  0.112.0
+             */
+            bool set_thread_timeouts(const timeout_config *config);
+
+            /*!
+             *  @brief  Set the progress callback. Do not call this directly.
+             *
+             *  @param  callback  The callback, or an empty function.
+             *
+             *  @since  0.112.0
+             */
+            void set_progress_callback(
+                const progress_callback_type &callback);
+
+            /*!
+             *  @brief  Enable or disable coalescing of GET requests. Do not
+             *          call this directly.
+             *
+             *  @since  0.112.0
+             */
+            void set_single_flight(const bool enabled);
+
+            /*!
+             *  @brief  Set the cache settings. Do not call this directly.
+             *
+             *  @since  0.112.0
+             */
+            void set_cache(const cache_config &config);
+
+            /*!
+             *  @brief  Returns the cache counters. Do not call this
+             *          directly.
+             *
+             *  @since  0.112.0
+             */
+            const cache_stats get_cache_stats() const;
+
+            /*!
+             *  @brief  Set the cassette settings. Do not call this
+             *          directly.
+             *
+             *  @since  0.112.0
+             */
+            bool set_cassette(const cassette_config &config);
+
+            /*!
+             *  @brief  Set the request observer. Do not call this directly.
+             *
+             *  @param  observer  The observer, or an empty function.
+             *
+             *  @since  0.112.0
+             */
+            void set_observer(const observer_type &observer);
+
+            /*!
+             *  @brief  Enable or disable the metrics registry. Do not call
+             *          this directly.
+             *
+             *  @since  0.112.0
+             */
+            void set_metrics(const bool enabled);
+
+            /*!
+             *  @brief  Returns the metrics in the Prometheus text format.
+             *          Do not call this directly.
+             *
+             *  @since  0.112.0
+             */
+            const string get_metrics() const;
+
+            /*!
+             *  @brief  Returns true if the request failed temporarily and
+             *          may succeed if it is sent again.
+             *
+             *  @since  0.112.0
+             */
+            static bool is_transient(const return_call &ret);
+
+            /*!
+             *  @brief  Returns how long to wait before the next attempt.
+             *
+             *          Returns a negative duration if the server asks us to
+             *          wait longer than retry_config::max_delay.
+             *
+             *  @param  config  The retry settings.
+             *  @param  attempt The attempt that failed, starting with 1.
+             *  @param  ret     The failed answer.
+             *
+             *  @since  0.112.0
+             */
+            static std::chrono::milliseconds retry_delay(
+                const retry_config &config, const std::uint8_t attempt,
+                const return_call &ret);
+
         private:
             const API &parent;
             const string _instance;
             const string _access_token;
-            string _headers;
-            bool _cancel_stream;
+            bool _https;
+            string _host;
+            std::uint16_t _port;
+            string _authority;
+            header_map _headers;
+            mutable std::mutex _headers_mutex;
+            std::atomic<bool> _cancel_stream;
             std::mutex _mutex;
             std::thread _streamthread;
+            // Guards joining _streamthread.
+            std::mutex _streamthread_mutex;
+            // Shuts down the connection of the stream.
+            std::function<void()> _stream_abort;
+            // Guards _stream_abort and setting _cancel_stream.
+            std::mutex _stream_abort_mutex;
+            unique_ptr<tls_cache> _tls;
+            unique_ptr<connection_pool> _pool;
+            unique_ptr<rate_limiter> _rate_limiter;
+            unique_ptr<single_flight> _single_flight;
+            unique_ptr<response_cache> _cache;
+            unique_ptr<cassette> _cassette;
+            unique_ptr<metrics_registry> _metrics;
+            retry_config _retry;
+            std::mutex _retry_mutex;
+            timeout_config _timeouts;
+            std::map<std::thread::id, timeout_config> _thread_timeouts;
+            mutable std::mutex _timeouts_mutex;
+            progress_callback_type _progress;
+            mutable std::mutex _progress_mutex;
+            std::shared_ptr<const observer_type> _observer;
+            mutable std::mutex _observer_mutex;
+
+            /*!
+             *  @brief  Open a new connection to the instance, with TLS
+             *          unless the instance starts with `http://`.
+             *
+             *  @since  0.112.0
+             */
+            unique_ptr<Poco::Net::HTTPClientSession> make_session();
+
+            /*!
+             *  @brief  Let cancel_stream() shut down socket. Call this
+             *          before socket connects, so that connecting can be
+             *          aborted too.
+             *
+             *  @return false if the stream was already cancelled.
+             *
+             *  @since  0.112.0
+             */
+            bool set_stream_abort(const Poco::Net::StreamSocket &socket);
+
+            /*!
+             *  @brief  Run a stream until it ends or is cancelled. The body
+             *          is passed to sink.
+             *
+             *  @since  0.112.0
+             */
+            return_call run_stream(const string &path, const sink_type &sink);
+
+            /*!
+             *  @brief  Forget the connection set with set_stream_abort(),
+             *          before it is closed.
+             *
+             *  @since  0.112.0
+             */
+            void clear_stream_abort();
+
+            /*!
+             *  @brief  Answer the request from the cache, from an
+             *          identical running request or from the server.
+             *
+             *  @since  0.112.0
+             */
+            return_call request_dispatch(const http_method &meth,
+                                         const string &path,
+                                         HTMLForm &formdata,
+                                         const sink_type &sink);
+
+            /*!
+             *  @brief  Make the request and retry it if it failed
+             *          temporarily.
+             *
+             *  @since  0.112.0
+             */
+            return_call request_with_retries(const http_method &meth,
+                                             const string &path,
+                                             HTMLForm &formdata,
+                                             const sink_type &sink,
+                                             const header_map &headers);
+
+            /*!
+             *  @brief  Answer a GET request from the cache, or make it and
+             *          store the answer.
+             *
+             *  @since  0.112.0
+             */
+            return_call request_cached(const string &path,
+                                       HTMLForm &formdata);
+
+            /*!
+             *  @brief  Make the request.
+             *
+             *  @param  meth      The HTTP method.
+             *  @param  path      The API call as string.
+             *  @param  formdata  The form data.
+             *  @param  answer    The answer.
+             *  @param  sink      Receives the body of successful answers
+             *                    instead of answer, if set.
+             *  @param  timeouts  Timeouts for this request.
+             *  @param  deadline  The request must be finished by then.
+             *  @param  extra_headers  Additional request headers.
+             *  @param  record    Receives the timing and size of the
+             *                    request, if set.
+             *  @param  connection  Receives the connection of a successful
+             *                      stream instead of reading the body, if
+             *                      set.
+             *
+             *  @since  0.112.0
+             */
+            return_call request_common(
+                const http_method &meth, const string &path,
+                HTMLForm &formdata, string &answer, const sink_type &sink,
+                const timeout_config &timeouts,
+                const std::chrono::steady_clock::time_point deadline,
+                const header_map &extra_headers = {},
+                request_record *record = nullptr,
+                stream_connection *connection = nullptr);
+
+            /*!
+             *  @brief  Read the body and decompress it if necessary.
+             *
+             *  @param  body      The body of the response.
+             *  @param  encoding  The value of the Content-Encoding header.
+             *  @param  sink      Receives the decompressed body in pieces.
+             *  @param  deadline  Throws Poco::TimeoutException if the body
+             *                    is not read by then.
+             *  @param  partial   Pass on every piece as soon as it arrives,
+             *                    for streams.
+             *
+             *  @since  0.112.0
+             */
+            static void read_body(
+                std::istream &body, const string &encoding,
+                const sink_type &sink,
+                const std::chrono::steady_clock::time_point deadline,
+                const bool partial = false);
 
-            return_call request_common(const http_method &meth,
-                                       const string &path,
-                                       HTMLForm &formdata,
-                                       string &answer);
             size_t callback_write(char* data, size_t size, size_t nmemb,
                                   string *oss);
-            double callback_progress(double /* dltotal */, double /* dlnow */,
-                                     double /* ultotal */, double /* ulnow */);
+
+            /*!
+             *  @brief  Passes the progress of a request to the callback set
+             *          with set_progress_callback().
+             *
+             *  @return Always 0.
+             *
+             *  @since  0.112.0
+             */
+            double callback_progress(double dltotal, double dlnow,
+                                     double ultotal, double ulnow);
         };
 
         /*!
@@ -302,7 +757,9 @@ namespace Mastodon
          *          To register your application, leave access_token blank and
          *          call register_app1() and register_app2().
          *
-         *  @param  instance      The hostname of your instance
+         *  @param  instance      The hostname of your instance. Can also be
+         *                        given as `[http(s)://]host[:port]`, for
+         *                        example to talk to a local test server.
          *  @param  access_token  Your access token.
          *
          *  @since  before 0.11.0
@@ -413,6 +870,10 @@ namespace Mastodon
         /*!
          *  @brief  Gets the header from the last answer. Case insensitive.
          *
+         *          If requests are made from several threads, the last answer
+         *          may be from another thread. Use return_call::headers
+         *          instead.
+         *
          *  @param  header  The header to get
          *
          *  @return The header, or "" on error.
@@ -461,116 +922,602 @@ namespace Mastodon
         void set_proxy(const string &hostport, const string &userpw = "");
 
         /*!
-         *  @brief  Make a GET request that doesn't require parameters.
+         *  @brief  Sets the connection pool settings.
          *
-         *  @param  call    A call defined in Mastodon::API::v1
+         *          Connections to the instance are kept open and reused by
+         *          later requests. Streams always use their own connection.
          *
-         *  @since  0.100.0
+         *  @param  config  See Mastodon::connection_pool_config.
+         *
+         *  @since  0.112.0
          */
-        const return_call get(const Mastodon::API::v1 &call);
+        void set_connection_pool(const connection_pool_config &config);
 
         /*!
-         *  @brief  Make a GET request that requires parameters.
+         *  @brief  Sets the rate limit scheduler settings.
          *
-         *  @param  call        A call defined in Mastodon::API::v1
-         *  @param  parameters  A Mastodon::parametermap containing
-         *                      parameters
+         *          When enabled, requests are held back instead of being
+         *          rejected with HTTP 429 when the budget announced in the
+         *          `X-RateLimit-*` headers is used up. Until the first
+         *          answer tells the budget, requests are sent one at a time.
+         *          Streams are not affected.
          *
-         *  @since  0.100.0
+         *          Example:
+         *          @code
+         *          Mastodon::rate_limit_config config;
+         *          config.enabled = true;
+         *          masto.set_rate_limit(config);
+         *          @endcode
+         *
+         *  @param  config  See Mastodon::rate_limit_config.
+         *
+         *  @since  0.112.0
          */
-        const return_call get(const Mastodon::API::v1 &call,
-                              const parameters &parameters);
+        void set_rate_limit(const rate_limit_config &config);
 
         /*!
-         *  @brief  Make a GET request that requires parameters.
+         *  @brief  Returns the rate limit budget and the number of queued
+         *          requests.
          *
-         *  @param  call        A call defined in Mastodon::API::v2
-         *  @param  parameters  A Mastodon::parametermap containing
-         *                      parameters
+         *          The budget is known after the first answer.
          *
-         *  @since  0.100.0
+         *  @since  0.112.0
          */
-        const return_call get(const Mastodon::API::v2 &call,
-                              const parameters &parameters);
+        const rate_limit_status get_rate_limit() const;
 
         /*!
-         *  @brief  Make a custom GET request.
+         *  @brief  Sets the retry settings.
          *
-         *  @param  call    String in the form `/api/v1/example`
+         *          Requests that failed temporarily are sent again after an
+         *          exponentially growing, random delay. By default GET, PUT
+         *          and DELETE requests are attempted 3 times. Streams are not
+         *          retried.
          *
-         *  @since  0.100.0
+         *  @param  config  See Mastodon::retry_config.
+         *
+         *  @since  0.112.0
          */
-        const return_call get(const string &call);
+        void set_retry(const retry_config &config);
 
         /*!
-         *  @brief  Make a streaming GET request.
+         *  @brief  Sets the timeouts for all requests.
          *
-         *  @param  call        A call defined in Mastodon::API::v1
-         *  @param  parameters  A Mastodon::parametermap containing
-         *                      parameters
-         *  @param  ptr         Pointer to the http object. Can be used to call
-         *                      ptr->cancel_stream()
+         *          A timeout is reported as error::CONNECTION_TIMEOUT, or
+         *          Poco::TimeoutException is thrown if exceptions are
+         *          enabled. Use scoped_timeouts to change the timeouts of
+         *          single requests.
          *
-         *  @since  0.100.0
+         *  @param  config  See Mastodon::timeout_config.
+         *
+         *  @since  0.112.0
          */
-        void get_stream(const Mastodon::API::v1 &call,
-                        const parameters &parameters,
-                        unique_ptr<Mastodon::API::http> &ptr,
-                        string &stream);
+        void set_timeouts(const timeout_config &config);
 
         /*!
-         *  @brief  Make a streaming GET request.
+         *  @brief  Sets a callback that receives the progress of requests.
+         *
+         *          It is called from the thread that makes the request,
+         *          every time a piece of data was sent or received. Uploads
+         *          have a known total if all parts of the form know their
+         *          size, which is the case for files with POCO 1.7 and
+         *          later. Streams don't report progress.
+         *
+         *          Example:
+         *          @code
+         *          masto.set_progress_callback(
+         *              [](const uint64_t, const uint64_t,
+         *                 const uint64_t ultotal, const uint64_t ulnow)
+         *              {
+         *                  if (ultotal > 0)
+         *                  {
+         *                      cout << ulnow * 100 / ultotal << " %\n";
+         *                  }
+         *              });
+         *          @endcode
+         *
+         *  @param  callback  The callback, or an empty function to remove it.
+         *
+         *  @since  0.112.0
+         */
+        void set_progress_callback(const progress_callback_type &callback);
+
+        /*!
+         *  @brief  Sets an observer that receives a request_record after
+         *          every request.
+         *
+         *          The record tells how long resolving the host,
+         *          connecting, the TLS handshake, waiting for the answer and
+         *          reading the body took, how many bytes were sent and
+         *          received and whether a pooled connection was reused.
+         *          Every attempt of a retried request is reported. Answers
+         *          from the cache or a cassette and streams are not
+         *          reported.
+         *
+         *          The observer is called from the thread that makes the
+         *          request and must not throw. Without an observer and
+         *          without metrics (see set_metrics()), no clock is read
+         *          and no record is made.
+         *
+         *          Example:
+         *          @code
+         *          masto.set_observer(
+         *              [](const Mastodon::request_record &record)
+         *              {
+         *                  using std::chrono::duration_cast;
+         *                  using std::chrono::milliseconds;
+         *                  cout << record.path << ": "
+         *                       << duration_cast<milliseconds>(
+         *                           record.first_byte - record.sent).count()
+         *                       << " ms until the first byte\n";
+         *              });
+         *          @endcode
+         *
+         *  @param  observer  The observer, or an empty function to remove
+         *                    it.
+         *
+         *  @since  0.112.0
+         */
+        void set_observer(const observer_type &observer);
+
+        /*!
+         *  @brief  Enables or disables the metrics registry.
          *
-         *  @param  call    A call defined in Mastodon::API::v1
-         *  @param  ptr     Pointer to the http object. Can be used to call
-         *                  ptr->cancel_stream()
+         *          The registry counts requests, errors by
+         *          @ref error "error code" and bytes per API::v1 or API::v2
+         *          call, and measures the duration of requests. Calls made
+         *          with a string are counted as `other`. It also counts the
+         *          events of streams and how long after their creation they
+         *          arrived. Disabled by default. Disabling it keeps the
+         *          metrics collected so far.
          *
-         *  @since  0.100.0
+         *  @param  enabled  true to collect metrics.
+         *
+         *  @since  0.112.0
          */
-        void get_stream(const Mastodon::API::v1 &call,
-                        unique_ptr<Mastodon::API::http> &ptr,
-                        string &stream);
+        void set_metrics(const bool enabled);
 
         /*!
-         *  @brief  Make a streaming GET request.
+         *  @brief  Returns the metrics in the Prometheus text format.
          *
-         *  @param  call    String in the form `/api/v1/example`
-         *  @param  ptr     Pointer to the http object. Can be used to call
-         *                  ptr->cancel_stream()
+         *          The durations are summaries with the 0.5, 0.9, 0.99 and
+         *          0.999 quantiles. Example:
+         *          @code
+         *          # TYPE mastodon_cpp_requests_total counter
+         *          mastodon_cpp_requests_total{endpoint="v1::instance"} 2
+         *          @endcode
          *
-         *  @since  0.100.0
+         *  @since  0.112.0
          */
-        void get_stream(const string &call,
-                        unique_ptr<Mastodon::API::http> &ptr,
-                        string &stream);
+        const string get_metrics() const;
 
         /*!
-         *  @brief  Make a PATCH request.
+         *  @brief  Lets concurrent identical GET requests share one request.
          *
-         *          Binary data must be a filename.
+         *          If a GET request to the same path with the same
+         *          parameters is already running, the call waits for it and
+         *          returns a copy of its result. The request is made with
+         *          the timeouts of the thread that started it. Disabled by
+         *          default.
          *
-         *  @param  call        A call defined in Mastodon::API::v1
-         *  @param  parameters  A Mastodon::parametermap containing
-         *                      parameters
+         *  @param  enabled  true to enable.
          *
-         *  @since  0.100.0
+         *  @since  0.112.0
          */
-        return_call patch(const Mastodon::API::v1 &call,
-                          const parameters &parameters);
+        void set_single_flight(const bool enabled);
 
         /*!
-         *  @brief  Make a POST request that doesn't require parameters.
+         *  @brief  Keep answers to GET requests in memory.
          *
-         *  @param  call    A call defined in Mastodon::API::v1
+         *          Answers are cached as long as `Cache-Control` or
+         *          `Expires` allows it. Stale answers with an `ETag` or
+         *          `Last-Modified` header are revalidated with a conditional
+         *          request; if the server answers with 304 Not Modified, the
+         *          cached answer is returned. Disabling the cache empties it.
          *
-         *  @since  0.100.0
+         *          Example:
+         *          @code
+         *          Mastodon::cache_config config;
+         *          config.enabled = true;
+         *          masto.set_cache(config);
+         *          @endcode
+         *
+         *  @param  config  See Mastodon::cache_config.
+         *
+         *  @since  0.112.0
          */
-        return_call post(const Mastodon::API::v1 &call);
+        void set_cache(const cache_config &config);
 
         /*!
-         *  @brief  Make a POST request that requires parameters.
+         *  @brief  Returns the hits, misses and size of the response cache.
          *
-         *          Binary data must be a filename.
+         *  @since  0.112.0
+         */
+        const cache_stats get_cache_stats() const;
+
+        /*!
+         *  @brief  Record requests to a file or replay them from it.
+         *
+         *          Recording captures the answers as the caller sees them,
+         *          after caching, coalescing and retries. Replaying returns
+         *          the recorded answers without touching the network, for
+         *          example to profile the parsing of a captured traffic
+         *          window. Requests that were not recorded fail with
+         *          Mastodon::error::CONNECTION_REFUSED.
+         *
+         *          Example:
+         *          @code
+         *          Mastodon::cassette_config config;
+         *          config.mode = Mastodon::cassette_mode::REPLAY;
+         *          config.file = "timeline.cassette";
+         *          masto.set_cassette(config);
+         *          @endcode
+         *
+         *  @param  config  See Mastodon::cassette_config.
+         *
+         *  @return false if the file could not be opened or read. The
+         *          cassette is switched off then.
+         *
+         *  @since  0.112.0
+         */
+        bool set_cassette(const cassette_config &config);
+
+        /*!
+         *  @brief  Changes the timeouts for the requests the calling thread
+         *          makes, as long as the object exists.
+         *
+         *          Asynchronous calls are not affected.
+         *
+         *          Example:
+         *          @code
+         *          {
+         *              Mastodon::timeout_config timeouts;
+         *              timeouts.total = std::chrono::seconds(5);
+         *              Mastodon::API::scoped_timeouts guard(masto, timeouts);
+         *              masto.get(Mastodon::API::v1::timelines_home);
+         *          }
+         *          @endcode
+         *
+         *  @since  0.112.0
+         */
+        class scoped_timeouts
+        {
+        public:
+            /*!
+             *  @brief  Sets the timeouts.
+             *
+             *  @param  api       The API object.
+             *  @param  timeouts  The timeouts for requests from this thread.
+             */
+            explicit scoped_timeouts(API &api, const timeout_config &timeouts);
+
+            /*!
+             *  @brief  Restores the previous timeouts.
+             */
+            ~scoped_timeouts();
+
+            scoped_timeouts(const scoped_timeouts &) = delete;
+            scoped_timeouts &operator=(const scoped_timeouts &) = delete;
+
+        private:
+            API &_api;
+            timeout_config _previous;
+            bool _had_previous;
+        };
+
+        /*!
+         *  @brief  Make a GET request that doesn't require parameters.
+         *
+         *  @param  call    A call defined in Mastodon::API::v1
+         *
+         *  @since  0.100.0
+         */
+        return_call get(const Mastodon::API::v1 &call);
+
+        /*!
+         *  @brief  Make a GET request that requires parameters.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.100.0
+         */
+        return_call get(const Mastodon::API::v1 &call,
+                        const parameters &parameters);
+
+        /*!
+         *  @brief  Make a GET request that requires parameters.
+         *
+         *  @param  call        A call defined in Mastodon::API::v2
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.100.0
+         */
+        return_call get(const Mastodon::API::v2 &call,
+                        const parameters &parameters);
+
+        /*!
+         *  @brief  Make a custom GET request.
+         *
+         *  @param  call    String in the form `/api/v1/example`
+         *
+         *  @since  0.100.0
+         */
+        return_call get(const string &call);
+
+        /*!
+         *  @brief  Make a custom GET request and pass the body to sink.
+         *
+         *          The body is not stored in memory, use this for large
+         *          answers like media files. If the request is not
+         *          successful, the body is in return_call::answer instead.
+         *
+         *  @param  call    String in the form `/api/v1/example`
+         *  @param  sink    Called with every piece of the body.
+         *
+         *  @since  0.112.0
+         */
+        return_call get(const string &call, const sink_type &sink);
+
+        /*!
+         *  @brief  Make a custom GET request and write the body to out.
+         *
+         *          Example:
+         *          @code
+         *          std::ofstream file("image.png", std::ios::binary);
+         *          masto.get("/system/media_attachments/…/image.png", file);
+         *          @endcode
+         *
+         *  @param  call    String in the form `/api/v1/example`
+         *  @param  out     The body is written to this stream.
+         *
+         *  @since  0.112.0
+         */
+        return_call get(const string &call, std::ostream &out);
+
+        /*!
+         *  @brief  Make a streaming GET request.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  ptr         Pointer to the http object. Can be used to call
+         *                      ptr->cancel_stream()
+         *
+         *  @since  0.100.0
+         */
+        void get_stream(const Mastodon::API::v1 &call,
+                        const parameters &parameters,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        string &stream);
+
+        /*!
+         *  @brief  Make a streaming GET request.
+         *
+         *  @param  call    A call defined in Mastodon::API::v1
+         *  @param  ptr     Pointer to the http object. Can be used to call
+         *                  ptr->cancel_stream()
+         *
+         *  @since  0.100.0
+         */
+        void get_stream(const Mastodon::API::v1 &call,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        string &stream);
+
+        /*!
+         *  @brief  Make a streaming GET request.
+         *
+         *  @param  call    String in the form `/api/v1/example`
+         *  @param  ptr     Pointer to the http object. Can be used to call
+         *                  ptr->cancel_stream()
+         *
+         *  @since  0.100.0
+         */
+        void get_stream(const string &call,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        string &stream);
+
+        /*!
+         *  @brief  Make a streaming GET request and pass every event to
+         *          callback as soon as it is complete.
+         *
+         *          There is no need to poll or lock anything. Errors are
+         *          passed as events named `ERROR`, like in the other
+         *          overloads. If the server closes the stream, an `ERROR`
+         *          event with error_code 0 is passed. See
+         *          Easy::managed_stream for streams that reconnect.
+         *
+         *          callback may call ptr->cancel_stream(), but must not
+         *          destroy ptr.
+         *
+         *          Example:
+         *          @code
+         *          std::unique_ptr<Mastodon::API::http> ptr;
+         *          masto.get_stream(Mastodon::API::v1::streaming_public, {},
+         *                           ptr,
+         *                           [](const Mastodon::sse_event &event)
+         *                           {
+         *                               if (event.is("update"))
+         *                               {
+         *                                   // ...
+         *                               }
+         *                           });
+         *          @endcode
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  ptr         Pointer to the http object. Can be used to call
+         *                      ptr->cancel_stream()
+         *  @param  callback    Receives the events.
+         *  @param  executor    Runs callback, with a copy of the event. Events
+         *                      arrive out of order if the executor runs tasks
+         *                      in parallel. If empty, callback is called in the
+         *                      thread of the stream.
+         *
+         *  @since  0.112.0
+         */
+        void get_stream(const Mastodon::API::v1 &call,
+                        const parameters &parameters,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        const stream_callback_type &callback,
+                        const executor_type &executor = executor_type());
+
+        /*!
+         *  @brief  Make a streaming GET request and pass every event to
+         *          callback as soon as it is complete.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  ptr         Pointer to the http object. Can be used to call
+         *                      ptr->cancel_stream()
+         *  @param  callback    Receives the events.
+         *  @param  executor    Runs callback. If empty, callback is called in
+         *                      the thread of the stream.
+         *
+         *  @since  0.112.0
+         */
+        void get_stream(const Mastodon::API::v1 &call,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        const stream_callback_type &callback,
+                        const executor_type &executor = executor_type());
+
+        /*!
+         *  @brief  Make a streaming GET request and pass every event to
+         *          callback as soon as it is complete.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  ptr         Pointer to the http object. Can be used to call
+         *                      ptr->cancel_stream()
+         *  @param  callback    Receives the events.
+         *  @param  executor    Runs callback. If empty, callback is called in
+         *                      the thread of the stream.
+         *
+         *  @since  0.112.0
+         */
+        void get_stream(const string &call,
+                        unique_ptr<Mastodon::API::http> &ptr,
+                        const stream_callback_type &callback,
+                        const executor_type &executor = executor_type());
+
+        /*!
+         *  @brief  Make a streaming GET request that is read by the stream
+         *          threads of this object.
+         *
+         *          Unlike get_stream(), streams don't need a thread each,
+         *          see set_stream_threads(). The connection is established
+         *          in the calling thread. Errors are passed as events named
+         *          `ERROR`, like in get_stream(). Only available on Linux.
+         *
+         *          Example:
+         *          @code
+         *          const std::uint64_t id = masto.subscribe_stream(
+         *              Mastodon::API::v1::streaming_public, {},
+         *              [](const Mastodon::sse_event &event)
+         *              {
+         *                  // ...
+         *              });
+         *          // ...
+         *          masto.unsubscribe_stream(id);
+         *          @endcode
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Receives the events. Callbacks of streams in
+         *                      the same thread are not called concurrently,
+         *                      a slow callback delays the other streams.
+         *
+         *  @return ID for unsubscribe_stream(), 0 if the stream could not
+         *          be opened.
+         *
+         *  @since  0.112.0
+         */
+        std::uint64_t subscribe_stream(const Mastodon::API::v1 &call,
+                                       const parameters &parameters,
+                                       const stream_callback_type &callback);
+
+        /*!
+         *  @brief  Make a streaming GET request that is read by the stream
+         *          threads of this object.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  callback    Receives the events.
+         *
+         *  @return ID for unsubscribe_stream(), 0 if the stream could not
+         *          be opened.
+         *
+         *  @since  0.112.0
+         */
+        std::uint64_t subscribe_stream(const Mastodon::API::v1 &call,
+                                       const stream_callback_type &callback);
+
+        /*!
+         *  @brief  Make a streaming GET request that is read by the stream
+         *          threads of this object.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  callback    Receives the events.
+         *
+         *  @return ID for unsubscribe_stream(), 0 if the stream could not
+         *          be opened.
+         *
+         *  @since  0.112.0
+         */
+        std::uint64_t subscribe_stream(const string &call,
+                                       const stream_callback_type &callback);
+
+        /*!
+         *  @brief  Close a stream opened with subscribe_stream().
+         *
+         *          callback is not called after this returns, unless this is
+         *          called from a callback. Unknown IDs are ignored.
+         *
+         *  @since  0.112.0
+         */
+        void unsubscribe_stream(const std::uint64_t id);
+
+        /*!
+         *  @brief  Sets the number of threads that read the streams opened
+         *          with subscribe_stream(). The default is 1.
+         *
+         *          New streams go to the thread with the fewest streams.
+         *          If the number is reduced, surplus threads keep their
+         *          streams.
+         *
+         *  @param  threads  Number of threads.
+         *
+         *  @since  0.112.0
+         */
+        void set_stream_threads(const std::size_t threads);
+
+        /*!
+         *  @brief  Make a PATCH request.
+         *
+         *          Binary data must be a filename.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.100.0
+         */
+        return_call patch(const Mastodon::API::v1 &call,
+                          const parameters &parameters);
+
+        /*!
+         *  @brief  Make a POST request that doesn't require parameters.
+         *
+         *  @param  call    A call defined in Mastodon::API::v1
+         *
+         *  @since  0.100.0
+         */
+        return_call post(const Mastodon::API::v1 &call);
+
+        /*!
+         *  @brief  Make a POST request that requires parameters.
+         *
+         *          Binary data must be a filename.
          *
          *  @param  call        A call defined in Mastodon::API::v1
          *  @param  parameters  A Mastodon::parametermap containing
@@ -641,12 +1588,377 @@ namespace Mastodon
          */
         return_call del(const string &call, const parameters &parameters);
 
-    private:
-        const string _instance;
-        string _access_token;
-        string _useragent;
-        http _http;
-        bool _exceptions;
+        /*!
+         *  @brief  Function that is called with the result of an
+         *          asynchronous call.
+         *
+         *  @since  0.112.0
+         */
+        using callback_type = std::function<void(const return_call &)>;
+
+        /*!
+         *  @brief  Sets the number of threads used for asynchronous calls.
+         *
+         *          All asynchronous calls of this object share these threads.
+         *          Calls are queued if all threads are busy. The default is 4.
+         *
+         *  @param  threads  Number of threads.
+         *
+         *  @since  0.112.0
+         */
+        void set_async_threads(const std::size_t threads);
+
+        /*!
+         *  @brief  Make an asynchronous GET request that doesn't require
+         *          parameters.
+         *
+         *          The request is made in a thread owned by this object.
+         *          Exceptions are stored in the future if
+         *          exceptions(true) was called.
+         *
+         *  @param  call    A call defined in Mastodon::API::v1
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> get_async(const Mastodon::API::v1 &call);
+
+        /*!
+         *  @brief  Make an asynchronous GET request that requires parameters.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> get_async(const Mastodon::API::v1 &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous GET request that requires parameters.
+         *
+         *  @param  call        A call defined in Mastodon::API::v2
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> get_async(const Mastodon::API::v2 &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous custom GET request.
+         *
+         *  @param  call    String in the form `/api/v1/example`
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> get_async(const string &call);
+
+        /*!
+         *  @brief  Make an asynchronous GET request and call callback with
+         *          the result.
+         *
+         *          The callback is called from a thread owned by this object.
+         *          Exceptions are reported as error::UNKNOWN. Don't wait for
+         *          other asynchronous calls inside the callback.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void get_async(const Mastodon::API::v1 &call,
+                       const parameters &parameters,
+                       const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous GET request and call callback with
+         *          the result.
+         *
+         *  @param  call        A call defined in Mastodon::API::v2
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void get_async(const Mastodon::API::v2 &call,
+                       const parameters &parameters,
+                       const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous custom GET request and call callback
+         *          with the result.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void get_async(const string &call, const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous PATCH request.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> patch_async(const Mastodon::API::v1 &call,
+                                             const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous PATCH request and call callback with
+         *          the result.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void patch_async(const Mastodon::API::v1 &call,
+                         const parameters &parameters,
+                         const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous POST request that doesn't require
+         *          parameters.
+         *
+         *  @param  call    A call defined in Mastodon::API::v1
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> post_async(const Mastodon::API::v1 &call);
+
+        /*!
+         *  @brief  Make an asynchronous POST request that requires
+         *          parameters.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> post_async(const Mastodon::API::v1 &call,
+                                            const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous custom POST request.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> post_async(const string &call,
+                                            const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous POST request and call callback with
+         *          the result.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void post_async(const Mastodon::API::v1 &call,
+                        const parameters &parameters,
+                        const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous custom POST request and call callback
+         *          with the result.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void post_async(const string &call, const parameters &parameters,
+                        const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous PUT request.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> put_async(const Mastodon::API::v1 &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous custom PUT request.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> put_async(const string &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous PUT request and call callback with
+         *          the result.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void put_async(const Mastodon::API::v1 &call,
+                       const parameters &parameters,
+                       const callback_type &callback);
+
+        /*!
+         *  @brief  Make an asynchronous DELETE request.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> del_async(const Mastodon::API::v1 &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous custom DELETE request.
+         *
+         *  @param  call        String in the form `/api/v1/example`
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> del_async(const string &call,
+                                           const parameters &parameters);
+
+        /*!
+         *  @brief  Make an asynchronous DELETE request and call callback with
+         *          the result.
+         *
+         *  @param  call        A call defined in Mastodon::API::v1
+         *  @param  parameters  A Mastodon::parametermap containing
+         *                      parameters
+         *  @param  callback    Called with the result.
+         *
+         *  @since  0.112.0
+         */
+        void del_async(const Mastodon::API::v1 &call,
+                       const parameters &parameters,
+                       const callback_type &callback);
+
+        /*!
+         *  @brief  A call and its parameters. Used in get_batch().
+         *
+         *  @since  0.112.0
+         */
+        using batch_call = std::pair<Mastodon::API::v1, parameters>;
+
+        /*!
+         *  @brief  Function that is called with the index and the result of
+         *          each call in get_batch().
+         *
+         *  @since  0.112.0
+         */
+        using batch_callback_type =
+            std::function<void(const std::size_t index, const return_call &)>;
+
+        /*!
+         *  @brief  Make many GET requests concurrently.
+         *
+         *          At most max_in_flight requests are made at the same time.
+         *          All requests share the connection pool, lower
+         *          connection_pool_config::max_per_host to limit the
+         *          connections to the instance.
+         *
+         *          Example:
+         *          @code
+         *          std::vector<API::batch_call> calls;
+         *          for (const string &id : ids)
+         *          {
+         *              calls.push_back({ API::v1::accounts_id,
+         *                                { { "id", { id } } } });
+         *          }
+         *          for (const return_call &ret : masto.get_batch(calls))
+         *          {
+         *              cout << ret << endl;
+         *          }
+         *          @endcode
+         *
+         *  @param  calls          The calls to make.
+         *  @param  max_in_flight  Maximum number of simultaneous requests.
+         *
+         *  @return The results, in the same order as calls.
+         *
+         *  @since  0.112.0
+         */
+        const vector<return_call> get_batch(
+            const vector<batch_call> &calls,
+            const std::size_t max_in_flight = 8);
+
+        /*!
+         *  @brief  Make many GET requests concurrently and call callback as
+         *          soon as each one is complete.
+         *
+         *          The callback is never called twice at the same time.
+         *          Returns after all calls are finished. If exceptions are
+         *          turned on, the first exception is rethrown after the
+         *          running requests are finished; the remaining calls are
+         *          not made.
+         *
+         *  @param  calls          The calls to make.
+         *  @param  callback       Called with the index in calls and the
+         *                         result.
+         *  @param  max_in_flight  Maximum number of simultaneous requests.
+         *
+         *  @since  0.112.0
+         */
+        void get_batch(const vector<batch_call> &calls,
+                       const batch_callback_type &callback,
+                       const std::size_t max_in_flight = 8);
+
+    protected:
+        /*!
+         *  @brief  Call task for every index from 0 to count - 1, with up
+         *          to max_in_flight calls at the same time.
+         *
+         *          The calling thread takes part. No new tasks are started
+         *          after a task returned false or threw an exception. The
+         *          first exception is rethrown after the running tasks are
+         *          finished.
+         *
+         *  @param  count          Number of tasks.
+         *  @param  max_in_flight  Maximum number of simultaneous tasks.
+         *  @param  task           Called with the index, returns false to
+         *                         stop.
+         *
+         *  @since  0.112.0
+         */
+        void run_parallel(
+            const std::size_t count, const std::size_t max_in_flight,
+            const std::function<bool(const std::size_t index)> &task);
 
         /*!
          *  @brief  Converts map of parameters into a string.
@@ -668,6 +1980,54 @@ namespace Mastodon
          */
         unique_ptr<HTMLForm> maptoformdata(const parameters &map);
 
+    private:
+        const string _instance;
+        string _access_token;
+        string _useragent;
+        // Guards _access_token and _useragent.
+        mutable std::mutex _settings_mutex;
+        http _http;
+        std::atomic<bool> _exceptions;
+        std::size_t _async_threads;
+        std::mutex _async_mutex;
+        // Declared after _http, so that queued requests finish first.
+        unique_ptr<thread_pool> _thread_pool;
+        std::size_t _stream_threads;
+        std::mutex _multiplexer_mutex;
+        // Declared after _http, so that streams are closed first.
+        unique_ptr<stream_multiplexer> _multiplexer;
+
+        /*!
+         *  @brief  Run call in the thread pool.
+         *
+         *  @since  0.112.0
+         */
+        std::future<return_call> run_async(
+            const std::function<return_call()> &call);
+
+        /*!
+         *  @brief  Run call in the thread pool and pass the result to
+         *          callback.
+         *
+         *  @since  0.112.0
+         */
+        void run_async(const std::function<return_call()> &call,
+                       const callback_type &callback);
+
+        /*!
+         *  @brief  Returns the thread pool, starts it if necessary.
+         *
+         *  @since  0.112.0
+         */
+        thread_pool &get_thread_pool();
+
+        /*!
+         *  @brief  Returns the stream multiplexer, starts it if necessary.
+         *
+         *  @since  0.112.0
+         */
+        stream_multiplexer &get_multiplexer();
+
         /*!
          *  @brief  Delete Mastodon::param from Mastodon::parameters.
          *
@@ -682,6 +2042,119 @@ namespace Mastodon
                                        const vector<string> &keys);
     };
 
+    /*!
+     *  @brief  Timing and size of a request, see API::set_observer().
+     *
+     *          Time points are taken from std::chrono::steady_clock. Phases
+     *          that did not happen are set to the end of the phase before
+     *          them, for example DNS, connect and TLS on reused
+     *          connections. Phases after an error are not set.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct request_record
+    {
+        using clock = std::chrono::steady_clock;
+
+        /*!
+         *  @brief  The HTTP method.
+         */
+        http_method method = http_method::GET;
+
+        /*!
+         *  @brief  The path, including the query string.
+         */
+        string path;
+
+        /*!
+         *  @brief  1 if the call was made with an API::v1, 2 if it was made
+         *          with an API::v2 and 0 if it was made with a string.
+         */
+        std::uint8_t api_version = 0;
+
+        /*!
+         *  @brief  The call, if api_version is 1.
+         */
+        API::v1 call_v1 = {};
+
+        /*!
+         *  @brief  The call, if api_version is 2.
+         */
+        API::v2 call_v2 = {};
+
+        /*!
+         *  @brief  The attempt started.
+         */
+        clock::time_point start;
+
+        /*!
+         *  @brief  The rate limit allowed the request and a connection was
+         *          taken from the pool.
+         */
+        clock::time_point queued;
+
+        /*!
+         *  @brief  The address of the instance was resolved.
+         */
+        clock::time_point dns;
+
+        /*!
+         *  @brief  The TCP connection was established.
+         */
+        clock::time_point connect;
+
+        /*!
+         *  @brief  The TLS handshake was finished.
+         */
+        clock::time_point tls;
+
+        /*!
+         *  @brief  The request was sent.
+         */
+        clock::time_point sent;
+
+        /*!
+         *  @brief  The header of the answer was received.
+         */
+        clock::time_point first_byte;
+
+        /*!
+         *  @brief  The body of the answer was received.
+         */
+        clock::time_point end;
+
+        /*!
+         *  @brief  Size of the request header and body.
+         */
+        std::uint64_t bytes_sent = 0;
+
+        /*!
+         *  @brief  Size of the answer header and body, before
+         *          decompression.
+         */
+        std::uint64_t bytes_received = 0;
+
+        /*!
+         *  @brief  HTTP status of the answer, 0 if there was none.
+         */
+        std::uint16_t http_status = 0;
+
+        /*!
+         *  @brief  @ref error "Error code".
+         */
+        std::uint8_t error_code = 0;
+
+        /*!
+         *  @brief  Number of attempts before this one.
+         */
+        std::uint8_t retries = 0;
+
+        /*!
+         *  @brief  true if a connection that was already open was used.
+         */
+        bool reused = false;
+    } request_record;
+
     /*!
      *  @brief  Percent-encodes a string.
      *
@@ -726,6 +2199,54 @@ namespace Mastodon
      *  @since  0.105.0
      */
     const string unescape_html(const string &html);
+
+    /*!
+     *  @brief  Sets which messages mastodon-cpp logs.
+     *
+     *          The level is the same for all API objects and can be
+     *          changed at any time. It starts with the value of the
+     *          environment variable `MASTODON_CPP_LOG_LEVEL` (`off`,
+     *          `error`, `warning`, `info` or `trace`). If that is not set,
+     *          nothing is logged, unless mastodon-cpp was compiled with
+     *          `-DDEBUG`. `trace` logs every request.
+     *
+     *  @param  level  The most verbose level that is logged.
+     *
+     *  @since  0.112.0
+     */
+    void set_log_level(const log_level level);
+
+    /*!
+     *  @brief  Returns the current log level.
+     *
+     *  @since  0.112.0
+     */
+    log_level get_log_level();
+
+    /*!
+     *  @brief  Sets the function that receives log messages.
+     *
+     *          The sink is called from the thread that logged the message,
+     *          possibly from several threads at once, and must not throw.
+     *          Messages are put together in a buffer of the logging thread
+     *          and passed on in one piece. The default sink writes every
+     *          message as one line to stderr.
+     *
+     *          Example:
+     *          @code
+     *          Mastodon::set_log_level(Mastodon::log_level::INFO);
+     *          Mastodon::set_log_sink(
+     *              [](const Mastodon::log_record &record)
+     *              {
+     *                  syslog(LOG_INFO, "%s", record.message.c_str());
+     *              });
+     *          @endcode
+     *
+     *  @param  sink  The sink, or an empty function for the default sink.
+     *
+     *  @since  0.112.0
+     */
+    void set_log_sink(const log_sink_type &sink);
 }
 
 #endif
@@ -0,0 +1,476 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <locale>
+#include <algorithm>
+#include <cmath>
+#include "metrics.hpp"
+#include "rate_limiter.hpp"
+
+using namespace Mastodon;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+namespace
+{
+    // Names of API::v1, in the same order.
+    const char *const v1_names[] =
+    {
+        "accounts_id",
+        "accounts",
+        "accounts_verify_credentials",
+        "accounts_update_credentials",
+        "accounts_id_followers",
+        "accounts_id_following",
+        "accounts_id_statuses",
+        "accounts_id_follow",
+        "accounts_id_unfollow",
+        "accounts_relationships",
+        "accounts_search",
+        "apps",
+        "apps_verify_credentials",
+        "blocks",
+        "accounts_id_block",
+        "accounts_id_unblock",
+        "custom_emojis",
+        "domain_blocks",
+        "endorsements",
+        "accounts_id_pin",
+        "accounts_id_unpin",
+        "favourites",
+        "statuses_id_favourite",
+        "statuses_id_unfavourite",
+        "filters",
+        "filters_id",
+        "follow_requests",
+        "follow_requests_id_authorize",
+        "follow_requests_id_reject",
+        "suggestions",
+        "suggestions_accountid",
+        "instance",
+        "lists",
+        "accounts_id_lists",
+        "lists_id_accounts",
+        "lists_id",
+        "media",
+        "media_id",
+        "mutes",
+        "accounts_id_mute",
+        "accounts_id_unmute",
+        "statuses_id_mute",
+        "statuses_id_unmute",
+        "notifications",
+        "notifications_id",
+        "notifications_clear",
+        "notifications_dismiss",
+        "push_subscription",
+        "polls_id",
+        "polls_id_votes",
+        "reports",
+        "statuses_id",
+        "statuses_id_context",
+        "statuses_id_card",
+        "statuses_id_reblogged_by",
+        "statuses_id_favourited_by",
+        "statuses",
+        "statuses_id_reblog",
+        "statuses_id_unreblog",
+        "statuses_id_pin",
+        "statuses_id_unpin",
+        "timelines_home",
+        "conversations",
+        "timelines_public",
+        "timelines_tag_hashtag",
+        "timelines_list_list_id",
+        "streaming_health",
+        "streaming_user",
+        "streaming_public",
+        "streaming_public_local",
+        "streaming_hashtag",
+        "streaming_hashtag_local",
+        "streaming_list",
+        "streaming_direct",
+        "bookmarks",
+        "statuses_id_bookmark",
+        "statuses_id_unbookmark",
+    };
+    static_assert(sizeof(v1_names) / sizeof(*v1_names)
+                  == static_cast<std::size_t>(
+                      API::v1::statuses_id_unbookmark) + 1,
+                  "v1_names must have one name for every API::v1");
+
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+}
+
+histogram::histogram()
+: _buckets()
+, _count(0)
+, _sum(0)
+, _max(0)
+{}
+
+std::size_t histogram::index_of(const std::uint64_t value)
+{
+    if (value < 2 * sub_buckets)
+    {
+        return static_cast<std::size_t>(value);
+    }
+
+    // The 5 highest bits of value select the bucket.
+    std::size_t shift = 0;
+    while ((value >> shift) >= 2 * sub_buckets)
+    {
+        ++shift;
+    }
+    if (shift > max_shift)
+    {
+        return (max_shift + 2) * sub_buckets - 1;
+    }
+
+    return shift * sub_buckets + static_cast<std::size_t>(value >> shift);
+}
+
+std::uint64_t histogram::value_of(const std::size_t index)
+{
+    if (index < 2 * sub_buckets)
+    {
+        return index;
+    }
+
+    // The middle of the bucket.
+    const std::size_t shift = index / sub_buckets - 1;
+    const std::uint64_t lower = static_cast<std::uint64_t>(
+        index % sub_buckets + sub_buckets) << shift;
+    return lower + (std::uint64_t(1) << shift) / 2;
+}
+
+void histogram::add(const std::uint64_t value)
+{
+    ++_buckets[index_of(value)];
+    ++_count;
+    _sum += value;
+    _max = std::max(_max, value);
+}
+
+std::uint64_t histogram::percentile(const double quantile) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+
+    const std::uint64_t wanted = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(std::ceil(quantile * _count)), 1);
+    std::uint64_t seen = 0;
+    for (std::size_t index = 0; index < _buckets.size(); ++index)
+    {
+        seen += _buckets[index];
+        if (seen >= wanted)
+        {
+            return std::min(value_of(index), _max);
+        }
+    }
+
+    return _max;
+}
+
+std::uint64_t histogram::count() const
+{
+    return _count;
+}
+
+std::uint64_t histogram::sum() const
+{
+    return _sum;
+}
+
+metrics_registry::metrics_registry()
+: _enabled(false)
+, _stream_events(0)
+, _events_per_second()
+, _event_seconds()
+{}
+
+void metrics_registry::set_enabled(const bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool metrics_registry::enabled() const
+{
+    return _enabled;
+}
+
+void metrics_registry::record(const request_record &record)
+{
+    const clock::time_point end = (record.end != clock::time_point()
+                                   ? record.end : clock::now());
+    const auto latency = duration_cast<microseconds>(end - record.start);
+    const string name = endpoint_name(record);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    endpoint_metrics &metrics = _endpoints[name];
+    ++metrics.requests;
+    if (record.error_code != 0)
+    {
+        ++metrics.errors[record.error_code];
+    }
+    metrics.bytes_sent += record.bytes_sent;
+    metrics.bytes_received += record.bytes_received;
+    metrics.latency.add(static_cast<std::uint64_t>(
+                            std::max<microseconds::rep>(latency.count(), 0)));
+}
+
+std::int64_t metrics_registry::seconds_now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        clock::now().time_since_epoch()).count();
+}
+
+void metrics_registry::stream_event(const milliseconds lag)
+{
+    const std::int64_t second = seconds_now();
+    const std::size_t slot = static_cast<std::size_t>(second) % rate_window;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stream_events;
+    if (_event_seconds[slot] != second)
+    {
+        _event_seconds[slot] = second;
+        _events_per_second[slot] = 0;
+    }
+    ++_events_per_second[slot];
+
+    if (lag.count() >= 0)
+    {
+        _stream_lag.add(static_cast<std::uint64_t>(lag.count()));
+    }
+}
+
+const string metrics_registry::endpoint_name(const request_record &record)
+{
+    switch (record.api_version)
+    {
+    case 1:
+    {
+        return string("v1::")
+            + v1_names[static_cast<std::size_t>(record.call_v1)];
+    }
+    case 2:
+    {
+        return "v2::search";
+    }
+    default:
+    {
+        return "other";
+    }
+    }
+}
+
+const string metrics_registry::error_name(const std::uint8_t code)
+{
+    switch (static_cast<error>(code))
+    {
+    case error::OK:
+    {
+        return "OK";
+    }
+    case error::INVALID_ARGUMENT:
+    {
+        return "INVALID_ARGUMENT";
+    }
+    case error::URL_CHANGED:
+    {
+        return "URL_CHANGED";
+    }
+    case error::CONNECTION_TIMEOUT:
+    {
+        return "CONNECTION_TIMEOUT";
+    }
+    case error::CONNECTION_REFUSED:
+    {
+        return "CONNECTION_REFUSED";
+    }
+    case error::DNS:
+    {
+        return "DNS";
+    }
+    case error::ENCRYPTION:
+    {
+        return "ENCRYPTION";
+    }
+    default:
+    {
+        return "UNKNOWN";
+    }
+    }
+}
+
+const string metrics_registry::render() const
+{
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out.precision(9);
+
+    // Writes # HELP and # TYPE lines.
+    auto header = [&out](const string &name, const string &type,
+                         const string &help)
+    {
+        out << "# HELP " << name << ' ' << help << '\n'
+            << "# TYPE " << name << ' ' << type << '\n';
+    };
+
+    // Writes the quantiles, sum and count of a histogram.
+    auto summary = [&out](const string &name, const string &labels,
+                          const histogram &values, const double unit)
+    {
+        const string separator = (labels.empty() ? "" : ",");
+        for (const double quantile : quantiles)
+        {
+            out << name << '{' << labels << separator << "quantile=\""
+                << quantile << "\"} "
+                << static_cast<double>(values.percentile(quantile)) / unit
+                << '\n';
+        }
+
+        const string braces = (labels.empty() ? "" : '{' + labels + '}');
+        out << name << "_sum" << braces << ' '
+            << static_cast<double>(values.sum()) / unit << '\n'
+            << name << "_count" << braces << ' ' << values.count() << '\n';
+    };
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    header("mastodon_cpp_requests_total", "counter",
+           "Requests made, every attempt is counted.");
+    for (const auto &endpoint : _endpoints)
+    {
+        out << "mastodon_cpp_requests_total{endpoint=\"" << endpoint.first
+            << "\"} " << endpoint.second.requests << '\n';
+    }
+
+    header("mastodon_cpp_errors_total", "counter",
+           "Failed requests by error code.");
+    for (const auto &endpoint : _endpoints)
+    {
+        for (const auto &error : endpoint.second.errors)
+        {
+            out << "mastodon_cpp_errors_total{endpoint=\"" << endpoint.first
+                << "\",error=\"" << error_name(error.first) << "\"} "
+                << error.second << '\n';
+        }
+    }
+
+    header("mastodon_cpp_sent_bytes_total", "counter",
+           "Bytes sent in requests.");
+    for (const auto &endpoint : _endpoints)
+    {
+        out << "mastodon_cpp_sent_bytes_total{endpoint=\"" << endpoint.first
+            << "\"} " << endpoint.second.bytes_sent << '\n';
+    }
+
+    header("mastodon_cpp_received_bytes_total", "counter",
+           "Bytes received in answers, before decompression.");
+    for (const auto &endpoint : _endpoints)
+    {
+        out << "mastodon_cpp_received_bytes_total{endpoint=\""
+            << endpoint.first << "\"} " << endpoint.second.bytes_received
+            << '\n';
+    }
+
+    header("mastodon_cpp_request_duration_seconds", "summary",
+           "Duration of requests, including the wait for the rate limit.");
+    for (const auto &endpoint : _endpoints)
+    {
+        summary("mastodon_cpp_request_duration_seconds",
+                "endpoint=\"" + endpoint.first + '"',
+                endpoint.second.latency, 1000000.0);
+    }
+
+    header("mastodon_cpp_stream_events_total", "counter",
+           "Events received in streams.");
+    out << "mastodon_cpp_stream_events_total " << _stream_events << '\n';
+
+    // Average of the last complete seconds.
+    const std::int64_t now = seconds_now();
+    std::uint64_t recent = 0;
+    for (std::size_t slot = 0; slot < rate_window; ++slot)
+    {
+        const std::int64_t age = now - _event_seconds[slot];
+        if (age >= 1 && age <= static_cast<std::int64_t>(rate_window))
+        {
+            recent += _events_per_second[slot];
+        }
+    }
+    header("mastodon_cpp_stream_events_per_second", "gauge",
+           "Events received in streams per second, averaged over "
+           + std::to_string(rate_window) + " seconds.");
+    out << "mastodon_cpp_stream_events_per_second "
+        << static_cast<double>(recent) / rate_window << '\n';
+
+    header("mastodon_cpp_stream_lag_seconds", "summary",
+           "Time between the creation of an event and its arrival.");
+    summary("mastodon_cpp_stream_lag_seconds", "", _stream_lag, 1000.0);
+
+    return out.str();
+}
+
+void metrics_registry::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _endpoints.clear();
+    _stream_events = 0;
+    _stream_lag = histogram();
+    _events_per_second.fill(0);
+    _event_seconds.fill(0);
+}
+
+stream_meter::stream_meter(metrics_registry &registry)
+: _registry(registry)
+, _parser([this](const sse_event &e) { event(e); })
+{}
+
+void stream_meter::feed(const char *data, const std::size_t size)
+{
+    _parser.feed(data, size);
+}
+
+void stream_meter::event(const sse_event &event)
+{
+    static const string key = "\"created_at\":\"";
+    const char *const end = event.data + event.data_size;
+    milliseconds lag(-1);
+
+    const char *start = std::search(event.data, end, key.begin(), key.end());
+    if (start != end)
+    {
+        start += key.size();
+        const char *const quote = std::find(start, end, '"');
+        rate_limiter::clock::time_point created;
+        if (quote != end
+            && rate_limiter::parse_time(string(start, quote), created))
+        {
+            // The clock of the server may be ahead of ours.
+            lag = std::max(duration_cast<milliseconds>(
+                               rate_limiter::clock::now() - created),
+                           milliseconds(0));
+        }
+    }
+
+    _registry.stream_event(lag);
+}
@@ -0,0 +1,172 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_METRICS_HPP
+#define MASTODON_CPP_METRICS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "mastodon-cpp.hpp"
+#include "sse_parser.hpp"
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Histogram with logarithmic buckets, like HdrHistogram.
+     *
+     *          Every power of 2 is divided into 16 buckets, so percentiles
+     *          are at most about 3 % off. Values are whole numbers, for
+     *          example microseconds.
+     *
+     *  @since  0.112.0
+     */
+    class histogram
+    {
+    public:
+        histogram();
+
+        /*!
+         *  @brief  Add a value.
+         */
+        void add(const std::uint64_t value);
+
+        /*!
+         *  @brief  Returns the value that quantile of all values are
+         *          smaller than or equal to. 0 if there are no values.
+         *
+         *  @param  quantile  Between 0 and 1.
+         */
+        std::uint64_t percentile(const double quantile) const;
+
+        std::uint64_t count() const;
+        std::uint64_t sum() const;
+
+    private:
+        static constexpr std::size_t sub_buckets = 16;
+        static constexpr std::size_t max_shift = 40;
+        std::array<std::uint64_t, (max_shift + 2) * sub_buckets> _buckets;
+        std::uint64_t _count;
+        std::uint64_t _sum;
+        std::uint64_t _max;
+
+        static std::size_t index_of(const std::uint64_t value);
+        static std::uint64_t value_of(const std::size_t index);
+    };
+
+    /*!
+     *  @brief  Collects metrics of requests and streams and renders them
+     *          in the Prometheus text format. Used by API::http.
+     *
+     *          Requests are counted per API::v1 or API::v2 call. Calls made
+     *          with a string are counted as `other`.
+     *
+     *  @since  0.112.0
+     */
+    class metrics_registry
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        metrics_registry();
+
+        void set_enabled(const bool enabled);
+        bool enabled() const;
+
+        /*!
+         *  @brief  Count a request.
+         */
+        void record(const request_record &record);
+
+        /*!
+         *  @brief  Count an event of a stream.
+         *
+         *  @param  lag  How long ago the event happened, negative if not
+         *               known.
+         */
+        void stream_event(const std::chrono::milliseconds lag);
+
+        /*!
+         *  @brief  Render all metrics in the Prometheus text format.
+         */
+        const string render() const;
+
+        /*!
+         *  @brief  Forget all metrics.
+         */
+        void clear();
+
+    private:
+        typedef struct endpoint_metrics
+        {
+            std::uint64_t requests = 0;
+            std::map<std::uint8_t, std::uint64_t> errors;
+            std::uint64_t bytes_sent = 0;
+            std::uint64_t bytes_received = 0;
+            histogram latency;  // Microseconds.
+        } endpoint_metrics;
+
+        static constexpr std::size_t rate_window = 10;
+
+        std::atomic<bool> _enabled;
+        mutable std::mutex _mutex;
+        std::map<string, endpoint_metrics> _endpoints;
+        std::uint64_t _stream_events;
+        histogram _stream_lag;  // Milliseconds.
+        // Events of the last seconds, and the second they were counted in.
+        std::array<std::uint64_t, rate_window> _events_per_second;
+        std::array<std::int64_t, rate_window> _event_seconds;
+
+        static std::int64_t seconds_now();
+        static const string endpoint_name(const request_record &record);
+        static const string error_name(const std::uint8_t code);
+    };
+
+    /*!
+     *  @brief  Finds the events in the data of a stream and passes them to
+     *          metrics_registry::stream_event().
+     *
+     *          The lag is taken from the first `created_at` in the data of
+     *          an event.
+     *
+     *  @since  0.112.0
+     */
+    class stream_meter
+    {
+    public:
+        explicit stream_meter(metrics_registry &registry);
+
+        /*!
+         *  @brief  Scan the next piece of the stream.
+         */
+        void feed(const char *data, const std::size_t size);
+
+    private:
+        metrics_registry &_registry;
+        sse_parser _parser;
+
+        void event(const sse_event &event);
+    };
+}
+
+#endif  // MASTODON_CPP_METRICS_HPP
@@ -0,0 +1,107 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "progress_stream.hpp"
+
+using namespace Mastodon;
+
+progress_streambuf::progress_streambuf(std::streambuf *target,
+                                       const callback_type &callback)
+: _target(target)
+, _callback(callback)
+, _written(0)
+{}
+
+progress_streambuf::int_type progress_streambuf::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        return traits_type::not_eof(ch);
+    }
+
+    const char c = traits_type::to_char_type(ch);
+    return (xsputn(&c, 1) == 1 ? ch : traits_type::eof());
+}
+
+std::streamsize progress_streambuf::xsputn(const char *s, std::streamsize n)
+{
+    const std::streamsize written = _target->sputn(s, n);
+    if (written > 0)
+    {
+        _written += static_cast<std::uint64_t>(written);
+        _callback(_written);
+    }
+
+    return written;
+}
+
+int progress_streambuf::sync()
+{
+    return _target->pubsync();
+}
+
+progress_ostream::progress_ostream(
+    std::ostream &target, const progress_streambuf::callback_type &callback)
+: std::ostream(nullptr)
+, _buffer(target.rdbuf(), callback)
+{
+    rdbuf(&_buffer);
+}
+
+progress_istreambuf::progress_istreambuf(std::streambuf *source,
+                                         const callback_type &callback)
+: _source(source)
+, _callback(callback)
+, _read(0)
+{
+    setg(_buffer, _buffer, _buffer);
+}
+
+progress_istreambuf::int_type progress_istreambuf::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    // Only what has arrived, sgetn() would wait until _buffer is full.
+    if (traits_type::eq_int_type(_source->sgetc(), traits_type::eof()))
+    {
+        return traits_type::eof();
+    }
+    const std::streamsize available = std::min<std::streamsize>(
+        std::max<std::streamsize>(_source->in_avail(), 1), sizeof(_buffer));
+    const std::streamsize got = _source->sgetn(_buffer, available);
+    if (got <= 0)
+    {
+        return traits_type::eof();
+    }
+
+    _read += static_cast<std::uint64_t>(got);
+    _callback(_read);
+    setg(_buffer, _buffer, _buffer + got);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+progress_istream::progress_istream(
+    std::istream &source, const progress_istreambuf::callback_type &callback)
+: std::istream(nullptr)
+, _buffer(source.rdbuf(), callback)
+{
+    rdbuf(&_buffer);
+}
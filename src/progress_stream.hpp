@@ -0,0 +1,116 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_PROGRESS_STREAM_HPP
+#define MASTODON_CPP_PROGRESS_STREAM_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <istream>
+#include <streambuf>
+#include <functional>
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Passes everything on to another stream buffer and reports
+     *          how many bytes were written.
+     *
+     *  @since  0.112.0
+     */
+    class progress_streambuf : public std::streambuf
+    {
+    public:
+        using callback_type = std::function<void(const std::uint64_t)>;
+
+        /*!
+         *  @param  target    Receives the data.
+         *  @param  callback  Called with the number of bytes written so far.
+         */
+        progress_streambuf(std::streambuf *target,
+                           const callback_type &callback);
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char *s, std::streamsize n) override;
+        int sync() override;
+
+    private:
+        std::streambuf *_target;
+        const callback_type _callback;
+        std::uint64_t _written;
+    };
+
+    /*!
+     *  @brief  Output stream using progress_streambuf.
+     *
+     *  @since  0.112.0
+     */
+    class progress_ostream : public std::ostream
+    {
+    public:
+        progress_ostream(std::ostream &target,
+                         const progress_streambuf::callback_type &callback);
+
+    private:
+        progress_streambuf _buffer;
+    };
+
+    /*!
+     *  @brief  Reads from another stream buffer and reports how many bytes
+     *          were read.
+     *
+     *  @since  0.112.0
+     */
+    class progress_istreambuf : public std::streambuf
+    {
+    public:
+        using callback_type = progress_streambuf::callback_type;
+
+        /*!
+         *  @param  source    Provides the data.
+         *  @param  callback  Called with the number of bytes read so far.
+         */
+        progress_istreambuf(std::streambuf *source,
+                            const callback_type &callback);
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        std::streambuf *_source;
+        const callback_type _callback;
+        std::uint64_t _read;
+        char _buffer[8192];
+    };
+
+    /*!
+     *  @brief  Input stream using progress_istreambuf.
+     *
+     *  @since  0.112.0
+     */
+    class progress_istream : public std::istream
+    {
+    public:
+        progress_istream(std::istream &source,
+                         const progress_istreambuf::callback_type &callback);
+
+    private:
+        progress_istreambuf _buffer;
+    };
+}
+
+#endif  // MASTODON_CPP_PROGRESS_STREAM_HPP
@@ -0,0 +1,345 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <cctype>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <Poco/DateTime.h>
+#include <Poco/DateTimeParser.h>
+#include <Poco/DateTimeFormat.h>
+#include "debug.hpp"
+#include "rate_limiter.hpp"
+
+using namespace Mastodon;
+using std::chrono::seconds;
+using std::chrono::microseconds;
+using Poco::DateTime;
+using Poco::DateTimeParser;
+using Poco::DateTimeFormat;
+
+namespace
+{
+    // Delay between requests while the budget is used up and the server
+    // doesn't tell us when it resets.
+    const seconds probe_interval(1);
+
+    // Later times and longer delays are cut to this (2^32 s, the epoch
+    // plus this is in 2106). Adding it to the current time still fits into
+    // the nanoseconds of std::chrono::system_clock, which end in 2262.
+    const seconds max_time(4294967296LL);
+
+    // std::isdigit() is undefined for negative values of char.
+    bool is_number(const string &value)
+    {
+        return !value.empty() && std::all_of(value.begin(), value.end(),
+                           [](const unsigned char c)
+                           {
+                               return std::isdigit(c) != 0;
+                           });
+    }
+}
+
+rate_limiter::permit::permit(rate_limiter *limiter)
+: _limiter(limiter)
+{}
+
+rate_limiter::permit::permit(permit &&other)
+: _limiter(other._limiter)
+{
+    other._limiter = nullptr;
+}
+
+rate_limiter::permit::~permit()
+{
+    if (_limiter != nullptr)
+    {
+        _limiter->release();
+    }
+}
+
+void rate_limiter::permit::update(const HTTPResponse &response)
+{
+    if (_limiter != nullptr)
+    {
+        _limiter->update(response);
+    }
+}
+
+rate_limiter::rate_limiter()
+: _limit(-1)
+, _remaining(-1)
+, _reset_known(false)
+, _untracked(false)
+, _in_flight(0)
+, _queued(0)
+{}
+
+void rate_limiter::set_config(const rate_limit_config &config)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _config = config;
+    }
+    _cv.notify_all();
+}
+
+const rate_limit_config rate_limiter::get_config() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config;
+}
+
+rate_limiter::permit rate_limiter::acquire()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_config.enabled)
+    {
+        return permit(nullptr);
+    }
+
+    ++_queued;
+    while (_config.enabled)
+    {
+        const clock::time_point now = clock::now();
+        if (_reset_known && now >= _reset)
+        {                       // New window, the budget is full again.
+            _reset_known = false;
+            _remaining = _limit;
+        }
+
+        if (_remaining < 0)
+        {                       // No answer with a budget yet.
+            // Send one request at a time until we know the budget, unless
+            // the server doesn't send one.
+            if (_in_flight > 0 && !_untracked)
+            {
+                _cv.wait(lock);
+                continue;
+            }
+            break;
+        }
+
+        // Requests in flight may not be counted in _remaining yet.
+        const std::int64_t budget = _remaining
+            - static_cast<std::int64_t>(_in_flight + _config.reserve);
+
+        if (budget <= 0)
+        {
+            if (_reset_known)
+            {
+                ttdebug << "Rate limit reached, waiting for reset.\n";
+                _cv.wait_until(lock, _reset);
+                continue;
+            }
+            if (_in_flight > 0)
+            {                   // The answers will tell us more.
+                _cv.wait(lock);
+                continue;
+            }
+            // We can't know when to try again, ask once in a while.
+            if (now < _next_probe)
+            {
+                _cv.wait_until(lock, _next_probe);
+                continue;
+            }
+            _next_probe = now + probe_interval;
+            break;
+        }
+
+        if (_config.spread && _reset_known && budget * 2 < _limit)
+        {
+            const clock::time_point next =
+                _last_start + (_reset - now) / budget;
+            if (now < next)
+            {
+                _cv.wait_until(lock, next);
+                continue;
+            }
+        }
+
+        break;
+    }
+
+    --_queued;
+    ++_in_flight;
+    _last_start = clock::now();
+
+    return permit(this);
+}
+
+const rate_limit_status rate_limiter::get_status() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    rate_limit_status status;
+
+    status.limit = _limit;
+    status.remaining = _remaining;
+    status.reset = _reset;
+    if (_reset_known && clock::now() >= _reset)
+    {
+        status.remaining = _limit;
+    }
+    status.in_flight = _in_flight;
+    status.queued = _queued;
+
+    return status;
+}
+
+bool rate_limiter::parse_time(const string &value, clock::time_point &time)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+
+    seconds since_epoch;
+    if (parse_seconds(value, since_epoch))
+    {
+        time = clock::time_point(std::min(since_epoch, max_time));
+        return true;
+    }
+
+    DateTime datetime;
+    int tzd;
+    for (const string &format : { DateTimeFormat::ISO8601_FRAC_FORMAT,
+                                  DateTimeFormat::ISO8601_FORMAT,
+                                  DateTimeFormat::HTTP_FORMAT })
+    {
+        if (DateTimeParser::tryParse(format, value, datetime, tzd))
+        {
+            datetime.makeUTC(tzd);
+            const microseconds since_epoch(
+                datetime.timestamp().epochMicroseconds());
+            time = clock::time_point(
+                std::max(std::min(since_epoch, microseconds(max_time)),
+                         microseconds(0)));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool rate_limiter::parse_seconds(const string &value, seconds &delay)
+{
+    if (!is_number(value))
+    {
+        return false;
+    }
+
+    try
+    {
+        delay = seconds(std::stoll(value));
+    }
+    catch (const std::out_of_range &)
+    {
+        delay = seconds::max();
+    }
+
+    return true;
+}
+
+void rate_limiter::update(const HTTPResponse &response)
+{
+    const clock::time_point now = clock::now();
+    std::int64_t limit = -1;
+    std::int64_t remaining = -1;
+    clock::time_point reset;
+    bool reset_known = false;
+
+    try
+    {
+        limit = std::stoll(response.get("X-RateLimit-Limit", "-1"));
+        remaining = std::stoll(response.get("X-RateLimit-Remaining", "-1"));
+    }
+    catch (const std::exception &e)
+    {
+        ttdebug << "Could not parse rate limit headers: " << e.what() << '\n';
+    }
+
+    // Translate the reset time to our clock, using the Date header.
+    clock::time_point date;
+    const bool date_known = parse_time(response.get("Date", ""), date);
+    if (parse_time(response.get("X-RateLimit-Reset", ""), reset))
+    {
+        reset_known = true;
+        if (date_known)
+        {
+            reset = now + (reset - date);
+        }
+    }
+
+    // Not using the constant because it is too new for Debian stretch.
+    if (response.getStatus() == 429) // HTTPResponse::HTTP_TOO_MANY_REQUESTS
+    {
+        remaining = 0;
+        const string retry_after = response.get("Retry-After", "");
+        seconds delay;
+        if (!reset_known && parse_seconds(retry_after, delay))
+        {
+            reset_known = true;
+            reset = now + std::min(delay, max_time);
+        }
+        else if (!reset_known && parse_time(retry_after, reset))
+        {
+            reset_known = true;
+            if (date_known)
+            {
+                reset = now + (reset - date);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _untracked = (remaining < 0);
+    if (limit >= 0)
+    {
+        _limit = limit;
+    }
+
+    if (remaining >= 0)
+    {
+        if (!reset_known)
+        {
+            _remaining = (_remaining < 0
+                          ? remaining : std::min(_remaining, remaining));
+        }
+        else if (!_reset_known || reset > _reset + seconds(1))
+        {                       // A new window.
+            _remaining = remaining;
+            _reset = reset;
+            _reset_known = true;
+        }
+        else if (reset + seconds(1) >= _reset)
+        {                       // Answers can arrive out of order.
+            _remaining = std::min(_remaining, remaining);
+        }
+        // Otherwise the answer is from an old window.
+    }
+
+    ttdebug << "Rate limit: " << _remaining << '/' << _limit << ".\n";
+}
+
+void rate_limiter::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_in_flight;
+    }
+    _cv.notify_all();
+}
@@ -0,0 +1,146 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_RATE_LIMITER_HPP
+#define MASTODON_CPP_RATE_LIMITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <Poco/Net/HTTPResponse.h>
+
+#include "types.hpp"
+
+using std::string;
+using Poco::Net::HTTPResponse;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Keeps track of the rate limit budget of one access token on
+     *          one instance. Used by API::http.
+     *
+     *          Mastodon sends `X-RateLimit-Limit`, `X-RateLimit-Remaining`
+     *          and `X-RateLimit-Reset` with every answer. Requests wait in
+     *          acquire() while the budget is used up. Until the first
+     *          answer, only one request is sent at a time.
+     *
+     *  @since  0.112.0
+     */
+    class rate_limiter
+    {
+    public:
+        using clock = std::chrono::system_clock;
+
+        /*!
+         *  @brief  Permission to send one request.
+         *
+         *          The request counts as in flight until the permit is
+         *          destroyed.
+         *
+         *  @since  0.112.0
+         */
+        class permit
+        {
+        public:
+            permit(permit &&other);
+            permit(const permit &) = delete;
+            permit &operator=(const permit &) = delete;
+            ~permit();
+
+            /*!
+             *  @brief  Update the budget from the headers of the answer.
+             */
+            void update(const HTTPResponse &response);
+
+        private:
+            friend class rate_limiter;
+
+            explicit permit(rate_limiter *limiter);
+
+            rate_limiter *_limiter;
+        };
+
+        rate_limiter();
+
+        /*!
+         *  @brief  Set the scheduler settings.
+         */
+        void set_config(const rate_limit_config &config);
+
+        /*!
+         *  @brief  Returns the current scheduler settings.
+         */
+        const rate_limit_config get_config() const;
+
+        /*!
+         *  @brief  Blocks until a request may be sent.
+         *
+         *          Returns immediately if the scheduler is disabled.
+         */
+        permit acquire();
+
+        /*!
+         *  @brief  Returns the current budget and queue depth.
+         */
+        const rate_limit_status get_status() const;
+
+        /*!
+         *  @brief  Parse the value of `X-RateLimit-Reset`.
+         *
+         *          Accepts ISO 8601 (Mastodon) and seconds since the epoch.
+         *          Times after 2106 are cut to 2106, so that calculating
+         *          with them can't overflow.
+         *
+         *  @return true on success.
+         */
+        static bool parse_time(const string &value, clock::time_point &time);
+
+        /*!
+         *  @brief  Parse a number of seconds, like the value of
+         *          `Retry-After`.
+         *
+         *          Values that don't fit into seconds are cut to the
+         *          largest one.
+         *
+         *  @return true on success.
+         */
+        static bool parse_seconds(const string &value,
+                                  std::chrono::seconds &delay);
+
+    private:
+        rate_limit_config _config;
+        mutable std::mutex _mutex;
+        std::condition_variable _cv;
+        std::int64_t _limit;
+        std::int64_t _remaining;
+        clock::time_point _reset;
+        bool _reset_known;
+        // The last answer had no budget.
+        bool _untracked;
+        std::size_t _in_flight;
+        std::size_t _queued;
+        clock::time_point _last_start;
+        clock::time_point _next_probe;
+
+        void update(const HTTPResponse &response);
+        void release();
+    };
+}
+
+#endif  // MASTODON_CPP_RATE_LIMITER_HPP
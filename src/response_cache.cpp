@@ -0,0 +1,288 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <exception>
+#include <stdexcept>
+#include "debug.hpp"
+#include "response_cache.hpp"
+#include "rate_limiter.hpp"
+
+using namespace Mastodon;
+using std::chrono::seconds;
+
+namespace
+{
+    // Longer lifetimes are cut to 2^31 seconds (RFC 7234, section 1.2.1),
+    // so that adding them to the clock can't overflow.
+    const long long max_freshness = 2147483648LL;
+}
+
+response_cache::response_cache()
+{}
+
+void response_cache::set_config(const cache_config &config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _config = config;
+
+    if (!_config.enabled)
+    {
+        _entries.clear();
+        _lru.clear();
+        _stats.bytes = 0;
+    }
+    trim();
+}
+
+bool response_cache::enabled() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config.enabled;
+}
+
+bool response_cache::get(const string &key, return_call &ret,
+                         header_map &validators)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _entries.find(key);
+    if (it == _entries.end())
+    {
+        return false;
+    }
+
+    entry &cached = it->second;
+    _lru.splice(_lru.begin(), _lru, cached.lru);
+
+    if (clock::now() < cached.expires)
+    {
+        ++_stats.hits;
+        ret = cached.ret;
+        return true;
+    }
+
+    const header_map &headers = cached.ret.headers;
+    const auto etag = headers.find("ETag");
+    if (etag != headers.end())
+    {
+        validators["If-None-Match"] = etag->second;
+    }
+    const auto modified = headers.find("Last-Modified");
+    if (modified != headers.end())
+    {
+        validators["If-Modified-Since"] = modified->second;
+    }
+
+    return false;
+}
+
+bool response_cache::revalidated(const string &key, const header_map &headers,
+                                 return_call &ret)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _entries.find(key);
+    if (it == _entries.end())
+    {
+        return false;
+    }
+
+    // The headers of a 304 answer replace the stored ones (RFC 7234,
+    // section 4.3.4), except the ones describing the body.
+    entry &cached = it->second;
+    for (const auto &header : headers)
+    {
+        if (header_less()(header.first, "Content-Length")
+            || header_less()("Content-Length", header.first))
+        {
+            cached.ret.headers[header.first] = header.second;
+        }
+    }
+    cached.expires = clock::now()
+        + std::max(freshness(cached.ret.headers), seconds(0));
+
+    ++_stats.revalidations;
+    ret = cached.ret;
+    ttdebug << "Revalidated cached answer: " << key << '\n';
+
+    return true;
+}
+
+void response_cache::store(const string &key, const return_call &ret)
+{
+    const seconds fresh = freshness(ret.headers);
+    const bool has_validator = (ret.headers.find("ETag") != ret.headers.end()
+                                || ret.headers.find("Last-Modified")
+                                != ret.headers.end());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.misses;
+
+    // Without freshness or validators the entry would be useless.
+    if (fresh.count() < 0 || (fresh.count() == 0 && !has_validator))
+    {
+        return;
+    }
+
+    std::size_t bytes = key.size() + ret.answer.size();
+    for (const auto &header : ret.headers)
+    {
+        bytes += header.first.size() + header.second.size();
+    }
+    if (bytes > _config.max_bytes)
+    {
+        return;
+    }
+
+    const auto old = _entries.find(key);
+    if (old != _entries.end())
+    {
+        erase(old);
+    }
+
+    _lru.push_front(key);
+    _entries[key] = { ret, clock::now() + fresh, bytes, _lru.begin() };
+    _stats.bytes += bytes;
+    ttdebug << "Cached answer for " << fresh.count() << " s: " << key << '\n';
+
+    trim();
+}
+
+void response_cache::miss()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.misses;
+}
+
+const cache_stats response_cache::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    cache_stats stats = _stats;
+    stats.entries = _entries.size();
+
+    return stats;
+}
+
+void response_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+    _stats.bytes = 0;
+}
+
+seconds response_cache::freshness(const header_map &headers)
+{
+    auto get = [&headers](const string &name)
+    {
+        const auto it = headers.find(name);
+        return (it != headers.end() ? it->second : string());
+    };
+
+    string cache_control = get("Cache-Control");
+    std::transform(cache_control.begin(), cache_control.end(),
+                   cache_control.begin(),
+                   [](const unsigned char c)
+                   {
+                       return static_cast<char>(std::tolower(c));
+                   });
+
+    std::istringstream directives(cache_control);
+    string directive;
+    bool no_cache = false;
+    long long max_age = -1;
+    while (std::getline(directives, directive, ','))
+    {
+        directive.erase(0, directive.find_first_not_of(' '));
+        directive.erase(directive.find_last_not_of(' ') + 1);
+
+        if (directive == "no-store")
+        {
+            return seconds(-1);
+        }
+        else if (directive == "no-cache")
+        {
+            no_cache = true;
+        }
+        else if (directive.compare(0, 8, "max-age=") == 0)
+        {
+            try
+            {
+                max_age = std::stoll(directive.substr(8));
+            }
+            catch (const std::out_of_range &)
+            {
+                max_age = max_freshness;
+            }
+            catch (const std::exception &)
+            {
+                max_age = 0;
+            }
+        }
+    }
+
+    if (no_cache)
+    {
+        return seconds(0);
+    }
+
+    if (max_age < 0)
+    {                           // Fall back to Expires.
+        rate_limiter::clock::time_point expires;
+        rate_limiter::clock::time_point date;
+        if (!rate_limiter::parse_time(get("Expires"), expires))
+        {
+            return seconds(0);
+        }
+        if (!rate_limiter::parse_time(get("Date"), date))
+        {
+            date = rate_limiter::clock::now();
+        }
+        max_age = std::chrono::duration_cast<seconds>(expires - date).count();
+    }
+    max_age = std::min(max_age, max_freshness);
+
+    // Time the answer already spent in other caches.
+    long long age = 0;
+    try
+    {
+        age = std::stoll(get("Age"));
+    }
+    catch (const std::exception &)
+    {
+        age = 0;
+    }
+    age = std::min(std::max(age, 0LL), max_freshness);
+
+    return seconds(std::max(max_age - age, 0LL));
+}
+
+void response_cache::trim()
+{
+    while (!_lru.empty() && (_entries.size() > _config.max_entries
+                             || _stats.bytes > _config.max_bytes))
+    {
+        erase(_entries.find(_lru.back()));
+    }
+}
+
+void response_cache::erase(std::map<string, entry>::iterator it)
+{
+    _stats.bytes -= it->second.bytes;
+    _lru.erase(it->second.lru);
+    _entries.erase(it);
+}
@@ -0,0 +1,138 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_RESPONSE_CACHE_HPP
+#define MASTODON_CPP_RESPONSE_CACHE_HPP
+
+#include <string>
+#include <map>
+#include <list>
+#include <mutex>
+#include <chrono>
+
+#include "types.hpp"
+#include "return_types.hpp"
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  LRU cache of answers to GET requests. Used by API::http.
+     *
+     *          Every API::http has its own cache, so the access token is
+     *          implicitly part of the key.
+     *
+     *  @since  0.112.0
+     */
+    class response_cache
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        response_cache();
+
+        /*!
+         *  @brief  Set the cache settings. Surplus entries are removed.
+         */
+        void set_config(const cache_config &config);
+
+        /*!
+         *  @brief  Returns true if the cache is enabled.
+         */
+        bool enabled() const;
+
+        /*!
+         *  @brief  Look up an answer.
+         *
+         *  @param  key         Method and path of the request.
+         *  @param  ret         Set to the cached answer if it is fresh.
+         *  @param  validators  Set to `If-None-Match` and/or
+         *                      `If-Modified-Since` if the cached answer is
+         *                      stale but can be revalidated.
+         *
+         *  @return true if ret was set.
+         */
+        bool get(const string &key, return_call &ret,
+                 header_map &validators);
+
+        /*!
+         *  @brief  The server answered a conditional request with 304.
+         *
+         *          Updates the freshness of the entry from headers.
+         *
+         *  @param  key      Method and path of the request.
+         *  @param  headers  The headers of the 304 answer.
+         *  @param  ret      Set to the cached answer.
+         *
+         *  @return false if the entry was removed in the meantime.
+         */
+        bool revalidated(const string &key, const header_map &headers,
+                         return_call &ret);
+
+        /*!
+         *  @brief  Store a successful answer, if Cache-Control allows it.
+         *
+         *          Counts as a miss.
+         */
+        void store(const string &key, const return_call &ret);
+
+        /*!
+         *  @brief  Count a request that could not use the cache.
+         */
+        void miss();
+
+        /*!
+         *  @brief  Returns the counters.
+         */
+        const cache_stats get_stats() const;
+
+        /*!
+         *  @brief  Remove all entries.
+         */
+        void clear();
+
+    private:
+        typedef struct entry
+        {
+            return_call ret;
+            clock::time_point expires;
+            std::size_t bytes;
+            std::list<string>::iterator lru;
+        } entry;
+
+        cache_config _config;
+        mutable std::mutex _mutex;
+        std::map<string, entry> _entries;
+        std::list<string> _lru;     // Most recently used first.
+        cache_stats _stats;
+
+        /*!
+         *  @brief  Returns how long an answer may be used without asking
+         *          the server. Negative if it must not be stored.
+         */
+        static std::chrono::seconds freshness(const header_map &headers);
+
+        /*!
+         *  @brief  Remove entries until the limits are kept.
+         */
+        void trim();
+
+        void erase(std::map<string, entry>::iterator it);
+    };
+}
+
+#endif  // MASTODON_CPP_RESPONSE_CACHE_HPP
@@ -14,10 +14,23 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cctype>
+#include <utility>
 #include "return_types.hpp"
 
 namespace Mastodon
 {
+    bool header_less::operator()(const string &a, const string &b) const
+    {
+        return std::lexicographical_compare(
+            a.begin(), a.end(), b.begin(), b.end(),
+            [](const unsigned char c1, const unsigned char c2)
+            {
+                return std::tolower(c1) < std::tolower(c2);
+            });
+    }
+
     return_base::operator bool() const
     {
         if (error_code == 0)
@@ -66,4 +79,13 @@ namespace Mastodon
         error_message = em;
         http_error_code = hec;
     }
+
+    return_call::return_call(const error ec, const string &em,
+                             const uint16_t hec, string &&a)
+        : answer(std::move(a))
+    {
+        error_code = static_cast<uint8_t>(ec);
+        error_message = em;
+        http_error_code = hec;
+    }
 }
@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <string>
+#include <map>
 #include "types.hpp"
 
 using std::uint8_t;
@@ -27,6 +28,25 @@ using std::string;
 
 namespace Mastodon
 {
+    /*!
+     *  @brief  Case insensitive comparison of strings, used for header_map.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct header_less
+    {
+        bool operator()(const string &a, const string &b) const;
+    } header_less;
+
+    /*!
+     *  @brief  Map of HTTP headers. The names are case insensitive.
+     *
+     *          Headers that occur more than once are joined with `, `.
+     *
+     *  @since  0.112.0
+     */
+    typedef std::map<string, string, header_less> header_map;
+
     /*!
      *  @brief  Basis for return types.
      *
@@ -99,6 +119,22 @@ namespace Mastodon
          */
         string answer;
 
+        /*!
+         *  @brief  The headers of the response.
+         *
+         *          Example:
+         *          @code
+         *          const auto it = ret.headers.find("link");
+         *          if (it != ret.headers.end())
+         *          {
+         *              cout << it->second << endl;
+         *          }
+         *          @endcode
+         *
+         *  @since  0.112.0
+         */
+        header_map headers;
+
         return_call();
 
         /*!
@@ -127,6 +163,20 @@ namespace Mastodon
         return_call(const error ec, const string &em,
                     const uint16_t hec, const string &a);
 
+        /*!
+         *  @brief  Return type for Mastodon::API. Takes over the answer
+         *          instead of copying it.
+         *
+         *  @param  ec  Error code
+         *  @param  em  Error message
+         *  @param  hec HTTP error code
+         *  @param  a   Answer
+         *
+         *  @since  0.112.0
+         */
+        return_call(const error ec, const string &em,
+                    const uint16_t hec, string &&a);
+
         /*!
          *  @brief  Same es return_call::answer.
          *
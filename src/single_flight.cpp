@@ -0,0 +1,101 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include "debug.hpp"
+#include "single_flight.hpp"
+
+using namespace Mastodon;
+
+single_flight::single_flight()
+: _enabled(false)
+, _waiting(0)
+{}
+
+void single_flight::set_enabled(const bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool single_flight::enabled() const
+{
+    return _enabled;
+}
+
+return_call single_flight::run(const string &key,
+                               const std::function<return_call()> &call)
+{
+    std::promise<return_call> promise;
+    std::shared_future<return_call> running;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _calls.find(key);
+        if (it != _calls.end())
+        {
+            running = it->second;
+            ++_waiting;
+        }
+        else
+        {
+            _calls.emplace(key, promise.get_future().share());
+        }
+    }
+
+    if (running.valid())
+    {
+        ttdebug << "Joining running request: " << key << '\n';
+        running.wait();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_waiting;
+        }
+        return running.get();
+    }
+
+    // Waiting callers hold their own copy of the future, so the entry can
+    // be removed before they read the result.
+    auto finish = [this, &key]
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _calls.erase(key);
+    };
+
+    try
+    {
+        return_call ret = call();
+        promise.set_value(ret);
+        finish();
+        return ret;
+    }
+    catch (const std::exception &)
+    {
+        promise.set_exception(std::current_exception());
+        finish();
+        throw;
+    }
+}
+
+std::size_t single_flight::in_flight() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _calls.size();
+}
+
+std::size_t single_flight::waiting() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _waiting;
+}
@@ -0,0 +1,85 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_SINGLE_FLIGHT_HPP
+#define MASTODON_CPP_SINGLE_FLIGHT_HPP
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <functional>
+
+#include "return_types.hpp"
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Lets concurrent identical requests share one request. Used
+     *          by API::http for GET requests.
+     *
+     *  @since  0.112.0
+     */
+    class single_flight
+    {
+    public:
+        single_flight();
+
+        /*!
+         *  @brief  Enable or disable coalescing. Disabled by default.
+         */
+        void set_enabled(const bool enabled);
+
+        /*!
+         *  @brief  Returns true if coalescing is enabled.
+         */
+        bool enabled() const;
+
+        /*!
+         *  @brief  Run call, unless a call with the same key is already
+         *          running. Then wait for it and return its result.
+         *
+         *          Exceptions are passed on to all waiting callers.
+         *
+         *  @param  key   Identifies the request.
+         *  @param  call  Makes the request.
+         */
+        return_call run(const string &key,
+                        const std::function<return_call()> &call);
+
+        /*!
+         *  @brief  Returns the number of requests that are running.
+         */
+        std::size_t in_flight() const;
+
+        /*!
+         *  @brief  Returns the number of callers that wait for a running
+         *          request.
+         */
+        std::size_t waiting() const;
+
+    private:
+        std::atomic<bool> _enabled;
+        mutable std::mutex _mutex;
+        std::map<string, std::shared_future<return_call>> _calls;
+        std::size_t _waiting;
+    };
+}
+
+#endif  // MASTODON_CPP_SINGLE_FLIGHT_HPP
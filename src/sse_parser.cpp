@@ -0,0 +1,208 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "sse_parser.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    const char default_name[] = "message";
+}
+
+const string sse_event::get_name() const
+{
+    return string(name, name_size);
+}
+
+const string sse_event::get_data() const
+{
+    return string(data, data_size);
+}
+
+bool sse_event::is(const char *other) const
+{
+    return (std::strlen(other) == name_size
+            && std::memcmp(name, other, name_size) == 0);
+}
+
+sse_parser::sse_parser(const callback_type &callback)
+: _callback(callback)
+, _has_name(false)
+, _has_data(false)
+{}
+
+void sse_parser::feed(const string &data)
+{
+    feed(data.data(), data.size());
+}
+
+void sse_parser::feed(const char *data, const std::size_t size)
+{
+    const char *pos = data;
+    const char *const end = data + size;
+
+    while (pos < end)
+    {
+        const char *newline = static_cast<const char *>(
+            std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+        if (newline == nullptr)
+        {
+            _partial.append(pos, end);
+            break;
+        }
+
+        if (_partial.empty())
+        {
+            line(pos, static_cast<std::size_t>(newline - pos), false);
+        }
+        else
+        {                       // The line started in an earlier piece.
+            _partial.append(pos, newline);
+            line(_partial.data(), _partial.size(), true);
+            _partial.clear();
+        }
+
+        pos = newline + 1;
+    }
+
+    // The piece is gone after we return.
+    keep();
+}
+
+void sse_parser::line(const char *begin, std::size_t size, const bool copy)
+{
+    if (size > 0 && begin[size - 1] == '\r')
+    {
+        --size;
+    }
+
+    if (size == 0)
+    {
+        dispatch();
+        return;
+    }
+
+    if (begin[0] == ':')
+    {                           // Comment.
+        return;
+    }
+
+    const char *colon = static_cast<const char *>(
+        std::memchr(begin, ':', size));
+    const std::size_t field_size = (colon == nullptr
+                                    ? size
+                                    : static_cast<std::size_t>(colon - begin));
+    const char *value = begin + size;
+    std::size_t value_size = 0;
+    if (colon != nullptr)
+    {
+        value = colon + 1;
+        value_size = size - field_size - 1;
+        if (value_size > 0 && *value == ' ')
+        {
+            ++value;
+            --value_size;
+        }
+    }
+
+    if (field_size == 5 && std::memcmp(begin, "event", 5) == 0)
+    {
+        if (copy)
+        {
+            _name_buffer.assign(value, value_size);
+            value = _name_buffer.data();
+        }
+        _event.name = value;
+        _event.name_size = value_size;
+        _has_name = true;
+    }
+    else if (field_size == 4 && std::memcmp(begin, "data", 4) == 0)
+    {
+        if (!_has_data && !copy)
+        {
+            _event.data = value;
+            _event.data_size = value_size;
+        }
+        else
+        {
+            if (!_has_data)
+            {
+                _data_buffer.clear();
+            }
+            else
+            {                   // More than one data line.
+                if (_event.data != _data_buffer.data())
+                {
+                    _data_buffer.assign(_event.data, _event.data_size);
+                }
+                _data_buffer += '\n';
+            }
+            _data_buffer.append(value, value_size);
+            _event.data = _data_buffer.data();
+            _event.data_size = _data_buffer.size();
+        }
+        _has_data = true;
+    }
+}
+
+void sse_parser::dispatch()
+{
+    if (_has_data)
+    {
+        if (!_has_name || _event.name_size == 0)
+        {
+            _event.name = default_name;
+            _event.name_size = sizeof(default_name) - 1;
+        }
+        _callback(_event);
+    }
+
+    _event = sse_event();
+    _has_name = false;
+    _has_data = false;
+}
+
+void sse_parser::keep()
+{
+    if (_has_name && _event.name != _name_buffer.data()
+        && _event.name != default_name)
+    {
+        _name_buffer.assign(_event.name, _event.name_size);
+        _event.name = _name_buffer.data();
+    }
+
+    if (_has_data && _event.data != _data_buffer.data())
+    {
+        _data_buffer.assign(_event.data, _event.data_size);
+        _event.data = _data_buffer.data();
+    }
+}
+
+void sse_parser::finish()
+{
+    _partial.clear();
+    dispatch();
+}
+
+void sse_parser::reset()
+{
+    _partial.clear();
+    _event = sse_event();
+    _has_name = false;
+    _has_data = false;
+}
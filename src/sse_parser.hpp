@@ -0,0 +1,146 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_SSE_PARSER_HPP
+#define MASTODON_CPP_SSE_PARSER_HPP
+
+#include <string>
+#include <cstddef>
+#include <functional>
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  An event of a stream, see sse_parser.
+     *
+     *          name and data point into the piece of the stream that was
+     *          passed to sse_parser::feed() or into the parser. They are
+     *          valid until the callback returns.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct sse_event
+    {
+        /*!
+         *  @brief  Name of the event, `message` if the server didn't send
+         *          one. Not null-terminated.
+         */
+        const char *name = nullptr;
+        std::size_t name_size = 0;
+
+        /*!
+         *  @brief  Data of the event. Lines are joined with `\n`. Not
+         *          null-terminated.
+         */
+        const char *data = nullptr;
+        std::size_t data_size = 0;
+
+        /*!
+         *  @brief  Returns a copy of the name.
+         */
+        const string get_name() const;
+
+        /*!
+         *  @brief  Returns a copy of the data.
+         */
+        const string get_data() const;
+
+        /*!
+         *  @brief  Returns true if the name is name.
+         */
+        bool is(const char *name) const;
+    } sse_event;
+
+    /*!
+     *  @brief  Incremental parser for server-sent events, the format of
+     *          the streaming API.
+     *
+     *          The stream can be passed in pieces of any size, lines that
+     *          are split between pieces are put together. Every complete
+     *          event is passed to the callback. Comments like `:thump` and
+     *          fields other than `event` and `data` are ignored.
+     *
+     *          Events that are completely inside one piece are not copied.
+     *
+     *          Example:
+     *          @code
+     *          Mastodon::sse_parser parser(
+     *              [](const Mastodon::sse_event &event)
+     *              {
+     *                  if (event.is("update"))
+     *                  {
+     *                      Easy::Status status(event.get_data());
+     *                  }
+     *              });
+     *          parser.feed(piece);
+     *          @endcode
+     *
+     *  @since  0.112.0
+     */
+    class sse_parser
+    {
+    public:
+        using callback_type = std::function<void(const sse_event &event)>;
+
+        /*!
+         *  @param  callback  Receives the events.
+         */
+        explicit sse_parser(const callback_type &callback);
+
+        /*!
+         *  @brief  Parse the next piece of the stream.
+         */
+        void feed(const char *data, const std::size_t size);
+
+        /*!
+         *  @brief  Parse the next piece of the stream.
+         */
+        void feed(const string &data);
+
+        /*!
+         *  @brief  Pass on the event that is missing only the empty line
+         *          at its end, and forget an incomplete line.
+         *
+         *          Call this when the stream ended.
+         */
+        void finish();
+
+        /*!
+         *  @brief  Forget everything that was not passed on yet.
+         */
+        void reset();
+
+    private:
+        const callback_type _callback;
+        // An incomplete line from the last piece.
+        string _partial;
+        // The current event. Points into the current piece or into the
+        // buffers.
+        sse_event _event;
+        bool _has_name;
+        bool _has_data;
+        string _name_buffer;
+        string _data_buffer;
+
+        void line(const char *begin, std::size_t size, const bool copy);
+        void dispatch();
+        void keep();
+    };
+}
+
+#endif  // MASTODON_CPP_SSE_PARSER_HPP
@@ -0,0 +1,637 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <map>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <system_error>
+#include <algorithm>
+#include <limits>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <Poco/Exception.h>
+#include <Poco/Net/NetException.h>
+#include <Poco/Net/SSLException.h>
+#include <Poco/Net/StreamSocket.h>
+#include "debug.hpp"
+#include "types.hpp"
+#include "stream_multiplexer.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    // The lower bits of an ID are the index of the loop.
+    const unsigned loop_bits = 16;
+    // epoll reports the eventfd with this ID.
+    const std::uint64_t wakeup_id = 0;
+    // Idle streams are looked for at most this often.
+    const std::chrono::milliseconds idle_check_interval(100);
+    // The loop whose thread this is, if any.
+    thread_local const void *current_loop = nullptr;
+}
+
+class stream_multiplexer::loop
+{
+public:
+    loop();
+    ~loop();
+
+    void add(const id_type id, stream_connection &&connection,
+             const sse_parser::callback_type &callback);
+    void remove(const id_type id);
+    std::size_t size() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    typedef struct subscription
+    {
+        subscription(const id_type id_, stream_connection &&connection_,
+                     const sse_parser::callback_type &callback_);
+
+        const id_type id;
+        stream_connection connection;
+        const sse_parser::callback_type callback;
+        sse_parser parser;
+        bool removed;
+        // When data arrived last.
+        clock::time_point active;
+        // State of the chunked transfer encoding.
+        bool in_data;
+        std::uint64_t left;
+        string size_line;
+    } subscription;
+
+    int _epoll;
+    int _wakeup;
+    // Only used by the thread of the loop.
+    std::map<id_type, unique_ptr<subscription>> _subscriptions;
+    char _buffer[16384];
+    // When the next stream may become idle.
+    clock::time_point _next_check;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    // Changes for the thread of the loop, guarded by _mutex.
+    std::vector<unique_ptr<subscription>> _added;
+    std::vector<id_type> _removed;
+    std::uint64_t _requested;
+    std::uint64_t _handled;
+    std::size_t _count;
+    bool _stop;
+
+    std::thread _thread;
+
+    void run();
+    void wake();
+    bool apply_changes();
+    void start(unique_ptr<subscription> sub);
+    void erase(const id_type id);
+    bool read(subscription &sub);
+    bool decode(subscription &sub, const char *data, std::size_t size);
+    void end(subscription &sub, const error code, const string &message);
+    void end_idle();
+    int wait_time() const;
+};
+
+stream_multiplexer::loop::subscription::subscription(
+    const id_type id_, stream_connection &&connection_,
+    const sse_parser::callback_type &callback_)
+: id(id_)
+, connection(std::move(connection_))
+, callback(callback_)
+, parser([this](const sse_event &event)
+         {
+             // Events after remove() are dropped.
+             if (!removed)
+             {
+                 callback(event);
+             }
+         })
+, removed(false)
+, in_data(false)
+, left(0)
+{}
+
+stream_multiplexer::loop::loop()
+: _epoll(epoll_create1(EPOLL_CLOEXEC))
+, _wakeup(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+, _next_check(clock::time_point::max())
+, _requested(0)
+, _handled(0)
+, _count(0)
+, _stop(false)
+{
+    if (_epoll < 0 || _wakeup < 0)
+    {
+        const int err = errno;
+        if (_epoll >= 0)
+        {
+            close(_epoll);
+        }
+        if (_wakeup >= 0)
+        {
+            close(_wakeup);
+        }
+        throw std::system_error(err, std::generic_category(),
+                                "Could not set up stream multiplexer");
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = wakeup_id;
+    epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &event);
+
+    _thread = std::thread(&loop::run, this);
+}
+
+stream_multiplexer::loop::~loop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    wake();
+    _thread.join();
+
+    // Close the connections before the file descriptors of epoll.
+    _subscriptions.clear();
+    close(_wakeup);
+    close(_epoll);
+}
+
+void stream_multiplexer::loop::add(const id_type id,
+                                   stream_connection &&connection,
+                                   const sse_parser::callback_type &callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _added.push_back(std::make_unique<subscription>(
+                             id, std::move(connection), callback));
+        ++_count;
+    }
+    wake();
+}
+
+void stream_multiplexer::loop::remove(const id_type id)
+{
+    if (current_loop == this)
+    {                           // Called from a callback.
+        const auto it = _subscriptions.find(id);
+        if (it != _subscriptions.end())
+        {
+            it->second->removed = true;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _removed.push_back(id);
+        return;
+    }
+    if (current_loop != nullptr)
+    {                           // Called from a callback of another loop.
+        // Waiting could deadlock if this loop waits for that one, too.
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _removed.push_back(id);
+        }
+        wake();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _removed.push_back(id);
+    const std::uint64_t ticket = ++_requested;
+    wake();
+    _cv.wait(lock, [this, ticket] { return (_handled >= ticket || _stop); });
+}
+
+std::size_t stream_multiplexer::loop::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+void stream_multiplexer::loop::wake()
+{
+    const std::uint64_t one = 1;
+    if (write(_wakeup, &one, sizeof(one)) < 0)
+    {
+        // The counter is full, the loop wakes up anyway.
+    }
+}
+
+void stream_multiplexer::loop::run()
+{
+    epoll_event events[64];
+    current_loop = this;
+
+    while (apply_changes())
+    {
+        // Streams that ended or were removed in a callback.
+        for (auto it = _subscriptions.begin(); it != _subscriptions.end();)
+        {
+            const id_type id = it->first;
+            const bool removed = it->second->removed;
+            ++it;
+            if (removed)
+            {
+                erase(id);
+            }
+        }
+
+        const int ready = epoll_wait(_epoll, events, 64, wait_time());
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+            {
+                ttlog(ERROR) << "epoll_wait failed: " << errno << '\n';
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        for (int i = 0; i < ready; ++i)
+        {
+            const std::uint64_t id = events[i].data.u64;
+            if (id == wakeup_id)
+            {
+                std::uint64_t counter;
+                if (::read(_wakeup, &counter, sizeof(counter)) < 0)
+                {
+                    // Reset already, nothing to do.
+                }
+                continue;
+            }
+
+            const auto it = _subscriptions.find(id);
+            if (it != _subscriptions.end() && !it->second->removed)
+            {
+                read(*it->second);
+            }
+        }
+
+        if (clock::now() >= _next_check)
+        {
+            end_idle();
+        }
+    }
+}
+
+int stream_multiplexer::loop::wait_time() const
+{
+    if (_next_check == clock::time_point::max())
+    {
+        return -1;
+    }
+
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        _next_check - clock::now());
+    // Rounded up, epoll_wait() would return too early.
+    return static_cast<int>(
+        std::min<std::chrono::milliseconds::rep>(
+            std::max<std::chrono::milliseconds::rep>(left.count() + 1, 0),
+            std::numeric_limits<int>::max()));
+}
+
+void stream_multiplexer::loop::end_idle()
+{
+    // Sockets are non-blocking, their receive timeouts don't apply.
+    const clock::time_point now = clock::now();
+    clock::time_point next = clock::time_point::max();
+
+    for (auto &entry : _subscriptions)
+    {
+        subscription &sub = *entry.second;
+        if (sub.removed || sub.connection.idle_timeout.count() == 0)
+        {
+            continue;
+        }
+
+        const clock::time_point deadline =
+            sub.active + sub.connection.idle_timeout;
+        if (deadline <= now)
+        {
+            end(sub, error::CONNECTION_TIMEOUT, "Stream idle");
+        }
+        else
+        {
+            next = std::min(next, deadline);
+        }
+    }
+
+    if (next != clock::time_point::max())
+    {
+        next = std::max(next, now + idle_check_interval);
+    }
+    _next_check = next;
+}
+
+bool stream_multiplexer::loop::apply_changes()
+{
+    std::vector<unique_ptr<subscription>> added;
+    std::vector<id_type> removed;
+    std::uint64_t requested;
+    bool stop;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        added.swap(_added);
+        removed.swap(_removed);
+        requested = _requested;
+        stop = _stop;
+    }
+
+    // Added first, they may be removed already.
+    for (unique_ptr<subscription> &sub : added)
+    {
+        start(std::move(sub));
+    }
+    for (const id_type id : removed)
+    {
+        erase(id);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _handled = requested;
+    }
+    _cv.notify_all();
+
+    return !stop;
+}
+
+void stream_multiplexer::loop::start(unique_ptr<subscription> sub)
+{
+    subscription &ref = *sub;
+    _subscriptions[ref.id] = std::move(sub);
+
+    ref.active = clock::now();
+    if (ref.connection.idle_timeout.count() > 0)
+    {
+        _next_check = std::min(_next_check,
+                               ref.active + ref.connection.idle_timeout);
+    }
+
+    Poco::Net::StreamSocket &socket = ref.connection.session->socket();
+    socket.setBlocking(false);
+
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = ref.id;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, socket.impl()->sockfd(), &event) < 0)
+    {
+        end(ref, error::UNKNOWN, "Could not watch connection");
+        return;
+    }
+    ttdebug << "Multiplexing stream " << ref.id << ".\n";
+
+    // The rest of the body that was read with the headers.
+    const string buffered = std::move(ref.connection.buffered);
+    if (!decode(ref, buffered.data(), buffered.size()))
+    {
+        end(ref, error::OK, "");
+        return;
+    }
+
+    // TLS may have decrypted data already, epoll would not report it.
+    read(ref);
+}
+
+void stream_multiplexer::loop::erase(const id_type id)
+{
+    const auto it = _subscriptions.find(id);
+    if (it == _subscriptions.end())
+    {
+        return;
+    }
+
+    const int fd = it->second->connection.session->socket().impl()->sockfd();
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    _subscriptions.erase(it);
+    ttdebug << "Stream " << id << " removed.\n";
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_count;
+}
+
+bool stream_multiplexer::loop::read(subscription &sub)
+{
+    Poco::Net::StreamSocket &socket = sub.connection.session->socket();
+
+    // Read until the socket would block. epoll doesn't know about data
+    // that TLS has decrypted already.
+    while (!sub.removed)
+    {
+        int size;
+        try
+        {
+            size = socket.receiveBytes(_buffer, sizeof(_buffer));
+        }
+        catch (const Poco::Net::SSLException &e)
+        {
+            end(sub, error::ENCRYPTION, e.displayText());
+            return false;
+        }
+        catch (const Poco::TimeoutException &e)
+        {
+            end(sub, error::CONNECTION_TIMEOUT, e.displayText());
+            return false;
+        }
+        catch (const Poco::Exception &e)
+        {
+            end(sub, error::UNKNOWN, e.displayText());
+            return false;
+        }
+
+        if (size == 0)
+        {
+            end(sub, error::OK, "");
+            return false;
+        }
+        if (size < 0)
+        {                       // Would block.
+            return true;
+        }
+        sub.active = clock::now();
+
+        if (!decode(sub, _buffer, static_cast<std::size_t>(size)))
+        {
+            end(sub, error::OK, "");
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool stream_multiplexer::loop::decode(subscription &sub, const char *data,
+                                      std::size_t size)
+{
+    if (!sub.connection.chunked)
+    {
+        sub.parser.feed(data, size);
+        return true;
+    }
+
+    while (size > 0)
+    {
+        if (sub.in_data)
+        {
+            if (sub.left > 0)
+            {
+                const std::size_t piece = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(sub.left, size));
+                sub.parser.feed(data, piece);
+                data += piece;
+                size -= piece;
+                sub.left -= piece;
+                continue;
+            }
+
+            // Skip the line break after the data.
+            const char *end = static_cast<const char *>(
+                std::memchr(data, '\n', size));
+            if (end == nullptr)
+            {
+                return true;
+            }
+            size -= static_cast<std::size_t>(end + 1 - data);
+            data = end + 1;
+            sub.in_data = false;
+            continue;
+        }
+
+        // The size of the next chunk, in hex, followed by a line break.
+        const char *end = static_cast<const char *>(
+            std::memchr(data, '\n', size));
+        if (end == nullptr)
+        {
+            sub.size_line.append(data, size);
+            return true;
+        }
+        sub.size_line.append(data, static_cast<std::size_t>(end - data));
+        size -= static_cast<std::size_t>(end + 1 - data);
+        data = end + 1;
+
+        sub.left = std::strtoull(sub.size_line.c_str(), nullptr, 16);
+        sub.size_line.clear();
+        if (sub.left == 0)
+        {                       // The last chunk.
+            return false;
+        }
+        sub.in_data = true;
+    }
+
+    return true;
+}
+
+void stream_multiplexer::loop::end(subscription &sub, const error code,
+                                   const string &message)
+{
+    if (sub.removed)
+    {
+        return;
+    }
+
+    ttdebug << "Stream " << sub.id << " ended: " << message << '\n';
+    sub.parser.finish();
+
+    // Errors have no HTTP status, like in API::http::request_stream().
+    const string data = "{\"error_code\":"
+        + std::to_string(static_cast<int>(code)) + ",\"http_error\":"
+        + (code == error::OK ? "200" : "0") + "}";
+    sub.callback({ "ERROR", 5, data.data(), data.size() });
+    sub.removed = true;
+}
+
+stream_multiplexer::stream_multiplexer(const std::size_t threads)
+: _target(0)
+, _next_id(0)
+{
+    resize(threads);
+}
+
+stream_multiplexer::~stream_multiplexer()
+{}
+
+stream_multiplexer::id_type stream_multiplexer::add(
+    stream_connection &&connection, const sse_parser::callback_type &callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // The loop with the fewest streams.
+    std::size_t index = 0;
+    std::size_t fewest = _loops[0]->size();
+    for (std::size_t i = 1; i < _target; ++i)
+    {
+        const std::size_t size = _loops[i]->size();
+        if (size < fewest)
+        {
+            index = i;
+            fewest = size;
+        }
+    }
+
+    const id_type id = (++_next_id << loop_bits) | index;
+    _loops[index]->add(id, std::move(connection), callback);
+
+    return id;
+}
+
+void stream_multiplexer::remove(const id_type id)
+{
+    loop *target;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const std::size_t index = id & ((1U << loop_bits) - 1);
+        if (id == wakeup_id || index >= _loops.size())
+        {
+            return;
+        }
+        target = _loops[index].get();
+    }
+
+    target->remove(id);
+}
+
+void stream_multiplexer::resize(const std::size_t threads)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _target = std::min<std::size_t>(std::max<std::size_t>(threads, 1),
+                                    1U << loop_bits);
+    while (_loops.size() < _target)
+    {
+        _loops.push_back(std::make_unique<loop>());
+    }
+}
+
+std::size_t stream_multiplexer::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::size_t count = 0;
+    for (const unique_ptr<loop> &l : _loops)
+    {
+        count += l->size();
+    }
+    return count;
+}
@@ -0,0 +1,140 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MASTODON_CPP_STREAM_MULTIPLEXER_HPP
+#define MASTODON_CPP_STREAM_MULTIPLEXER_HPP
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <Poco/Net/HTTPClientSession.h>
+#include "sse_parser.hpp"
+
+using std::string;
+using std::unique_ptr;
+using Poco::Net::HTTPClientSession;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  A stream whose headers were received, see
+     *          API::http::open_stream().
+     *
+     *  @since  0.112.0
+     */
+    typedef struct stream_connection
+    {
+        /*!
+         *  @brief  The session of the stream, nullptr if it failed.
+         */
+        unique_ptr<HTTPClientSession> session;
+
+        /*!
+         *  @brief  The body uses chunked transfer encoding.
+         */
+        bool chunked = false;
+
+        /*!
+         *  @brief  Body that was read together with the headers.
+         */
+        string buffered;
+
+        /*!
+         *  @brief  The stream ends if nothing arrives for this long, 0
+         *          means never.
+         */
+        std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0);
+    } stream_connection;
+
+    /*!
+     *  @brief  Reads many streams with a few threads.
+     *
+     *          Every thread waits for data on all of its streams with
+     *          epoll and reads them without blocking. The events are passed
+     *          to the callback of the stream in the thread that read them,
+     *          a slow callback delays the other streams of the thread. New
+     *          streams go to the thread with the fewest streams.
+     *
+     *          When a stream ends, an `ERROR` event is passed, like with
+     *          API::get_stream(). Streams that are idle for longer than
+     *          stream_connection::idle_timeout end with
+     *          error::CONNECTION_TIMEOUT.
+     *
+     *          Only available on Linux.
+     *
+     *  @since  0.112.0
+     */
+    class stream_multiplexer
+    {
+    public:
+        using id_type = std::uint64_t;
+
+        /*!
+         *  @param  threads  Number of threads, at least 1.
+         */
+        explicit stream_multiplexer(const std::size_t threads);
+
+        ~stream_multiplexer();
+
+        /*!
+         *  @brief  Read connection until it ends or is removed.
+         *
+         *  @return ID of the stream, for remove().
+         */
+        id_type add(stream_connection &&connection,
+                    const sse_parser::callback_type &callback);
+
+        /*!
+         *  @brief  Stop reading a stream and close its connection.
+         *
+         *          The callback is not called after this returns, unless
+         *          called from a callback. From the callback of the same
+         *          stream, no further events are passed. From the callback
+         *          of another stream, this does not wait and a few more
+         *          events may be passed. Unknown IDs are ignored.
+         */
+        void remove(const id_type id);
+
+        /*!
+         *  @brief  Set the number of threads.
+         *
+         *          Threads are added at once. If the number is reduced,
+         *          surplus threads get no new streams, but keep the ones
+         *          they have.
+         */
+        void resize(const std::size_t threads);
+
+        /*!
+         *  @brief  Returns the number of streams.
+         */
+        std::size_t size() const;
+
+    private:
+        class loop;
+
+        std::vector<unique_ptr<loop>> _loops;
+        std::size_t _target;
+        id_type _next_id;
+        // Guards everything above.
+        mutable std::mutex _mutex;
+    };
+}
+
+#endif  // MASTODON_CPP_STREAM_MULTIPLEXER_HPP
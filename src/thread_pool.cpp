@@ -0,0 +1,139 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include "debug.hpp"
+#include "thread_pool.hpp"
+
+using namespace Mastodon;
+
+thread_pool::thread_pool(const std::size_t threads)
+: _target(0)
+, _running(0)
+, _stop(false)
+{
+    resize(threads);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+
+    for (std::thread &thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+void thread_pool::submit(task_type task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _cv.notify_one();
+}
+
+void thread_pool::resize(const std::size_t threads)
+{
+    std::vector<std::thread> exited;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _target = std::max<std::size_t>(threads, 1);
+
+        // Move the threads that have returned from work() out, so that
+        // _threads does not grow with every resize.
+        auto is_exited = [this](const std::thread &thread)
+        {
+            return std::find(_exited.begin(), _exited.end(), thread.get_id())
+                != _exited.end();
+        };
+        auto end = std::stable_partition(
+            _threads.begin(), _threads.end(),
+            [&is_exited](const std::thread &thread)
+            {
+                return !is_exited(thread);
+            });
+        std::move(end, _threads.end(), std::back_inserter(exited));
+        _threads.erase(end, _threads.end());
+        _exited.clear();
+
+        while (_running < _target)
+        {
+            _threads.emplace_back(&thread_pool::work, this);
+            ++_running;
+        }
+    }
+
+    // Wake up threads that have to exit.
+    _cv.notify_all();
+
+    for (std::thread &thread : exited)
+    {
+        thread.join();
+    }
+}
+
+std::size_t thread_pool::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _target;
+}
+
+void thread_pool::work()
+{
+    while (true)
+    {
+        task_type task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this]
+                     {
+                         return (_stop || !_tasks.empty()
+                                 || _running > _target);
+                     });
+
+            if (_running > _target || (_stop && _tasks.empty()))
+            {
+                --_running;
+                _exited.push_back(std::this_thread::get_id());
+                return;
+            }
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            // Tasks report their errors themselves, this must not happen.
+            ttlog(ERROR) << "Uncaught exception in worker thread: "
+                         << e.what() << '\n';
+        }
+    }
+}
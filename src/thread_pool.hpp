@@ -0,0 +1,88 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_THREAD_POOL_HPP
+#define MASTODON_CPP_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Fixed number of worker threads processing a queue of tasks.
+     *          Used for the asynchronous calls of API.
+     *
+     *  @since  0.112.0
+     */
+    class thread_pool
+    {
+    public:
+        using task_type = std::function<void()>;
+
+        /*!
+         *  @brief  Starts the worker threads.
+         *
+         *  @param  threads Number of threads, at least 1 is used.
+         */
+        explicit thread_pool(const std::size_t threads);
+
+        /*!
+         *  @brief  Waits until all queued tasks are finished.
+         */
+        ~thread_pool();
+
+        thread_pool(const thread_pool &) = delete;
+        thread_pool &operator=(const thread_pool &) = delete;
+
+        /*!
+         *  @brief  Add a task to the queue.
+         */
+        void submit(task_type task);
+
+        /*!
+         *  @brief  Change the number of worker threads.
+         *
+         *          Surplus threads exit after their current task. Threads
+         *          that have exited since the last call are joined.
+         */
+        void resize(const std::size_t threads);
+
+        /*!
+         *  @brief  Returns the number of worker threads.
+         */
+        std::size_t size() const;
+
+    private:
+        std::vector<std::thread> _threads;
+        std::vector<std::thread::id> _exited;
+        std::deque<task_type> _tasks;
+        mutable std::mutex _mutex;
+        std::condition_variable _cv;
+        std::size_t _target;
+        std::size_t _running;
+        bool _stop;
+
+        void work();
+    };
+}
+
+#endif  // MASTODON_CPP_THREAD_POOL_HPP
@@ -0,0 +1,190 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Poco/Version.h>
+#include <Poco/Net/SecureStreamSocket.h>
+#include "timed_session.hpp"
+
+using namespace Mastodon;
+using Poco::Net::SecureStreamSocket;
+
+const connection_timing &timed_http_session::timing() const
+{
+    return _timing;
+}
+
+std::string timed_http_session::take_buffered()
+{
+    std::string data(static_cast<std::size_t>(buffered()), '\0');
+    if (!data.empty())
+    {
+        // Copies from the buffer without reading from the socket.
+        HTTPSession::read(&data[0], static_cast<std::streamsize>(data.size()));
+    }
+    return data;
+}
+
+void timed_http_session::set_connect_hook(const connect_hook_type &hook)
+{
+    _hook = hook;
+}
+
+void timed_http_session::connect(const SocketAddress &address)
+{
+    // reconnect() resolves the address before it calls us.
+    _timing.dns = connection_timing::clock::now();
+    if (_hook)
+    {                           // Poco connects sockets that exist already.
+        const StreamSocket fresh(address.family());
+        _hook(fresh);
+        attachSocket(fresh);
+    }
+    HTTPClientSession::connect(address);
+    _timing.connect = connection_timing::clock::now();
+    _timing.tls = _timing.connect;
+    ++_timing.connects;
+}
+
+const connection_timing &timed_https_session::timing() const
+{
+    return _timing;
+}
+
+std::string timed_https_session::take_buffered()
+{
+    std::string data(static_cast<std::size_t>(buffered()), '\0');
+    if (!data.empty())
+    {
+        HTTPSession::read(&data[0], static_cast<std::streamsize>(data.size()));
+    }
+    return data;
+}
+
+void timed_https_session::set_connect_hook(const connect_hook_type &hook)
+{
+    _hook = hook;
+}
+
+void timed_https_session::connect(const SocketAddress &address)
+{
+    _timing.dns = connection_timing::clock::now();
+
+    if (!getProxyHost().empty())
+    {                           // The handshake happens inside the tunnel.
+        HTTPSClientSession::connect(address);
+        _timing.connect = connection_timing::clock::now();
+        _timing.tls = _timing.connect;
+        ++_timing.connects;
+        if (_hook)
+        {
+            _hook(socket());
+        }
+        return;
+    }
+
+    if (_hook)
+    {
+        // The socket inside a SecureStreamSocket is created while it
+        // connects. Connect a plain socket and start TLS over it instead.
+        StreamSocket plain(address.family());
+        _hook(plain);
+#if POCO_VERSION >= 0x01070000
+        plain.connect(address, getConnectionTimeout());
+        plain.setSendTimeout(getSendTimeout());
+        plain.setReceiveTimeout(getReceiveTimeout());
+#else
+        plain.connect(address, getTimeout());
+        plain.setSendTimeout(getTimeout());
+        plain.setReceiveTimeout(getTimeout());
+#endif
+        plain.setNoDelay(true);
+        _timing.connect = connection_timing::clock::now();
+
+        // Does the handshake and verifies the certificate.
+        attachSocket(SecureStreamSocket::attach(plain, getHost(), context(),
+                                                sslSession()));
+        _timing.tls = connection_timing::clock::now();
+        ++_timing.connects;
+        return;
+    }
+
+    SecureStreamSocket secure(socket());
+    secure.setLazyHandshake(true);
+    HTTPSClientSession::connect(address);
+    _timing.connect = connection_timing::clock::now();
+
+    // After a lazy handshake, Poco verifies the certificate on the first
+    // write, but only if the handshake is not complete by then.
+    secure.completeHandshake();
+    secure.verifyPeerCertificate();
+    _timing.tls = connection_timing::clock::now();
+    ++_timing.connects;
+}
+
+const connection_timing *Mastodon::get_timing(
+    const HTTPClientSession &session)
+{
+    const auto *https = dynamic_cast<const timed_https_session *>(&session);
+    if (https != nullptr)
+    {
+        return &https->timing();
+    }
+
+    const auto *http = dynamic_cast<const timed_http_session *>(&session);
+    if (http != nullptr)
+    {
+        return &http->timing();
+    }
+
+    return nullptr;
+}
+
+bool Mastodon::set_connect_hook(HTTPClientSession &session,
+                                const connect_hook_type &hook)
+{
+    auto *https = dynamic_cast<timed_https_session *>(&session);
+    if (https != nullptr)
+    {
+        https->set_connect_hook(hook);
+        return true;
+    }
+
+    auto *http = dynamic_cast<timed_http_session *>(&session);
+    if (http != nullptr)
+    {
+        http->set_connect_hook(hook);
+        return true;
+    }
+
+    return false;
+}
+
+std::string Mastodon::take_buffered(HTTPClientSession &session)
+{
+    auto *https = dynamic_cast<timed_https_session *>(&session);
+    if (https != nullptr)
+    {
+        return https->take_buffered();
+    }
+
+    auto *http = dynamic_cast<timed_http_session *>(&session);
+    if (http != nullptr)
+    {
+        return http->take_buffered();
+    }
+
+    return "";
+}
@@ -0,0 +1,175 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_TIMED_SESSION_HPP
+#define MASTODON_CPP_TIMED_SESSION_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+
+using Poco::Net::HTTPClientSession;
+using Poco::Net::HTTPSClientSession;
+using Poco::Net::SocketAddress;
+using Poco::Net::StreamSocket;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  When the last connection of a session was established.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct connection_timing
+    {
+        using clock = std::chrono::steady_clock;
+
+        /*!
+         *  @brief  The address of the host was resolved.
+         */
+        clock::time_point dns;
+
+        /*!
+         *  @brief  The TCP connection was established.
+         */
+        clock::time_point connect;
+
+        /*!
+         *  @brief  The TLS handshake was finished. Equal to connect without
+         *          TLS or with a proxy.
+         */
+        clock::time_point tls;
+
+        /*!
+         *  @brief  Number of connections the session has made.
+         */
+        std::uint64_t connects = 0;
+    } connection_timing;
+
+    /*!
+     *  @brief  Receives the socket of a session before it connects.
+     *
+     *  @since  0.112.0
+     */
+    using connect_hook_type = std::function<void(const StreamSocket &socket)>;
+
+    /*!
+     *  @brief  HTTPClientSession that records connection_timing.
+     *
+     *  @since  0.112.0
+     */
+    class timed_http_session : public HTTPClientSession
+    {
+    public:
+        using HTTPClientSession::HTTPClientSession;
+
+        const connection_timing &timing() const;
+
+        /*!
+         *  @brief  Removes the data that was read from the socket but not
+         *          consumed yet, and returns it.
+         */
+        std::string take_buffered();
+
+        /*!
+         *  @brief  Call hook with the socket before it connects.
+         */
+        void set_connect_hook(const connect_hook_type &hook);
+
+    protected:
+        void connect(const SocketAddress &address) override;
+
+    private:
+        connection_timing _timing;
+        connect_hook_type _hook;
+    };
+
+    /*!
+     *  @brief  HTTPSClientSession that records connection_timing.
+     *
+     *          Connects first and does the TLS handshake afterwards, so
+     *          that both can be timed.
+     *
+     *  @since  0.112.0
+     */
+    class timed_https_session : public HTTPSClientSession
+    {
+    public:
+        using HTTPSClientSession::HTTPSClientSession;
+
+        const connection_timing &timing() const;
+
+        /*!
+         *  @brief  Removes the data that was read from the socket but not
+         *          consumed yet, and returns it.
+         */
+        std::string take_buffered();
+
+        /*!
+         *  @brief  Call hook with the socket before it connects.
+         *
+         *          The TLS connection is set up over that socket. With a
+         *          proxy, hook is called after the TLS handshake.
+         */
+        void set_connect_hook(const connect_hook_type &hook);
+
+    protected:
+        void connect(const SocketAddress &address) override;
+
+    private:
+        connection_timing _timing;
+        connect_hook_type _hook;
+    };
+
+    /*!
+     *  @brief  Returns the connection_timing of session, or nullptr if it
+     *          is not a timed session.
+     *
+     *  @since  0.112.0
+     */
+    const connection_timing *get_timing(const HTTPClientSession &session);
+
+    /*!
+     *  @brief  Removes the data that session has read from the socket but
+     *          not consumed yet, and returns it. Used to read the rest of
+     *          the body from the socket directly.
+     *
+     *  @since  0.112.0
+     */
+    std::string take_buffered(HTTPClientSession &session);
+
+    /*!
+     *  @brief  Call hook with the socket of session before it connects,
+     *          so that another thread can abort the connection attempt by
+     *          shutting the socket down. Only for sessions that connect
+     *          once, like the ones of streams.
+     *
+     *          The address is resolved before hook is called.
+     *
+     *  @return false if session is not a timed session.
+     *
+     *  @since  0.112.0
+     */
+    bool set_connect_hook(HTTPClientSession &session,
+                          const connect_hook_type &hook);
+}
+
+#endif  // MASTODON_CPP_TIMED_SESSION_HPP
@@ -0,0 +1,74 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Poco/Net/SSLManager.h>
+#include <Poco/Net/SecureStreamSocket.h>
+#include "debug.hpp"
+#include "tls_cache.hpp"
+#include "timed_session.hpp"
+
+using namespace Mastodon;
+using Poco::Net::SSLManager;
+using Poco::Net::Session;
+using Poco::Net::SecureStreamSocket;
+
+tls_cache::tls_cache()
+: _context(SSLManager::instance().defaultClientContext())
+{
+    // Shared by all connections of the process, enabling it twice is fine.
+    _context->enableSessionCache(true);
+}
+
+unique_ptr<HTTPSClientSession> tls_cache::make_session(
+    const string &host, const Poco::UInt16 port)
+{
+    Session::Ptr session;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _sessions.find(host);
+        if (it != _sessions.end())
+        {
+            session = it->second;
+        }
+    }
+
+    return std::make_unique<timed_https_session>(
+        host, port, _context, session);
+}
+
+void tls_cache::store(const string &host, HTTPClientSession &session)
+{
+    auto *https = dynamic_cast<HTTPSClientSession *>(&session);
+    if (https == nullptr)
+    {
+        return;
+    }
+
+    // sslSession() is taken before the handshake of timed_https_session.
+    Session::Ptr tls_session =
+        SecureStreamSocket(https->socket()).currentSession();
+    if (!tls_session.isNull())
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sessions[host] = tls_session;
+    }
+}
+
+void tls_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sessions.clear();
+}
@@ -0,0 +1,83 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_TLS_CACHE_HPP
+#define MASTODON_CPP_TLS_CACHE_HPP
+
+#include <string>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/Context.h>
+#include <Poco/Net/Session.h>
+
+using std::string;
+using std::unique_ptr;
+using Poco::Net::HTTPClientSession;
+using Poco::Net::HTTPSClientSession;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Shares the SSL context and remembers the last TLS session of
+     *          every host. Used by API::http.
+     *
+     *          New connections resume the TLS session of the previous
+     *          connection, which saves a full handshake.
+     *
+     *  @since  0.112.0
+     */
+    class tls_cache
+    {
+    public:
+        /*!
+         *  @brief  Uses the default client context of Poco's SSLManager and
+         *          enables the session cache on it.
+         *
+         *          Poco::Net::initializeSSL() must have been called.
+         */
+        tls_cache();
+
+        /*!
+         *  @brief  Create a timed_https_session to host that resumes the
+         *          last TLS session, if there is one.
+         */
+        unique_ptr<HTTPSClientSession> make_session(
+            const string &host,
+            const Poco::UInt16 port = HTTPSClientSession::HTTPS_PORT);
+
+        /*!
+         *  @brief  Remember the TLS session of a connected session.
+         *
+         *          Does nothing if the session doesn't use TLS.
+         */
+        void store(const string &host, HTTPClientSession &session);
+
+        /*!
+         *  @brief  Forget all TLS sessions.
+         */
+        void clear();
+
+    private:
+        Poco::Net::Context::Ptr _context;
+        std::map<string, Poco::Net::Session::Ptr> _sessions;
+        std::mutex _mutex;
+    };
+}
+
+#endif  // MASTODON_CPP_TLS_CACHE_HPP
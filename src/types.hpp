@@ -20,6 +20,11 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <functional>
 
 using std::string;
 using std::vector;
@@ -105,6 +110,354 @@ namespace Mastodon
         ENCRYPTION = 14,
         UNKNOWN = 127
     };
+
+    /*!
+     *  @brief  Settings for the connection pool.
+     *
+     *          Connections are kept open after a request and reused for the
+     *          next request to the same host.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct connection_pool_config
+    {
+        /*!
+         *  @brief  Maximum number of idle connections kept per host.
+         *
+         *          0 disables the pool.
+         */
+        std::size_t max_idle = 8;
+
+        /*!
+         *  @brief  Idle connections are closed after this time.
+         */
+        std::chrono::seconds idle_timeout = std::chrono::seconds(30);
+
+        /*!
+         *  @brief  Maximum number of simultaneous connections per host.
+         *
+         *          Requests wait until a connection is free if the limit is
+         *          reached. 0 means no limit.
+         */
+        std::size_t max_per_host = 0;
+    } connection_pool_config;
+
+    /*!
+     *  @brief  Settings for the rate limit scheduler.
+     *
+     *          The scheduler reads the `X-RateLimit-*` headers of the
+     *          answers and holds requests back when the budget is used up,
+     *          instead of sending them and getting HTTP 429.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct rate_limit_config
+    {
+        /*!
+         *  @brief  Enable the scheduler. Disabled by default.
+         */
+        bool enabled = false;
+
+        /*!
+         *  @brief  Number of requests of the budget that are never used.
+         *
+         *          Useful if other clients share the access token.
+         */
+        std::size_t reserve = 0;
+
+        /*!
+         *  @brief  Spread requests evenly over the rest of the window once
+         *          less than half of the budget is left.
+         *
+         *          Otherwise requests are sent immediately until the budget
+         *          is used up and then wait for the reset.
+         */
+        bool spread = true;
+    } rate_limit_config;
+
+    /*!
+     *  @brief  State of the rate limit scheduler.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct rate_limit_status
+    {
+        /*!
+         *  @brief  Requests allowed per window, -1 if unknown.
+         */
+        std::int64_t limit = -1;
+
+        /*!
+         *  @brief  Requests left in the current window, -1 if unknown.
+         */
+        std::int64_t remaining = -1;
+
+        /*!
+         *  @brief  When the window resets. Only valid if remaining is not -1.
+         */
+        std::chrono::system_clock::time_point reset;
+
+        /*!
+         *  @brief  Number of requests that were sent and not yet answered.
+         */
+        std::size_t in_flight = 0;
+
+        /*!
+         *  @brief  Number of requests that wait for budget.
+         */
+        std::size_t queued = 0;
+    } rate_limit_status;
+
+    /*!
+     *  @brief  Settings for retrying requests that failed temporarily.
+     *
+     *          Requests are retried if the connection was refused or timed
+     *          out, or if the server answered with 429, 502, 503 or 504.
+     *          The delay before attempt n is a random time between 0 and
+     *          min(max_delay, base_delay * 2^(n-2)) (“full jitter”). If the
+     *          server sends `Retry-After`, we wait at least that long.
+     *
+     *          GET, PUT and DELETE requests are retried automatically.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct retry_config
+    {
+        /*!
+         *  @brief  Maximum number of attempts, including the first one.
+         *
+         *          1 disables retries.
+         */
+        std::uint8_t max_attempts = 3;
+
+        /*!
+         *  @brief  Delay before the first retry, before jitter.
+         */
+        std::chrono::milliseconds base_delay = std::chrono::milliseconds(500);
+
+        /*!
+         *  @brief  Upper limit of the delay between attempts.
+         *
+         *          If `Retry-After` asks for a longer delay, the answer is
+         *          returned instead.
+         */
+        std::chrono::milliseconds max_delay = std::chrono::seconds(30);
+
+        /*!
+         *  @brief  Retry POST and PATCH requests too.
+         *
+         *          They are not idempotent, a request that timed out may
+         *          have been processed. Files can only be sent once, don't
+         *          enable this if you upload files.
+         */
+        bool retry_post = false;
+    } retry_config;
+
+    /*!
+     *  @brief  Timeouts for requests.
+     *
+     *          A timeout is reported as error::CONNECTION_TIMEOUT. A duration
+     *          of 0 means no timeout.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct timeout_config
+    {
+        /*!
+         *  @brief  Maximum time to establish a connection.
+         */
+        std::chrono::milliseconds connect = std::chrono::seconds(30);
+
+        /*!
+         *  @brief  Maximum time to send a piece of data.
+         */
+        std::chrono::milliseconds send = std::chrono::seconds(60);
+
+        /*!
+         *  @brief  Maximum time to wait for data from the server.
+         *
+         *          For streams this is the idle timeout. Mastodon sends a
+         *          heartbeat every few seconds.
+         */
+        std::chrono::milliseconds receive = std::chrono::seconds(60);
+
+        /*!
+         *  @brief  Maximum time for the whole request, including retries.
+         *
+         *          Does not apply to streams.
+         */
+        std::chrono::milliseconds total = std::chrono::milliseconds(0);
+    } timeout_config;
+
+    /*!
+     *  @brief  Settings for the response cache.
+     *
+     *          Answers to GET requests are kept in memory, as long as
+     *          `Cache-Control` allows it. Stale answers with an `ETag` or
+     *          `Last-Modified` header are revalidated with a conditional
+     *          request. If the server answers with 304, the cached body is
+     *          returned.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct cache_config
+    {
+        /*!
+         *  @brief  Enable the cache. Disabled by default.
+         */
+        bool enabled = false;
+
+        /*!
+         *  @brief  Maximum number of cached answers.
+         */
+        std::size_t max_entries = 256;
+
+        /*!
+         *  @brief  Maximum size of all cached answers in bytes.
+         */
+        std::size_t max_bytes = 8 * 1024 * 1024;
+    } cache_config;
+
+    /*!
+     *  @brief  Counters of the response cache.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct cache_stats
+    {
+        /*!
+         *  @brief  Answers served from the cache without a request.
+         */
+        std::uint64_t hits = 0;
+
+        /*!
+         *  @brief  Answers served from the cache after the server answered
+         *          a conditional request with 304.
+         */
+        std::uint64_t revalidations = 0;
+
+        /*!
+         *  @brief  Requests that were not answered from the cache.
+         */
+        std::uint64_t misses = 0;
+
+        /*!
+         *  @brief  Number of cached answers.
+         */
+        std::size_t entries = 0;
+
+        /*!
+         *  @brief  Size of all cached answers in bytes.
+         */
+        std::size_t bytes = 0;
+    } cache_stats;
+
+    /*!
+     *  @brief  Mode of the cassette, see Mastodon::cassette_config.
+     *
+     *  @since  0.112.0
+     */
+    enum class cassette_mode
+    {
+        OFF,
+        RECORD,
+        REPLAY
+    };
+
+    /*!
+     *  @brief  Settings for recording and replaying requests.
+     *
+     *          In RECORD mode, every request and its answer (status,
+     *          headers, body and duration) is appended to file. In REPLAY
+     *          mode, the answers are read from file and returned without
+     *          touching the network.
+     *
+     *          Requests are matched by method and path, including the query
+     *          string. Answers to requests that were made more than once are
+     *          returned in the recorded order, starting over after the last
+     *          one. Streams are not recorded.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct cassette_config
+    {
+        /*!
+         *  @brief  OFF, RECORD or REPLAY.
+         */
+        cassette_mode mode = cassette_mode::OFF;
+
+        /*!
+         *  @brief  The cassette file.
+         */
+        std::string file;
+
+        /*!
+         *  @brief  Wait as long as the recorded request took when replaying.
+         *          By default answers are returned immediately.
+         */
+        bool keep_timing = false;
+    } cassette_config;
+
+    /*!
+     *  @brief  Severity of log messages, see Mastodon::set_log_level().
+     *
+     *          Every level includes the levels before it.
+     *
+     *  @since  0.112.0
+     */
+    enum class log_level
+    {
+        OFF = 0,
+        ERROR = 1,
+        WARNING = 2,
+        INFO = 3,
+        TRACE = 4
+    };
+
+    /*!
+     *  @brief  A log message, see Mastodon::set_log_sink().
+     *
+     *  @since  0.112.0
+     */
+    typedef struct log_record
+    {
+        /*!
+         *  @brief  Severity of the message.
+         */
+        log_level level = log_level::INFO;
+
+        /*!
+         *  @brief  When the message was logged.
+         */
+        std::chrono::system_clock::time_point time;
+
+        /*!
+         *  @brief  The thread that logged the message.
+         */
+        std::thread::id thread;
+
+        /*!
+         *  @brief  Source file of mastodon-cpp that logged the message.
+         */
+        const char *file = "";
+
+        /*!
+         *  @brief  Line in file.
+         */
+        int line = 0;
+
+        /*!
+         *  @brief  The message, without a trailing newline.
+         */
+        string message;
+    } log_record;
+
+    /*!
+     *  @brief  Receives log messages, see Mastodon::set_log_sink().
+     *
+     *  @since  0.112.0
+     */
+    using log_sink_type = std::function<void(const log_record &record)>;
 }
 
 #endif  // MASTODON_CPP_TYPES_HPP
@@ -17,15 +17,35 @@
 #define CATCH_CONFIG_MAIN
 
 #include <cstdlib>
+#include <memory>
 #include <catch.hpp>
 #include "environment_variables.hpp"
+#include "mock_server.hpp"
 
 using std::string;
 using std::getenv;
 
+namespace
+{
+    std::unique_ptr<Mastodon::mock_server> mock;
+
+    // Starts the mock server if the instance is "mock".
+    const string get_instance(const char *env)
+    {
+        if (env != nullptr && string(env) == "mock")
+        {
+            mock = std::make_unique<Mastodon::mock_server>(
+                MASTODON_CPP_FIXTURES);
+            return mock->instance();
+        }
+
+        return (env ? env : "likeable.space");
+    }
+}
+
 // Declared in environment_variables.hpp
 const char *env_instance = getenv("MASTODON_CPP_INSTANCE");
-const string instance = (env_instance ? env_instance : "likeable.space");
+const string instance = get_instance(env_instance);
 const char *access_token = getenv("MASTODON_CPP_ACCESS_TOKEN");
 const char *env_user_id = getenv("MASTODON_CPP_USER_ID");
 const string user_id = (env_user_id ? env_user_id : "9hnrrVPriLiLVAhfVo");
@@ -0,0 +1,158 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <exception>
+#include <csignal>
+#include <pthread.h>
+#include "mock_server.hpp"
+
+using std::cout;
+using std::cerr;
+using std::string;
+using std::stoul;
+
+namespace
+{
+    void usage(const char *name)
+    {
+        cerr << "usage: " << name << " [--port N] [--fixtures DIR] [--tls]"
+             << " [--latency MS] [--bandwidth BYTES_PER_S]\n"
+             << "       [--upload-bandwidth BYTES_PER_S]"
+             << " [--content-encoding gzip|deflate]\n"
+             << "       [--error-every N] [--error-status CODE]"
+             << " [--drop-every N]\n"
+             << "       [--rate-limit N] [--enforce-rate-limit]\n"
+             << "       [--stream-events N] [--stream-interval MS]"
+             << " [--stream-idle MS]\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::uint16_t port = 0;
+    string fixtures = MASTODON_CPP_FIXTURES;
+    bool tls = false;
+    Mastodon::mock_config config;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const string arg = argv[i];
+            if (arg == "--enforce-rate-limit")
+            {
+                config.enforce_rate_limit = true;
+                continue;
+            }
+            if (arg == "--tls")
+            {
+                tls = true;
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+
+            const string value = argv[++i];
+            if (arg == "--port")
+            {
+                port = static_cast<std::uint16_t>(stoul(value));
+            }
+            else if (arg == "--fixtures")
+            {
+                fixtures = value;
+            }
+            else if (arg == "--latency")
+            {
+                config.latency = std::chrono::milliseconds(stoul(value));
+            }
+            else if (arg == "--bandwidth")
+            {
+                config.bandwidth = stoul(value);
+            }
+            else if (arg == "--upload-bandwidth")
+            {
+                config.upload_bandwidth = stoul(value);
+            }
+            else if (arg == "--content-encoding")
+            {
+                config.content_encoding = value;
+            }
+            else if (arg == "--drop-every")
+            {
+                config.drop_every = static_cast<std::uint32_t>(stoul(value));
+            }
+            else if (arg == "--error-every")
+            {
+                config.error_every = static_cast<std::uint32_t>(stoul(value));
+            }
+            else if (arg == "--error-status")
+            {
+                config.error_status = static_cast<std::uint16_t>(stoul(value));
+            }
+            else if (arg == "--rate-limit")
+            {
+                config.rate_limit = static_cast<std::uint32_t>(stoul(value));
+            }
+            else if (arg == "--stream-events")
+            {
+                config.stream_events =
+                    static_cast<std::uint32_t>(stoul(value));
+            }
+            else if (arg == "--stream-interval")
+            {
+                config.stream_interval =
+                    std::chrono::milliseconds(stoul(value));
+            }
+            else if (arg == "--stream-idle")
+            {
+                config.stream_idle = std::chrono::milliseconds(stoul(value));
+            }
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Block the signals in all threads and wait for them in this one.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Mastodon::mock_server server(fixtures, port, tls);
+    server.set_config(config);
+    cout << "Listening on " << server.instance() << '\n';
+
+    int signal;
+    sigwait(&signals, &signal);
+    cout << "Received " << server.requests() << " requests.\n";
+
+    return 0;
+}
@@ -0,0 +1,575 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <vector>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/HTTPServerRequestImpl.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/SecureServerSocket.h>
+#include <Poco/Net/Context.h>
+#include <Poco/Net/NetSSL.h>
+#include <Poco/URI.h>
+#include <Poco/Timestamp.h>
+#include <Poco/DateTimeFormat.h>
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/DeflatingStream.h>
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::chrono::system_clock;
+using std::chrono::steady_clock;
+using std::chrono::seconds;
+using std::chrono::microseconds;
+using std::chrono::duration_cast;
+using Poco::Net::HTTPServer;
+using Poco::Net::HTTPServerParams;
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPRequestHandlerFactory;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+using Poco::Net::HTTPResponse;
+using Poco::Net::ServerSocket;
+using Poco::Net::SocketAddress;
+
+namespace
+{
+    typedef struct route
+    {
+        const string method;    // Empty matches every method.
+        const std::regex path;  // The first group is the ID.
+        const string fixture;
+    } route;
+
+    // The first matching route is used.
+    const std::vector<route> &routes()
+    {
+        static const std::vector<route> table =
+        {
+            { "GET", std::regex("/api/v1/instance"), "instance.json" },
+            { "GET", std::regex("/api/v1/accounts/verify_credentials"),
+              "account.json" },
+            { "GET", std::regex("/api/v1/accounts/relationships"),
+              "relationships.json" },
+            { "GET", std::regex("/api/v1/accounts/search"),
+              "accounts.json" },
+            { "GET", std::regex("/api/v1/accounts/([^/]+)"),
+              "account.json" },
+            { "GET", std::regex("/api/v1/accounts/([^/]+)/statuses"),
+              "statuses.json" },
+            { "GET", std::regex("/api/v1/accounts/([^/]+)/"
+                                "(?:followers|following)"),
+              "accounts.json" },
+            { "GET", std::regex("/api/v1/accounts/([^/]+)/lists"),
+              "lists.json" },
+            { "GET", std::regex("/api/v1/(?:blocks|mutes|follow_requests"
+                                "|endorsements|suggestions)"),
+              "accounts.json" },
+            { "GET", std::regex("/api/v1/domain_blocks"),
+              "domain_blocks.json" },
+            { "GET", std::regex("/api/v1/(?:favourites|bookmarks"
+                                "|timelines/home|timelines/public"
+                                "|timelines/(?:tag|list)/[^/]+)"),
+              "statuses.json" },
+            { "GET", std::regex("/api/v1/custom_emojis"), "emojis.json" },
+            { "GET", std::regex("/api/v1/lists"), "lists.json" },
+            { "GET", std::regex("/api/v1/lists/([^/]+)"), "list.json" },
+            { "GET", std::regex("/api/v1/lists/([^/]+)/accounts"),
+              "accounts.json" },
+            { "GET", std::regex("/api/v1/notifications"),
+              "notifications.json" },
+            { "GET", std::regex("/api/v1/notifications/([^/]+)"),
+              "notification.json" },
+            { "GET", std::regex("/api/v1/statuses/([^/]+)"), "status.json" },
+            { "GET", std::regex("/api/v1/statuses/([^/]+)/context"),
+              "context.json" },
+            { "GET", std::regex("/api/v1/statuses/([^/]+)/card"),
+              "card.json" },
+            { "GET", std::regex("/api/v1/statuses/([^/]+)/"
+                                "(?:reblogged_by|favourited_by)"),
+              "accounts.json" },
+            { "GET", std::regex("/api/v1/apps/verify_credentials"),
+              "application.json" },
+            { "GET", std::regex("/api/v1/filters"), "filters.json" },
+            { "GET", std::regex("/api/v1/filters/([^/]+)"), "filter.json" },
+            { "GET", std::regex("/api/v1/polls/([^/]+)"), "poll.json" },
+            { "GET", std::regex("/api/v1/conversations"),
+              "conversations.json" },
+            { "GET", std::regex("/api/v1/streaming/health"), "health.txt" },
+            { "GET", std::regex("/api/v1/streaming/.+"), "stream.txt" },
+            { "GET", std::regex("/api/v2/search"), "results.json" },
+            { "", std::regex("/api/v1/push/subscription"),
+              "push_subscription.json" },
+            { "POST", std::regex("/api/v1/apps"), "application.json" },
+            { "POST", std::regex("/api/v1/statuses"), "status.json" },
+            { "POST", std::regex("/api/v1/media"), "attachment.json" },
+            { "PUT", std::regex("/api/v1/media/([^/]+)"), "attachment.json" },
+            { "POST", std::regex("/api/v1/accounts/([^/]+)/(?:follow|unfollow"
+                                 "|block|unblock|mute|unmute|pin|unpin)"),
+              "relationship.json" },
+            { "POST", std::regex("/api/v1/statuses/([^/]+)/(?:favourite"
+                                 "|unfavourite|reblog|unreblog|pin|unpin"
+                                 "|mute|unmute|bookmark|unbookmark)"),
+              "status.json" },
+            { "POST", std::regex("/api/v1/lists"), "list.json" },
+            { "PUT", std::regex("/api/v1/lists/([^/]+)"), "list.json" },
+            { "POST", std::regex("/api/v1/filters"), "filter.json" },
+            { "PUT", std::regex("/api/v1/filters/([^/]+)"), "filter.json" },
+            { "POST", std::regex("/api/v1/polls/([^/]+)/votes"), "poll.json" },
+            { "PATCH", std::regex("/api/v1/accounts/update_credentials"),
+              "account.json" },
+            { "POST", std::regex("/api/v1/.+"), "empty.json" },
+            { "PUT", std::regex("/api/v1/.+"), "empty.json" },
+            { "DELETE", std::regex("/api/v1/.+"), "empty.json" }
+        };
+
+        return table;
+    }
+}
+
+class mock_server::handler : public HTTPRequestHandler
+{
+public:
+    explicit handler(mock_server &server)
+    : _server(server)
+    {
+        ++_server._active;
+    }
+
+    ~handler()
+    {
+        --_server._active;
+    }
+
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response) override
+    {
+        try
+        {
+            answer(request, response);
+        }
+        catch (const std::exception &e)
+        {
+            if (!response.sent())
+            {
+                response.setStatusAndReason(
+                    HTTPResponse::HTTP_INTERNAL_SERVER_ERROR);
+                send(response, string("{\"error\":\"") + e.what() + "\"}",
+                     mock_config());
+            }
+        }
+    }
+
+private:
+    mock_server &_server;
+
+    void answer(HTTPServerRequest &request, HTTPServerResponse &response)
+    {
+        const std::uint64_t number = ++_server._requests;
+        const system_clock::time_point now = system_clock::now();
+        mock_config config;
+        std::uint32_t used;
+        system_clock::time_point reset;
+        {
+            std::lock_guard<std::mutex> lock(_server._mutex);
+            config = _server._config;
+            if (now >= _server._window_start + config.rate_limit_window)
+            {
+                _server._window_start = now;
+                _server._window_used = 0;
+            }
+            used = ++_server._window_used;
+            reset = _server._window_start + config.rate_limit_window;
+        }
+
+        // Read the whole request, the connection is kept alive.
+        receive(request.stream(), config);
+
+        if (config.drop_every > 0 && number % config.drop_every == 0)
+        {                       // Nothing is sent, the client sees EOF.
+            static_cast<Poco::Net::HTTPServerRequestImpl &>(request)
+                .detachSocket().close();
+            return;
+        }
+
+        if (request.get("Accept-Encoding", "").find(config.content_encoding)
+            == string::npos)
+        {
+            config.content_encoding.clear();
+        }
+
+        std::this_thread::sleep_for(config.latency);
+
+        if (config.rate_limit_headers)
+        {
+            const std::uint32_t remaining =
+                (used < config.rate_limit ? config.rate_limit - used : 0);
+            response.set("X-RateLimit-Limit",
+                         std::to_string(config.rate_limit));
+            response.set("X-RateLimit-Remaining", std::to_string(remaining));
+            response.set("X-RateLimit-Reset",
+                         Poco::DateTimeFormatter::format(
+                             Poco::Timestamp::fromEpochTime(
+                                 system_clock::to_time_t(reset)),
+                             Poco::DateTimeFormat::ISO8601_FRAC_FORMAT));
+        }
+
+        if (config.enforce_rate_limit && used > config.rate_limit)
+        {
+            response.setStatusAndReason( // HTTP_TOO_MANY_REQUESTS
+                static_cast<HTTPResponse::HTTPStatus>(429));
+            // Rounded up, the client would come back too early.
+            response.set("Retry-After",
+                         std::to_string(duration_cast<seconds>(
+                                            reset - now + seconds(1)
+                                            - microseconds(1)).count()));
+            send(response, "{\"error\":\"Throttled\"}", config);
+            return;
+        }
+
+        if (config.error_every > 0 && number % config.error_every == 0)
+        {
+            response.setStatusAndReason(static_cast<HTTPResponse::HTTPStatus>(
+                                            config.error_status));
+            send(response, "{\"error\":\"Injected error\"}", config);
+            return;
+        }
+
+        const Poco::URI uri(request.getURI());
+        const string path = uri.getPath();
+        std::smatch match;
+        for (const route &r : routes())
+        {
+            if ((!r.method.empty() && r.method != request.getMethod())
+                || !std::regex_match(path, match, r.path))
+            {
+                continue;
+            }
+
+            string body = _server.fixture(r.fixture);
+            if (r.fixture == "stream.txt")
+            {
+                send_stream(response, body, config);
+                return;
+            }
+
+            const string id = (match.size() > 1 ? match[1].str() : "1");
+            size_t pos = 0;
+            while ((pos = body.find("{{id}}", pos)) != string::npos)
+            {
+                body.replace(pos, 6, id);
+                pos += id.size();
+            }
+
+            // Mastodon uses the same headers for every answer.
+            std::ostringstream etag;
+            etag << "W/\"" << std::hex << std::hash<string>()(body) << '"';
+            response.set("ETag", etag.str());
+            response.set("Cache-Control",
+                         "max-age=0, private, must-revalidate");
+            if (request.get("If-None-Match", "") == etag.str())
+            {
+                response.setStatusAndReason(HTTPResponse::HTTP_NOT_MODIFIED);
+                if (!config.content_encoding.empty())
+                {
+                    response.set("Content-Encoding", config.content_encoding);
+                }
+                response.setContentLength(0);
+                response.send();
+                return;
+            }
+
+            if (r.fixture.substr(r.fixture.size() - 4) == ".txt")
+            {
+                response.setContentType("text/plain; charset=utf-8");
+            }
+            send(response, body, config);
+            return;
+        }
+
+        response.setStatusAndReason(HTTPResponse::HTTP_NOT_FOUND);
+        send(response, "{\"error\":\"Record not found\"}", config);
+    }
+
+    // Reads the body of a request, not faster than config.upload_bandwidth.
+    void receive(std::istream &in, const mock_config &config)
+    {
+        if (config.upload_bandwidth == 0)
+        {
+            in.ignore(std::numeric_limits<std::streamsize>::max());
+            return;
+        }
+
+        // Slices of 10 ms.
+        const std::size_t slice =
+            std::max<std::size_t>(config.upload_bandwidth / 100, 1);
+        const steady_clock::time_point start = steady_clock::now();
+        std::uint64_t received = 0;
+        while (in.good() && !_server._stopping)
+        {
+            in.ignore(static_cast<std::streamsize>(slice));
+            received += static_cast<std::uint64_t>(in.gcount());
+            std::this_thread::sleep_until(
+                start + microseconds(received * 1000000
+                                     / config.upload_bandwidth));
+        }
+    }
+
+    // Compresses body with config.content_encoding and names it in
+    // response.
+    string encode(HTTPServerResponse &response, const string &body,
+                  const mock_config &config)
+    {
+        if (config.content_encoding != "gzip"
+            && config.content_encoding != "deflate")
+        {
+            return body;
+        }
+
+        std::ostringstream out;
+        Poco::DeflatingOutputStream deflater(
+            out, (config.content_encoding == "gzip"
+                  ? Poco::DeflatingStreamBuf::STREAM_GZIP
+                  : Poco::DeflatingStreamBuf::STREAM_ZLIB));
+        deflater << body;
+        deflater.close();
+        response.set("Content-Encoding", config.content_encoding);
+        return out.str();
+    }
+
+    // Sends body, not faster than config.bandwidth.
+    void send(HTTPServerResponse &response, const string &plain,
+              const mock_config &config)
+    {
+        if (response.getContentType().empty())
+        {
+            response.setContentType("application/json; charset=utf-8");
+        }
+        const string body = encode(response, plain, config);
+        response.setContentLength(static_cast<std::streamsize>(body.size()));
+        std::ostream &out = response.send();
+
+        if (config.body_stall.count() > 0)
+        {
+            const std::size_t half = body.size() / 2;
+            out.write(body.data(), static_cast<std::streamsize>(half));
+            out.flush();
+            std::this_thread::sleep_for(config.body_stall);
+            out.write(body.data() + half,
+                      static_cast<std::streamsize>(body.size() - half));
+            return;
+        }
+
+        if (config.bandwidth == 0)
+        {
+            out << body;
+            return;
+        }
+
+        // Slices of 10 ms.
+        const std::size_t slice =
+            std::max<std::size_t>(config.bandwidth / 100, 1);
+        const steady_clock::time_point start = steady_clock::now();
+        for (std::size_t pos = 0; pos < body.size() && out.good();
+             pos += slice)
+        {
+            const std::size_t size = std::min(slice, body.size() - pos);
+            out.write(body.data() + pos, static_cast<std::streamsize>(size));
+            out.flush();
+            std::this_thread::sleep_until(
+                start + microseconds((pos + size) * 1000000
+                                     / config.bandwidth));
+        }
+    }
+
+    // Sends the events of the fixture, separated by empty lines, in turn.
+    void send_stream(HTTPServerResponse &response, const string &fixture,
+                     const mock_config &config)
+    {
+        std::vector<string> events;
+        size_t start = 0;
+        size_t end;
+        while ((end = fixture.find("\n\n", start)) != string::npos)
+        {
+            events.push_back(fixture.substr(start, end - start + 1));
+            start = end + 2;
+        }
+        if (fixture.find_first_not_of('\n', start) != string::npos)
+        {
+            events.push_back(fixture.substr(start));
+        }
+
+        response.setChunkedTransferEncoding(true);
+        response.setContentType("text/event-stream");
+        std::ostream &out = response.send();
+        out.flush();
+
+        for (std::uint32_t i = 0; i < config.stream_events && !events.empty()
+                 && out.good() && !_server._stopping; ++i)
+        {
+            std::this_thread::sleep_for(config.stream_interval);
+            out << events[i % events.size()] << '\n';
+            out.flush();
+        }
+
+        const steady_clock::time_point idle_end =
+            steady_clock::now() + config.stream_idle;
+        while (steady_clock::now() < idle_end && out.good()
+               && !_server._stopping)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+};
+
+class mock_server::factory : public HTTPRequestHandlerFactory
+{
+public:
+    explicit factory(mock_server &server)
+    : _server(server)
+    {}
+
+    HTTPRequestHandler *createRequestHandler(const HTTPServerRequest &)
+        override
+    {
+        return new handler(_server);
+    }
+
+private:
+    mock_server &_server;
+};
+
+mock_server::mock_server(const string &fixtures, const std::uint16_t port,
+                         const bool tls)
+: _fixtures(fixtures)
+, _requests(0)
+, _stopping(false)
+, _active(0)
+, _window_start(system_clock::now())
+, _window_used(0)
+, _tls(tls)
+, _port(0)
+{
+    const SocketAddress address("127.0.0.1", port);
+    ServerSocket socket;
+    if (_tls)
+    {
+        Poco::Net::initializeSSL();
+        Poco::Net::Context::Ptr context = new Poco::Net::Context(
+            Poco::Net::Context::SERVER_USE, _fixtures + "/tls-key.pem",
+            _fixtures + "/tls-cert.pem", "", Poco::Net::Context::VERIFY_NONE);
+        // Lets clients resume their TLS sessions.
+        context->enableSessionCache(true, "mastodon-mock");
+        socket = Poco::Net::SecureServerSocket(address, 64, context);
+    }
+    else
+    {
+        socket = ServerSocket(address);
+    }
+    _port = socket.address().port();
+
+    HTTPServerParams *params = new HTTPServerParams;
+    params->setKeepAlive(true);
+
+    _server = std::make_unique<HTTPServer>(new factory(*this), socket,
+                                           params);
+    _server->start();
+}
+
+mock_server::~mock_server()
+{
+    _stopping = true;
+    _server->stopAll(true);
+
+    // Handlers may still be waiting for latency.
+    while (_active > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (_tls)
+    {
+        _server.reset();
+        Poco::Net::uninitializeSSL();
+    }
+}
+
+std::uint16_t mock_server::port() const
+{
+    return _port;
+}
+
+const string mock_server::instance() const
+{
+    return (_tls ? "https" : "http") + string("://127.0.0.1:")
+        + std::to_string(_port);
+}
+
+void mock_server::set_config(const mock_config &config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _config = config;
+}
+
+const mock_config mock_server::get_config() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _config;
+}
+
+std::uint64_t mock_server::requests() const
+{
+    return _requests;
+}
+
+std::uint64_t mock_server::connections() const
+{
+    return static_cast<std::uint64_t>(_server->totalConnections());
+}
+
+const string mock_server::fixture(const string &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _cache.find(name);
+    if (it == _cache.end())
+    {
+        std::ifstream file(_fixtures + '/' + name);
+        if (!file.good())
+        {
+            throw std::runtime_error("Fixture not found: " + name);
+        }
+
+        std::ostringstream content;
+        content << file.rdbuf();
+        it = _cache.emplace(name, content.str()).first;
+    }
+
+    return it->second;
+}
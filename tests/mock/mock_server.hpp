@@ -0,0 +1,231 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODON_CPP_TEST_MOCK_SERVER_HPP
+#define MASTODON_CPP_TEST_MOCK_SERVER_HPP
+
+#include <string>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Poco
+{
+    namespace Net
+    {
+        class HTTPServer;
+    }
+}
+
+using std::string;
+
+namespace Mastodon
+{
+    /*!
+     *  @brief  Behaviour of the mock server.
+     *
+     *  @since  0.112.0
+     */
+    typedef struct mock_config
+    {
+        /*!
+         *  @brief  Delay before every answer.
+         */
+        std::chrono::milliseconds latency = std::chrono::milliseconds(0);
+
+        /*!
+         *  @brief  Maximum bytes per second per answer, 0 means unlimited.
+         */
+        std::uint64_t bandwidth = 0;
+
+        /*!
+         *  @brief  Maximum bytes per second read from the body of every
+         *          request, 0 means unlimited.
+         */
+        std::uint64_t upload_bandwidth = 0;
+
+        /*!
+         *  @brief  Compress answers with `gzip` or `deflate` if the request
+         *          accepts it. Answers without a body name the encoding,
+         *          too, like some servers do.
+         */
+        string content_encoding;
+
+        /*!
+         *  @brief  Pause after sending half of every body.
+         */
+        std::chrono::milliseconds body_stall = std::chrono::milliseconds(0);
+
+        /*!
+         *  @brief  Answer every nth request with error_status, 0 disables
+         *          error injection.
+         */
+        std::uint32_t error_every = 0;
+
+        /*!
+         *  @brief  Close the connection without answering every nth
+         *          request, like a server that closes an idle keep-alive
+         *          connection while the request is on its way. 0 disables
+         *          it.
+         */
+        std::uint32_t drop_every = 0;
+
+        /*!
+         *  @brief  HTTP status of injected errors.
+         */
+        std::uint16_t error_status = 503;
+
+        /*!
+         *  @brief  Send `X-RateLimit-*` headers, like Mastodon does.
+         */
+        bool rate_limit_headers = true;
+
+        /*!
+         *  @brief  Requests allowed per rate_limit_window.
+         */
+        std::uint32_t rate_limit = 300;
+
+        /*!
+         *  @brief  Length of the rate limit window.
+         */
+        std::chrono::seconds rate_limit_window = std::chrono::seconds(300);
+
+        /*!
+         *  @brief  Answer with 429 if the rate limit is exhausted.
+         */
+        bool enforce_rate_limit = false;
+
+        /*!
+         *  @brief  Number of events sent to streams before the connection
+         *          is closed.
+         */
+        std::uint32_t stream_events = 3;
+
+        /*!
+         *  @brief  Delay between stream events.
+         */
+        std::chrono::milliseconds stream_interval =
+            std::chrono::milliseconds(100);
+
+        /*!
+         *  @brief  Time the connection of a stream stays open after the
+         *          last event, without sending anything.
+         */
+        std::chrono::milliseconds stream_idle = std::chrono::milliseconds(0);
+    } mock_config;
+
+    /*!
+     *  @brief  HTTP server on the loopback interface that answers API calls
+     *          with canned fixtures.
+     *
+     *          Used to run the tests and benchmarks without network. The
+     *          fixtures are JSON files, `{{id}}` is replaced with the ID in
+     *          the path of the request. Streams send the events in
+     *          `stream.txt`.
+     *
+     *          Example:
+     *          @code
+     *          Mastodon::mock_server server(MASTODON_CPP_FIXTURES);
+     *          Mastodon::API masto(server.instance(), "");
+     *          @endcode
+     *
+     *  @since  0.112.0
+     */
+    class mock_server
+    {
+    public:
+        /*!
+         *  @brief  Starts the server.
+         *
+         *  @param  fixtures  Directory containing the fixtures.
+         *  @param  port      Port to listen on, 0 picks a free one.
+         *  @param  tls       Use HTTPS, with the self-signed certificate
+         *                    `tls-cert.pem` of the fixtures. Clients have
+         *                    to accept it.
+         */
+        explicit mock_server(const string &fixtures,
+                             const std::uint16_t port = 0,
+                             const bool tls = false);
+
+        /*!
+         *  @brief  Stops the server and closes open connections.
+         */
+        ~mock_server();
+
+        mock_server(const mock_server &) = delete;
+        mock_server &operator=(const mock_server &) = delete;
+
+        /*!
+         *  @brief  Returns the port the server listens on.
+         */
+        std::uint16_t port() const;
+
+        /*!
+         *  @brief  Returns the instance to pass to Mastodon::API, like
+         *          `http://127.0.0.1:12345`.
+         */
+        const string instance() const;
+
+        /*!
+         *  @brief  Change the behaviour of the server.
+         */
+        void set_config(const mock_config &config);
+
+        /*!
+         *  @brief  Returns the behaviour of the server.
+         */
+        const mock_config get_config() const;
+
+        /*!
+         *  @brief  Returns the number of requests received.
+         */
+        std::uint64_t requests() const;
+
+        /*!
+         *  @brief  Returns the number of connections accepted.
+         */
+        std::uint64_t connections() const;
+
+    private:
+        class handler;
+        class factory;
+        friend class handler;
+
+        const string _fixtures;
+        mock_config _config;
+        std::atomic<std::uint64_t> _requests;
+        std::atomic<bool> _stopping;
+        std::atomic<std::uint32_t> _active;     // Running handlers.
+        std::chrono::system_clock::time_point _window_start;
+        std::uint32_t _window_used;
+        std::map<string, string> _cache;
+        // Guards _config, _window_start, _window_used and _cache.
+        mutable std::mutex _mutex;
+        const bool _tls;
+        std::uint16_t _port;
+        std::unique_ptr<Poco::Net::HTTPServer> _server;
+
+        /*!
+         *  @brief  Returns the content of a fixture, read once.
+         */
+        const string fixture(const string &name);
+    };
+}
+
+#endif  // MASTODON_CPP_TEST_MOCK_SERVER_HPP
@@ -0,0 +1,96 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include <string>
+#include <future>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "easy/easy.hpp"
+#include "easy/entities/instance.hpp"
+#include "environment_variables.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Asynchronous calls work", "[api][mastodon][pleroma][glitch-soc]")
+{
+    GIVEN ("instance = " + instance)
+    {
+        Mastodon::Easy::API masto(instance, "");
+        return_call ret;
+        bool exception = false;
+
+        WHEN ("GET /api/v1/instance is called with get_async()")
+        {
+            try
+            {
+                std::future<return_call> future
+                    = masto.get_async(API::v1::instance);
+                ret = future.get();
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+                AND_THEN ("Answer is valid")
+            {
+                REQUIRE_FALSE(exception);
+
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.http_error_code == 200);
+
+                REQUIRE(Easy::Instance(ret.answer).valid());
+            }
+        }
+
+        WHEN ("GET /api/v1/instance is called with a callback")
+        {
+            std::promise<return_call> promise;
+            std::future<return_call> future = promise.get_future();
+
+            try
+            {
+                masto.get_async(API::v1::instance, {},
+                                [&promise](const return_call &r)
+                                {
+                                    promise.set_value(r);
+                                });
+                ret = future.get();
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+                AND_THEN ("Answer is valid")
+            {
+                REQUIRE_FALSE(exception);
+
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.http_error_code == 200);
+
+                REQUIRE(Easy::Instance(ret.answer).valid());
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "easy/easy.hpp"
+#include "easy/entities/account.hpp"
+#include "easy/entities/instance.hpp"
+#include "environment_variables.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Batches of calls work", "[api][mastodon][pleroma][glitch-soc]")
+{
+    GIVEN ("instance = " + instance + ", user_id = " + user_id)
+    {
+        Mastodon::Easy::API masto(instance, "");
+        std::vector<return_call> results;
+        bool exception = false;
+
+        WHEN ("GET /api/v1/instance and /api/v1/accounts/" + user_id
+              + " are called with get_batch()")
+        {
+            const std::vector<API::batch_call> calls =
+                {
+                    { API::v1::instance, {} },
+                    { API::v1::accounts_id, { { "id", { user_id } } } },
+                    { API::v1::instance, {} }
+                };
+
+            try
+            {
+                results = masto.get_batch(calls, 2);
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+                AND_THEN ("The answers are in the right order")
+            {
+                REQUIRE_FALSE(exception);
+
+                REQUIRE(results.size() == 3);
+                for (const return_call &ret : results)
+                {
+                    REQUIRE(ret.error_code == 0);
+                }
+
+                REQUIRE(Easy::Instance(results[0].answer).valid());
+                REQUIRE(Easy::Account(results[1].answer).id() == user_id);
+                REQUIRE(Easy::Instance(results[2].answer).valid());
+            }
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "cassette.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::string;
+
+SCENARIO ("Requests are recorded and replayed")
+{
+    GIVEN ("A cassette with 2 recorded answers to the same request")
+    {
+        const string file = "test_cassette.cassette";
+        std::remove(file.c_str());
+
+        cassette_config config;
+        config.file = file;
+        config.mode = cassette_mode::RECORD;
+        {
+            cassette recorder;
+            REQUIRE(recorder.set_config(config));
+
+            return_call ret(error::OK, "", 200, "first\nanswer");
+            ret.headers["Content-Type"] = "application/json";
+            recorder.record(http_method::GET, "/api/v1/instance", ret,
+                            ret.answer, std::chrono::microseconds(1000));
+            ret.answer = "second";
+            recorder.record(http_method::GET, "/api/v1/instance", ret,
+                            ret.answer, std::chrono::microseconds(1000));
+            recorder.record(http_method::POST, "/api/v1/statuses",
+                            { error::CONNECTION_REFUSED, "Injected", 503,
+                              "{}" },
+                            "{}", std::chrono::microseconds(10));
+        }
+
+        cassette player;
+        config.mode = cassette_mode::REPLAY;
+        REQUIRE(player.set_config(config));
+
+        WHEN ("The request is replayed 3 times")
+        {
+            const return_call first =
+                player.replay(http_method::GET, "/api/v1/instance", {});
+            const return_call second =
+                player.replay(http_method::GET, "/api/v1/instance", {});
+            const return_call third =
+                player.replay(http_method::GET, "/api/v1/instance", {});
+
+            THEN ("The answers are returned in order, starting over")
+            {
+                REQUIRE(first.answer == "first\nanswer");
+                REQUIRE(first.headers.at("content-type")
+                        == "application/json");
+                REQUIRE(second.answer == "second");
+                REQUIRE(third.answer == "first\nanswer");
+            }
+        }
+
+        WHEN ("A failed request is replayed")
+        {
+            const return_call ret =
+                player.replay(http_method::POST, "/api/v1/statuses", {});
+
+            THEN ("The error is returned")
+            {
+                REQUIRE(ret.error_code == 12);
+                REQUIRE(ret.error_message == "Injected");
+                REQUIRE(ret.http_error_code == 503);
+            }
+        }
+
+        WHEN ("The request is replayed to a sink")
+        {
+            string body;
+            const return_call ret =
+                player.replay(http_method::GET, "/api/v1/instance",
+                              [&body](const char *data,
+                                      const std::size_t size)
+                              {
+                                  body.append(data, size);
+                              });
+
+            THEN ("The body goes to the sink")
+            {
+                REQUIRE(body == "first\nanswer");
+                REQUIRE(ret.answer.empty());
+            }
+        }
+
+        WHEN ("A request that was not recorded is replayed")
+        {
+            const return_call ret =
+                player.replay(http_method::GET, "/api/v1/lists", {});
+
+            THEN ("An error is returned")
+            {
+                REQUIRE(ret.error_code == 12);
+                REQUIRE(ret.http_error_code == 0);
+            }
+        }
+
+        std::remove(file.c_str());
+    }
+}
+
+SCENARIO ("Errors recorded with a sink are replayed like the server sent them",
+          "[mock]")
+{
+    GIVEN ("A mock server that answers with 404 and a cassette")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config mock;
+        mock.error_every = 1;
+        mock.error_status = 404;
+        server.set_config(mock);
+
+        const string file = "test_cassette_sink.cassette";
+        std::remove(file.c_str());
+        cassette_config config;
+        config.file = file;
+        string body;
+        auto sink = [&body](const char *data, const std::size_t size)
+        {
+            body.append(data, size);
+        };
+
+        WHEN ("The answer is recorded and replayed")
+        {
+            API recorder(server.instance(), "");
+            config.mode = cassette_mode::RECORD;
+            REQUIRE(recorder.set_cassette(config));
+            const return_call live = recorder.get("/api/v1/instance", sink);
+            const string live_remaining =
+                recorder.get_header("X-RateLimit-Remaining");
+
+            API player(server.instance(), "");
+            config.mode = cassette_mode::REPLAY;
+            REQUIRE(player.set_cassette(config));
+            const return_call replayed = player.get("/api/v1/instance", sink);
+
+            THEN ("The body and the headers are the same")
+            {
+                REQUIRE(live.http_error_code == 404);
+                REQUIRE_FALSE(live.answer.empty());
+                REQUIRE(replayed.http_error_code == 404);
+                REQUIRE(replayed.answer == live.answer);
+                REQUIRE(body.empty());
+                REQUIRE_FALSE(live_remaining.empty());
+                REQUIRE(player.get_header("X-RateLimit-Remaining")
+                        == live_remaining);
+                REQUIRE(server.requests() == 1);
+            }
+        }
+
+        std::remove(file.c_str());
+    }
+}
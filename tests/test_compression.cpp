@@ -0,0 +1,81 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Compressed answers are decoded", "[mock][compression]")
+{
+    GIVEN ("A mock server")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        const string expected = masto.get(API::v1::instance).answer;
+        mock_config config;
+
+        WHEN ("The answer is compressed with gzip")
+        {
+            config.content_encoding = "gzip";
+            server.set_config(config);
+            return_call ret = masto.get(API::v1::instance);
+
+            THEN ("The decoded answer is returned")
+            {
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.headers["Content-Encoding"] == "gzip");
+                REQUIRE_FALSE(expected.empty());
+                REQUIRE(ret.answer == expected);
+            }
+        }
+
+        WHEN ("The answer is compressed with deflate")
+        {
+            config.content_encoding = "deflate";
+            server.set_config(config);
+            return_call ret = masto.get(API::v1::instance);
+
+            THEN ("The decoded answer is returned")
+            {
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.headers["Content-Encoding"] == "deflate");
+                REQUIRE_FALSE(expected.empty());
+                REQUIRE(ret.answer == expected);
+            }
+        }
+
+        WHEN ("A cached answer is revalidated by an empty gzip answer")
+        {
+            config.content_encoding = "gzip";
+            server.set_config(config);
+            cache_config cache;
+            cache.enabled = true;
+            masto.set_cache(cache);
+            masto.get(API::v1::instance);
+            return_call ret = masto.get(API::v1::instance);
+
+            THEN ("The cached answer is returned")
+            {
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.answer == expected);
+                REQUIRE(masto.get_cache_stats().revalidations == 1);
+            }
+        }
+    }
+}
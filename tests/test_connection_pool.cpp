@@ -0,0 +1,149 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+SCENARIO ("Connections are reused", "[mock]")
+{
+    GIVEN ("A mock server and an API object talking to it")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        API masto(server.instance(), "");
+        connection_pool_config pool;
+        // Failed requests must not be hidden by retries.
+        retry_config retry;
+        retry.max_attempts = 1;
+        masto.set_retry(retry);
+
+        WHEN ("5 requests are made one after another")
+        {
+            for (int i = 0; i < 5; ++i)
+            {
+                masto.get(API::v1::instance);
+            }
+
+            THEN ("They use one connection")
+            {
+                REQUIRE(server.requests() == 5);
+                REQUIRE(server.connections() == 1);
+            }
+        }
+
+        WHEN ("A connection is idle for longer than idle_timeout")
+        {
+            pool.idle_timeout = seconds(1);
+            masto.set_connection_pool(pool);
+            masto.get(API::v1::instance);
+            std::this_thread::sleep_for(milliseconds(1200));
+            masto.get(API::v1::instance);
+
+            THEN ("A new connection is opened")
+            {
+                REQUIRE(server.connections() == 2);
+            }
+        }
+
+        WHEN ("4 threads make requests with max_per_host = 1")
+        {
+            pool.max_per_host = 1;
+            masto.set_connection_pool(pool);
+            config.latency = milliseconds(100);
+            server.set_config(config);
+
+            const steady_clock::time_point start = steady_clock::now();
+            vector<std::thread> threads;
+            for (int i = 0; i < 4; ++i)
+            {
+                threads.emplace_back([&masto]
+                {
+                    masto.get(API::v1::instance);
+                });
+            }
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+            const auto elapsed = steady_clock::now() - start;
+
+            THEN ("They take turns on one connection")
+            {
+                REQUIRE(server.requests() == 4);
+                REQUIRE(server.connections() == 1);
+                REQUIRE(elapsed >= milliseconds(400));
+            }
+        }
+
+        WHEN ("The server closes a reused connection without answering")
+        {
+            config.drop_every = 2;
+            server.set_config(config);
+            const return_call first = masto.get(API::v1::instance);
+            const return_call second = masto.get(API::v1::instance);
+
+            THEN ("The request is sent again on a new connection")
+            {
+                REQUIRE(first.http_error_code == 200);
+                REQUIRE(second.http_error_code == 200);
+                REQUIRE(server.requests() == 3);
+                REQUIRE(server.connections() == 2);
+            }
+        }
+
+        WHEN ("The server closes a reused connection during an upload")
+        {
+            config.drop_every = 2;
+            server.set_config(config);
+            const return_call first = masto.get(API::v1::instance);
+            const return_call second = masto.put(
+                "/api/v1/media/1",
+                { { "file", { string(MASTODON_CPP_FIXTURES)
+                              + "/instance.json" } } });
+
+            THEN ("The request is not sent again")
+            {
+                REQUIRE(first.http_error_code == 200);
+                REQUIRE(second.error_code != 0);
+                REQUIRE(server.requests() == 2);
+                REQUIRE(server.connections() == 1);
+            }
+        }
+
+        WHEN ("The server closes a new connection without answering")
+        {
+            config.drop_every = 1;
+            server.set_config(config);
+            const return_call ret = masto.get(API::v1::instance);
+
+            THEN ("The request is not sent again")
+            {
+                REQUIRE(ret.error_code != 0);
+                REQUIRE(server.requests() == 1);
+            }
+        }
+    }
+}
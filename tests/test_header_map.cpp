@@ -0,0 +1,68 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("header_map is case insensitive")
+{
+    GIVEN ("A header_map with a Link header")
+    {
+        header_map headers;
+        headers["Link"] = "<https://example.com/next>; rel=\"next\"";
+
+        WHEN ("The header is looked up in lowercase")
+        {
+            const auto it = headers.find("link");
+
+            THEN ("It is found")
+            {
+                REQUIRE(it != headers.end());
+                REQUIRE(it->second == "<https://example.com/next>; "
+                        "rel=\"next\"");
+            }
+        }
+
+        WHEN ("The header is set again in uppercase")
+        {
+            headers["LINK"] = "replaced";
+
+            THEN ("The existing entry is replaced")
+            {
+                REQUIRE(headers.size() == 1);
+                REQUIRE(headers["Link"] == "replaced");
+            }
+        }
+    }
+
+    GIVEN ("A return_call with headers")
+    {
+        return_call ret(error::OK, "", 200, "{}");
+        ret.headers["X-RateLimit-Remaining"] = "299";
+
+        WHEN ("It is copied")
+        {
+            const return_call copy = ret;
+
+            THEN ("The headers are copied too")
+            {
+                REQUIRE(copy.headers.at("x-ratelimit-remaining") == "299");
+            }
+        }
+    }
+}
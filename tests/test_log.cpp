@@ -0,0 +1,147 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "debug.hpp"
+
+using namespace Mastodon;
+
+namespace
+{
+    // Logs a message while it is written into another one.
+    typedef struct nested
+    {
+    } nested;
+
+    std::ostream &operator<<(std::ostream &out, const nested &)
+    {
+        ttlog(INFO) << "Inner " << 2;
+        return out << "nested";
+    }
+}
+
+SCENARIO ("Log messages are filtered and passed to the sink", "[log]")
+{
+    GIVEN ("A sink that collects messages")
+    {
+        const log_level old_level = get_log_level();
+        std::mutex mutex;
+        std::vector<log_record> records;
+        set_log_sink([&](const log_record &record)
+                     {
+                         std::lock_guard<std::mutex> lock(mutex);
+                         records.push_back(record);
+                     });
+
+        WHEN ("The level is INFO")
+        {
+            set_log_level(log_level::INFO);
+            bool evaluated = false;
+            auto evaluate = [&evaluated]
+            {
+                evaluated = true;
+                return "";
+            };
+
+            ttlog(WARNING) << "Warning " << 1 << '\n';
+            ttdebug << "Trace " << evaluate() << '\n';
+
+            THEN ("Only the warning arrives")
+                AND_THEN ("The trace message is not evaluated")
+            {
+                REQUIRE(records.size() == 1);
+                REQUIRE(records[0].level == log_level::WARNING);
+                REQUIRE(records[0].message == "Warning 1");
+                REQUIRE(records[0].line > 0);
+                REQUIRE_FALSE(evaluated);
+            }
+        }
+
+        WHEN ("Several threads log at once")
+        {
+            set_log_level(log_level::TRACE);
+            std::vector<std::thread> threads;
+            for (int thread = 0; thread < 4; ++thread)
+            {
+                threads.emplace_back([thread]
+                {
+                    for (int i = 0; i < 1000; ++i)
+                    {
+                        ttdebug << "Thread " << thread << " message " << i
+                                << std::endl;
+                    }
+                });
+            }
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+
+            THEN ("Every message arrives in one piece")
+            {
+                REQUIRE(records.size() == 4000);
+                for (const log_record &record : records)
+                {
+                    REQUIRE(record.message.compare(0, 7, "Thread ") == 0);
+                    REQUIRE(record.message.find('\n') == string::npos);
+                }
+            }
+        }
+
+        WHEN ("A message is logged while another one is put together")
+        {
+            set_log_level(log_level::INFO);
+            ttlog(WARNING) << "Outer " << nested() << " end";
+
+            THEN ("Both messages arrive in one piece")
+            {
+                REQUIRE(records.size() == 2);
+                REQUIRE(records[0].message == "Inner 2");
+                REQUIRE(records[1].message == "Outer nested end");
+            }
+        }
+
+        WHEN ("The sink logs a message")
+        {
+            set_log_level(log_level::INFO);
+            set_log_sink([&](const log_record &record)
+                         {
+                             if (record.level == log_level::WARNING)
+                             {
+                                 ttlog(INFO) << "Got " << record.message;
+                             }
+                             std::lock_guard<std::mutex> lock(mutex);
+                             records.push_back(record);
+                         });
+            ttlog(WARNING) << "Warning " << 1;
+
+            THEN ("Both messages arrive in one piece")
+            {
+                REQUIRE(records.size() == 2);
+                REQUIRE(records[0].message == "Got Warning 1");
+                REQUIRE(records[1].message == "Warning 1");
+            }
+        }
+
+        set_log_sink({});
+        set_log_level(old_level);
+    }
+}
@@ -0,0 +1,129 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "easy/managed_stream.hpp"
+#include "easy/entities/status.hpp"
+#include "easy/entities/notification.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+SCENARIO ("Managed streams reconnect and backfill", "[mock][stream]")
+{
+    GIVEN ("A mock server that closes streams after 3 events")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        Easy::reconnect_config config;
+        config.base_delay = milliseconds(10);
+        std::mutex mutex;
+        std::condition_variable cv;
+        vector<string> events;
+
+        auto callback = [&](const sse_event &event)
+        {
+            string id = event.get_data();
+            if (event.is("update"))
+            {
+                id = Easy::Status(event.get_data()).id();
+            }
+            else if (event.is("notification"))
+            {
+                id = Easy::Notification(event.get_data()).id();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(event.get_name() + ' ' + id);
+            cv.notify_all();
+        };
+
+        WHEN ("The user stream is reconnected twice")
+        {
+            Easy::managed_stream stream(masto, API::v1::streaming_user, {},
+                                        callback, config);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(10),
+                            [&]
+                            {
+                                return (std::count(events.begin(),
+                                                   events.end(),
+                                                   "delete 1") >= 3);
+                            });
+            }
+            stream.cancel();
+
+            THEN ("The missed statuses and notifications are passed on "
+                  "after the first connection, oldest first")
+                AND_THEN ("No status or notification is passed on twice")
+            {
+                REQUIRE(stream.reconnects() >= 2);
+                REQUIRE(vector<string>(events.begin(), events.begin() + 9)
+                        == vector<string>({ "update 4", "notification 3",
+                                            "delete 1",
+                                            "update 1", "update 2",
+                                            "update 3",
+                                            "notification 1",
+                                            "notification 2",
+                                            "delete 1" }));
+                for (const string &event : events)
+                {
+                    if (event != "delete 1")
+                    {
+                        REQUIRE(std::count(events.begin(), events.end(),
+                                           event) == 1);
+                    }
+                }
+            }
+        }
+
+        WHEN ("The server rejects the access token")
+        {
+            mock_config mock;
+            mock.error_every = 1;
+            mock.error_status = 401;
+            server.set_config(mock);
+            Easy::managed_stream stream(masto, API::v1::streaming_public, {},
+                                        callback, config);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(10),
+                            [&] { return !events.empty(); });
+            }
+
+            THEN ("The error is passed on and the stream ends")
+            {
+                REQUIRE(events.size() == 1);
+                REQUIRE(events.front().find("ERROR") == 0);
+                REQUIRE(events.front().find("\"http_error\":401")
+                        != string::npos);
+                REQUIRE(stream.reconnects() == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <chrono>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "metrics.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("The histogram finds percentiles", "[metrics]")
+{
+    GIVEN ("A histogram with the values 1 to 10000")
+    {
+        histogram values;
+        for (std::uint64_t value = 1; value <= 10000; ++value)
+        {
+            values.add(value);
+        }
+
+        THEN ("The percentiles are at most 3 % off")
+        {
+            REQUIRE(values.count() == 10000);
+            REQUIRE(values.sum() == 50005000);
+            REQUIRE(values.percentile(0.5) == Approx(5000).epsilon(0.03));
+            REQUIRE(values.percentile(0.9) == Approx(9000).epsilon(0.03));
+            REQUIRE(values.percentile(0.99) == Approx(9900).epsilon(0.03));
+            REQUIRE(values.percentile(0.999) <= 10000);
+        }
+    }
+
+    GIVEN ("A histogram with small values")
+    {
+        histogram values;
+        values.add(3);
+        values.add(7);
+
+        THEN ("They are exact")
+        {
+            REQUIRE(values.percentile(0.5) == 3);
+            REQUIRE(values.percentile(1) == 7);
+        }
+    }
+}
+
+SCENARIO ("The metrics registry renders Prometheus text", "[metrics]")
+{
+    GIVEN ("A registry with two requests")
+    {
+        metrics_registry registry;
+        request_record record;
+        record.api_version = 1;
+        record.call_v1 = API::v1::instance;
+        record.start = request_record::clock::now();
+        record.end = record.start + std::chrono::milliseconds(20);
+        record.bytes_sent = 100;
+        record.bytes_received = 1000;
+        registry.record(record);
+
+        record.error_code = static_cast<std::uint8_t>(
+            error::CONNECTION_TIMEOUT);
+        registry.record(record);
+
+        WHEN ("The metrics are rendered")
+        {
+            const string text = registry.render();
+
+            THEN ("Requests, errors, bytes and durations are there")
+            {
+                REQUIRE(text.find("mastodon_cpp_requests_total"
+                                  "{endpoint=\"v1::instance\"} 2\n")
+                        != string::npos);
+                REQUIRE(text.find("mastodon_cpp_errors_total"
+                                  "{endpoint=\"v1::instance\","
+                                  "error=\"CONNECTION_TIMEOUT\"} 1\n")
+                        != string::npos);
+                REQUIRE(text.find("mastodon_cpp_sent_bytes_total"
+                                  "{endpoint=\"v1::instance\"} 200\n")
+                        != string::npos);
+                REQUIRE(text.find("mastodon_cpp_request_duration_seconds"
+                                  "_count{endpoint=\"v1::instance\"} 2\n")
+                        != string::npos);
+                REQUIRE(text.find("quantile=\"0.999\"") != string::npos);
+            }
+        }
+    }
+
+    GIVEN ("A stream meter")
+    {
+        metrics_registry registry;
+        stream_meter meter(registry);
+        const string stream =
+            ":thump\n"
+            "event: update\n"
+            "data: {\"id\":\"1\",\"created_at\":\"2019-01-01T00:00:00.000Z\"}"
+            "\n\n"
+            "event: delete\n"
+            "data: 1\n\n";
+
+        WHEN ("The stream arrives in pieces")
+        {
+            for (std::size_t pos = 0; pos < stream.size(); pos += 7)
+            {
+                const string piece = stream.substr(pos, 7);
+                meter.feed(piece.data(), piece.size());
+            }
+            const string text = registry.render();
+
+            THEN ("Both events are counted")
+                AND_THEN ("The lag of the update is measured")
+            {
+                REQUIRE(text.find("mastodon_cpp_stream_events_total 2\n")
+                        != string::npos);
+                REQUIRE(text.find("mastodon_cpp_stream_lag_seconds_count 1\n")
+                        != string::npos);
+            }
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <string>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "easy/entities/instance.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+SCENARIO ("The mock server answers API calls", "[mock]")
+{
+    GIVEN ("A mock server and an API object talking to it")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        API masto(server.instance(), "");
+        retry_config retry;
+        retry.max_attempts = 1;
+        masto.set_retry(retry);
+        return_call ret;
+
+        WHEN ("GET /api/v1/instance is called")
+        {
+            ret = masto.get(API::v1::instance);
+
+            THEN ("The answer is the fixture")
+                AND_THEN ("Rate limit headers are sent")
+            {
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.http_error_code == 200);
+                REQUIRE(Easy::Instance(ret.answer).valid());
+                REQUIRE(ret.headers["X-RateLimit-Limit"] == "300");
+                REQUIRE(ret.headers["X-RateLimit-Remaining"] == "299");
+                REQUIRE(server.requests() == 1);
+            }
+        }
+
+        WHEN ("An account is requested")
+        {
+            ret = masto.get(API::v1::accounts_id, {{ "id", { "1234" }}});
+
+            THEN ("The ID is replaced")
+            {
+                REQUIRE(ret.http_error_code == 200);
+                REQUIRE(ret.answer.find("\"id\":\"1234\"") != string::npos);
+            }
+        }
+
+        WHEN ("Every second request fails")
+        {
+            config.error_every = 2;
+            config.error_status = 503;
+            server.set_config(config);
+            const return_call first = masto.get(API::v1::instance);
+            ret = masto.get(API::v1::instance);
+
+            THEN ("The second request returns the error")
+            {
+                REQUIRE(first.http_error_code == 200);
+                REQUIRE(ret.http_error_code == 503);
+            }
+        }
+
+        WHEN ("The rate limit is exhausted")
+        {
+            config.rate_limit = 1;
+            config.enforce_rate_limit = true;
+            server.set_config(config);
+            masto.get(API::v1::instance);
+            ret = masto.get(API::v1::instance);
+
+            THEN ("The server answers with 429")
+            {
+                REQUIRE(ret.http_error_code == 429);
+                REQUIRE(ret.headers["X-RateLimit-Remaining"] == "0");
+            }
+        }
+
+        WHEN ("The server has a latency of 200 ms")
+        {
+            config.latency = milliseconds(200);
+            server.set_config(config);
+            const auto start = steady_clock::now();
+            ret = masto.get(API::v1::instance);
+
+            THEN ("The call takes at least 200 ms")
+            {
+                REQUIRE(ret.http_error_code == 200);
+                REQUIRE(steady_clock::now() - start >= milliseconds(200));
+            }
+        }
+
+        WHEN ("An answer is requested again with the cache enabled")
+        {
+            cache_config cache;
+            cache.enabled = true;
+            masto.set_cache(cache);
+            masto.get(API::v1::instance);
+            ret = masto.get(API::v1::instance);
+
+            THEN ("The cached answer is revalidated with the ETag")
+            {
+                REQUIRE(ret.http_error_code == 200);
+                REQUIRE(Easy::Instance(ret.answer).valid());
+                REQUIRE(masto.get_cache_stats().revalidations == 1);
+            }
+        }
+
+        WHEN ("A path without fixture is requested")
+        {
+            ret = masto.get("/api/v1/nonexistent");
+
+            THEN ("The server answers with 404")
+            {
+                REQUIRE(ret.http_error_code == 404);
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("The observer receives a record of every request", "[mock]")
+{
+    GIVEN ("A mock server and an API object with an observer")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        retry_config retry;
+        retry.max_attempts = 2;
+        retry.base_delay = std::chrono::milliseconds(1);
+        masto.set_retry(retry);
+
+        std::vector<request_record> records;
+        masto.set_observer([&records](const request_record &record)
+                           {
+                               records.push_back(record);
+                           });
+
+        WHEN ("GET /api/v1/instance is called twice")
+        {
+            masto.get(API::v1::instance);
+            masto.get(API::v1::instance);
+
+            THEN ("Both requests are recorded")
+                AND_THEN ("The phases are in order")
+                AND_THEN ("The second request reuses the connection")
+            {
+                REQUIRE(records.size() == 2);
+
+                const request_record &first = records[0];
+                REQUIRE(first.path == "/api/v1/instance");
+                REQUIRE(first.api_version == 1);
+                REQUIRE(first.call_v1 == API::v1::instance);
+                REQUIRE(first.http_status == 200);
+                REQUIRE(first.error_code == 0);
+                REQUIRE(first.retries == 0);
+                REQUIRE_FALSE(first.reused);
+                REQUIRE(first.bytes_sent > 0);
+                REQUIRE(first.bytes_received > 0);
+
+                REQUIRE(first.start <= first.queued);
+                REQUIRE(first.queued <= first.dns);
+                REQUIRE(first.dns <= first.connect);
+                REQUIRE(first.connect <= first.tls);
+                REQUIRE(first.tls <= first.sent);
+                REQUIRE(first.sent <= first.first_byte);
+                REQUIRE(first.first_byte <= first.end);
+
+                REQUIRE(records[1].reused);
+                REQUIRE(records[1].dns == records[1].queued);
+            }
+        }
+
+        WHEN ("A request is called with a string")
+        {
+            masto.get("/api/v1/instance");
+
+            THEN ("The record has no API version")
+            {
+                REQUIRE(records.size() == 1);
+                REQUIRE(records[0].api_version == 0);
+            }
+        }
+
+        WHEN ("A request is retried")
+        {
+            mock_config config;
+            config.error_every = 1;
+            config.error_status = 503;
+            server.set_config(config);
+            masto.get(API::v1::instance);
+
+            THEN ("Every attempt is recorded")
+            {
+                REQUIRE(records.size() == 2);
+                REQUIRE(records[0].http_status == 503);
+                REQUIRE(records[0].retries == 0);
+                REQUIRE(records[1].retries == 1);
+            }
+        }
+
+        WHEN ("The observer is removed")
+        {
+            masto.set_observer({});
+            masto.get(API::v1::instance);
+
+            THEN ("Nothing is recorded")
+            {
+                REQUIRE(records.empty());
+            }
+        }
+    }
+}
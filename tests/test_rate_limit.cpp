@@ -0,0 +1,132 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "environment_variables.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("The rate limit scheduler reads the budget",
+          "[api][mastodon][glitch-soc]")
+{
+    GIVEN ("instance = " + instance)
+    {
+        Mastodon::API masto(instance, "");
+        rate_limit_status before;
+        rate_limit_status after;
+        return_call ret;
+        bool exception = false;
+
+        WHEN ("GET /api/v1/instance is called with the scheduler enabled")
+        {
+            try
+            {
+                rate_limit_config config;
+                config.enabled = true;
+                masto.set_rate_limit(config);
+
+                before = masto.get_rate_limit();
+                ret = masto.get(API::v1::instance);
+                after = masto.get_rate_limit();
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("The budget is unknown before the first answer")
+                AND_THEN ("The budget is known after the first answer")
+            {
+                REQUIRE_FALSE(exception);
+                REQUIRE(ret.error_code == 0);
+
+                REQUIRE(before.limit == -1);
+                REQUIRE(before.remaining == -1);
+
+                REQUIRE(after.limit > 0);
+                REQUIRE(after.remaining >= 0);
+                REQUIRE(after.remaining <= after.limit);
+                REQUIRE(after.in_flight == 0);
+                REQUIRE(after.queued == 0);
+            }
+        }
+    }
+}
+
+SCENARIO ("The rate limit scheduler keeps requests within the budget",
+          "[mock]")
+{
+    GIVEN ("A mock server that allows 5 requests per second")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.rate_limit = 5;
+        config.rate_limit_window = std::chrono::seconds(1);
+        config.enforce_rate_limit = true;
+        server.set_config(config);
+        API masto(server.instance(), "");
+        rate_limit_config limit;
+        limit.enabled = true;
+        masto.set_rate_limit(limit);
+        // 429 must not be hidden by retries.
+        retry_config retry;
+        retry.max_attempts = 1;
+        masto.set_retry(retry);
+
+        WHEN ("12 requests are made by 4 threads")
+        {
+            const std::vector<API::batch_call> calls(12,
+                                                     { API::v1::instance, {} });
+            std::atomic<bool> done(false);
+            std::size_t queued = 0;
+            std::thread watcher([&]
+            {
+                while (!done)
+                {
+                    queued = std::max(queued, masto.get_rate_limit().queued);
+                    std::this_thread::sleep_for(
+                        std::chrono::milliseconds(1));
+                }
+            });
+            const std::vector<return_call> results = masto.get_batch(calls, 4);
+            done = true;
+            watcher.join();
+
+            THEN ("No request is rejected with 429")
+                AND_THEN ("Requests were held back")
+            {
+                REQUIRE(results.size() == 12);
+                for (const return_call &ret : results)
+                {
+                    REQUIRE(ret.http_error_code == 200);
+                }
+                REQUIRE(server.requests() == 12);
+                REQUIRE(queued > 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <catch.hpp>
+#include "response_cache.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Answers are cached and revalidated")
+{
+    GIVEN ("An enabled response_cache")
+    {
+        response_cache cache;
+        cache_config config;
+        config.enabled = true;
+        cache.set_config(config);
+
+        return_call ret(error::OK, "", 200, "answer");
+        return_call cached;
+        header_map validators;
+
+        WHEN ("A fresh answer is stored")
+        {
+            ret.headers["Cache-Control"] = "public, max-age=60";
+            cache.store("GET /a", ret);
+
+            THEN ("It is served from the cache")
+            {
+                REQUIRE(cache.get("GET /a", cached, validators));
+                REQUIRE(cached.answer == "answer");
+                REQUIRE(validators.empty());
+                REQUIRE(cache.get_stats().hits == 1);
+                REQUIRE(cache.get_stats().misses == 1);
+                REQUIRE(cache.get_stats().entries == 1);
+            }
+        }
+
+        WHEN ("Answers with a huge max-age are stored")
+        {
+            ret.headers["Cache-Control"] = "max-age=9223372036854775807";
+            cache.store("GET /a", ret);
+            ret.headers["Cache-Control"] = "max-age=99999999999999999999";
+            cache.store("GET /b", ret);
+
+            THEN ("They are served from the cache")
+            {
+                REQUIRE(cache.get("GET /a", cached, validators));
+                REQUIRE(cache.get("GET /b", cached, validators));
+            }
+        }
+
+        WHEN ("A stale answer with an ETag is stored")
+        {
+            ret.headers["Cache-Control"] = "no-cache";
+            ret.headers["ETag"] = "W/\"1234\"";
+            cache.store("GET /a", ret);
+
+            THEN ("The validator is returned")
+                AND_THEN ("A 304 answer returns the cached body")
+            {
+                REQUIRE_FALSE(cache.get("GET /a", cached, validators));
+                REQUIRE(validators["If-None-Match"] == "W/\"1234\"");
+
+                header_map headers;
+                headers["ETag"] = "W/\"1234\"";
+                REQUIRE(cache.revalidated("GET /a", headers, cached));
+                REQUIRE(cached.answer == "answer");
+                REQUIRE(cache.get_stats().revalidations == 1);
+            }
+        }
+
+        WHEN ("An answer with Cache-Control: no-store is stored")
+        {
+            ret.headers["Cache-Control"] = "no-store";
+            ret.headers["ETag"] = "\"1234\"";
+            cache.store("GET /a", ret);
+
+            THEN ("It is not cached")
+            {
+                REQUIRE_FALSE(cache.get("GET /a", cached, validators));
+                REQUIRE(validators.empty());
+                REQUIRE(cache.get_stats().entries == 0);
+            }
+        }
+
+        WHEN ("More answers are stored than allowed")
+        {
+            config.max_entries = 2;
+            cache.set_config(config);
+            ret.headers["Cache-Control"] = "max-age=60";
+            cache.store("GET /a", ret);
+            cache.store("GET /b", ret);
+            cache.get("GET /a", cached, validators);
+            cache.store("GET /c", ret);
+
+            THEN ("The least recently used answer is removed")
+            {
+                REQUIRE(cache.get_stats().entries == 2);
+                REQUIRE(cache.get("GET /a", cached, validators));
+                REQUIRE_FALSE(cache.get("GET /b", cached, validators));
+                REQUIRE(cache.get("GET /c", cached, validators));
+            }
+        }
+
+        WHEN ("The cache is disabled")
+        {
+            ret.headers["Cache-Control"] = "max-age=60";
+            cache.store("GET /a", ret);
+            config.enabled = false;
+            cache.set_config(config);
+
+            THEN ("It is empty")
+            {
+                REQUIRE(cache.get_stats().entries == 0);
+                REQUIRE(cache.get_stats().bytes == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,206 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <set>
+#include <chrono>
+#include <algorithm>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "rate_limiter.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+SCENARIO ("Reset times are parsed without overflowing")
+{
+    GIVEN ("A reset time far in the future")
+    {
+        const string value = "9223372036854775807";
+
+        WHEN ("It is parsed")
+        {
+            rate_limiter::clock::time_point time;
+            const bool parsed = rate_limiter::parse_time(value, time);
+
+            THEN ("It is cut to a time that can be calculated with")
+            {
+                REQUIRE(parsed);
+                REQUIRE(time > rate_limiter::clock::now());
+                REQUIRE(time - rate_limiter::clock::now()
+                        < std::chrono::hours(24 * 366 * 100));
+            }
+        }
+    }
+}
+
+SCENARIO ("The delay between attempts follows the retry settings")
+{
+    GIVEN ("A base delay of 100 ms and a maximum delay of 1 s")
+    {
+        retry_config config;
+        config.base_delay = milliseconds(100);
+        config.max_delay = seconds(1);
+        return_call ret(error::CONNECTION_REFUSED, "", 503, "");
+
+        WHEN ("The delays of the first 6 attempts are drawn")
+        {
+            THEN ("They stay below the doubling ceiling")
+                AND_THEN ("They are spread over the whole range")
+            {
+                for (std::uint8_t attempt = 1; attempt <= 6; ++attempt)
+                {
+                    const milliseconds ceiling = std::min<milliseconds>(
+                        config.base_delay * (1 << (attempt - 1)),
+                        config.max_delay);
+                    std::set<milliseconds::rep> seen;
+                    milliseconds highest(0);
+                    for (int i = 0; i < 200; ++i)
+                    {
+                        const milliseconds delay =
+                            API::http::retry_delay(config, attempt, ret);
+                        REQUIRE(delay.count() >= 0);
+                        REQUIRE(delay <= ceiling);
+                        seen.insert(delay.count());
+                        highest = std::max(highest, delay);
+                    }
+                    REQUIRE(seen.size() > 1);
+                    REQUIRE(highest > ceiling / 2);
+                }
+            }
+        }
+
+        WHEN ("The server sends Retry-After: 2")
+        {
+            ret.headers["Retry-After"] = "2";
+            config.max_delay = seconds(5);
+            const milliseconds delay =
+                API::http::retry_delay(config, 1, ret);
+
+            THEN ("We wait at least 2 s")
+            {
+                REQUIRE(delay >= seconds(2));
+                REQUIRE(delay <= seconds(5));
+            }
+        }
+
+        WHEN ("The server sends Retry-After as an HTTP date")
+        {
+            ret.headers["Date"] = "Wed, 21 Oct 2015 07:28:00 GMT";
+            ret.headers["Retry-After"] = "Wed, 21 Oct 2015 07:28:03 GMT";
+            config.max_delay = seconds(5);
+            const milliseconds delay =
+                API::http::retry_delay(config, 1, ret);
+
+            THEN ("We wait at least until then")
+            {
+                REQUIRE(delay >= seconds(3));
+                REQUIRE(delay <= seconds(5));
+            }
+        }
+
+        WHEN ("The server asks us to wait longer than the maximum delay")
+        {
+            ret.headers["Retry-After"] = "60";
+            const milliseconds delay =
+                API::http::retry_delay(config, 1, ret);
+
+            THEN ("A negative delay is returned")
+            {
+                REQUIRE(delay.count() < 0);
+            }
+        }
+
+        WHEN ("Retry-After is too large for milliseconds")
+        {
+            THEN ("A negative delay is returned")
+            {
+                for (const string value : { "9223372036854775807",
+                                            "99999999999999999999" })
+                {
+                    ret.headers["Retry-After"] = value;
+                    REQUIRE(API::http::retry_delay(config, 1, ret).count()
+                            < 0);
+                }
+            }
+        }
+
+        WHEN ("Retry-After is not ASCII")
+        {
+            ret.headers["Retry-After"] = "\xe9\xff";
+            const milliseconds delay =
+                API::http::retry_delay(config, 1, ret);
+
+            THEN ("It is ignored")
+            {
+                REQUIRE(delay.count() >= 0);
+                REQUIRE(delay <= config.base_delay);
+            }
+        }
+    }
+}
+
+SCENARIO ("Failed requests are retried", "[mock]")
+{
+    GIVEN ("A mock server and an API object that tries twice")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        API masto(server.instance(), "");
+        retry_config retry;
+        retry.max_attempts = 2;
+        retry.base_delay = milliseconds(1);
+        retry.max_delay = seconds(5);
+        masto.set_retry(retry);
+
+        WHEN ("Every second request fails with 503")
+        {
+            config.error_every = 2;
+            config.error_status = 503;
+            server.set_config(config);
+            std::uint16_t worst = 200;
+            for (int i = 0; i < 4; ++i)
+            {
+                const return_call ret = masto.get(API::v1::instance);
+                worst = std::max(worst, ret.http_error_code);
+            }
+
+            THEN ("Every call succeeds with a second attempt")
+            {
+                REQUIRE(worst == 200);
+                REQUIRE(server.requests() == 7);
+            }
+        }
+
+        WHEN ("The rate limit is exhausted")
+        {
+            config.rate_limit = 1;
+            config.rate_limit_window = seconds(1);
+            config.enforce_rate_limit = true;
+            server.set_config(config);
+            masto.get(API::v1::instance);
+            const return_call ret = masto.get(API::v1::instance);
+
+            THEN ("The second call waits for Retry-After and succeeds")
+            {
+                REQUIRE(ret.http_error_code == 200);
+                REQUIRE(server.requests() == 3);
+            }
+        }
+    }
+}
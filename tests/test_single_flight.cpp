@@ -0,0 +1,128 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <catch.hpp>
+#include "single_flight.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Concurrent identical requests are coalesced")
+{
+    GIVEN ("An enabled single_flight")
+    {
+        single_flight flight;
+        flight.set_enabled(true);
+        std::atomic<int> calls(0);
+        std::promise<void> started;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool released = false;
+
+        // Answers when released, like a server that takes its time.
+        auto call = [&]
+        {
+            if (++calls == 1)
+            {
+                started.set_value();
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, std::chrono::seconds(5),
+                        [&] { return released; });
+            return return_call(error::OK, "", 200, "answer");
+        };
+        auto release = [&]
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                released = true;
+            }
+            cv.notify_all();
+        };
+
+        WHEN ("4 threads make the same request at the same time")
+        {
+            std::vector<std::future<return_call>> results;
+            results.push_back(
+                std::async(std::launch::async,
+                           [&] { return flight.run("/a", call); }));
+            started.get_future().wait();
+
+            for (int i = 0; i < 3; ++i)
+            {
+                results.push_back(
+                    std::async(std::launch::async,
+                               [&] { return flight.run("/a", call); }));
+            }
+
+            // The answer is held back until every caller waits for it.
+            const auto deadline =
+                std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (flight.waiting() < 3
+                   && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            const std::size_t waiting = flight.waiting();
+            release();
+
+            THEN ("The request is made once")
+                AND_THEN ("Every caller gets the answer")
+            {
+                REQUIRE(waiting == 3);
+                for (auto &result : results)
+                {
+                    REQUIRE(result.get().answer == "answer");
+                }
+                REQUIRE(calls == 1);
+                REQUIRE(flight.in_flight() == 0);
+                REQUIRE(flight.waiting() == 0);
+            }
+        }
+
+        WHEN ("Different requests are made at the same time")
+        {
+            auto a = std::async(std::launch::async,
+                                [&] { return flight.run("/a", call); });
+            started.get_future().wait();
+            auto b = std::async(std::launch::async,
+                                [&] { return flight.run("/b", call); });
+
+            THEN ("Both requests are made")
+            {
+                // Only returns if /b does not wait for /a.
+                const auto deadline =
+                    std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (calls < 2
+                       && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                REQUIRE(calls == 2);
+                REQUIRE(flight.waiting() == 0);
+                release();
+                a.get();
+                b.get();
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include <string>
+#include <sstream>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "easy/easy.hpp"
+#include "easy/entities/instance.hpp"
+#include "environment_variables.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Answers can be written to a sink",
+          "[api][mastodon][pleroma][glitch-soc]")
+{
+    GIVEN ("instance = " + instance)
+    {
+        Mastodon::API masto(instance, "");
+        return_call ret;
+        bool exception = false;
+
+        WHEN ("GET /api/v1/instance is written to a std::ostream")
+        {
+            std::ostringstream out;
+
+            try
+            {
+                ret = masto.get("/api/v1/instance", out);
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+                AND_THEN ("The answer is in the stream, not in return_call")
+            {
+                REQUIRE_FALSE(exception);
+
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(ret.http_error_code == 200);
+
+                REQUIRE(ret.answer.empty());
+                REQUIRE(Easy::Instance(out.str()).valid());
+            }
+        }
+
+        WHEN ("GET /api/v1/instance is passed to a callback")
+        {
+            std::size_t calls = 0;
+            string body;
+
+            try
+            {
+                ret = masto.get("/api/v1/instance",
+                                [&calls, &body](const char *data,
+                                                const std::size_t size)
+                                {
+                                    ++calls;
+                                    body.append(data, size);
+                                });
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+                AND_THEN ("The callback received the answer")
+            {
+                REQUIRE_FALSE(exception);
+
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(calls > 0);
+                REQUIRE(Easy::Instance(body).valid());
+            }
+        }
+    }
+}
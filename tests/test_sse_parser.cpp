@@ -0,0 +1,151 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <catch.hpp>
+#include "sse_parser.hpp"
+#include "easy/easy.hpp"
+
+using namespace Mastodon;
+using event_pair = std::pair<string, string>;
+
+SCENARIO ("The SSE parser splits streams into events", "[sse]")
+{
+    const string stream =
+        ":thump\n"
+        "event: update\n"
+        "data: {\"id\":\"1\"}\n"
+        "\n"
+        "event: delete\r\n"
+        "data: 1\r\n"
+        "\r\n"
+        "data: first\n"
+        "data: second\n"
+        "id: 7\n"
+        "\n"
+        "event: announcement\n"
+        "data:no space\n"
+        "\n";
+    const std::vector<event_pair> expected =
+        {
+            { "update", "{\"id\":\"1\"}" },
+            { "delete", "1" },
+            { "message", "first\nsecond" },
+            { "announcement", "no space" }
+        };
+
+    GIVEN ("A parser that collects events")
+    {
+        std::vector<event_pair> events;
+        sse_parser parser([&events](const sse_event &event)
+                          {
+                              events.emplace_back(event.get_name(),
+                                                  event.get_data());
+                          });
+
+        WHEN ("The stream is passed in one piece")
+        {
+            parser.feed(stream);
+
+            THEN ("All events are found")
+            {
+                REQUIRE(events == expected);
+            }
+        }
+
+        WHEN ("The stream is split at every position")
+        {
+            for (std::size_t split = 0; split <= stream.size(); ++split)
+            {
+                parser.feed(stream.substr(0, split));
+                parser.feed(stream.substr(split));
+            }
+
+            THEN ("All events are found every time")
+            {
+                REQUIRE(events.size() == expected.size() * (stream.size() + 1));
+                for (std::size_t i = 0; i < events.size(); ++i)
+                {
+                    REQUIRE(events[i] == expected[i % expected.size()]);
+                }
+            }
+        }
+
+        WHEN ("The stream is passed byte by byte")
+        {
+            for (const char c : stream)
+            {
+                parser.feed(&c, 1);
+            }
+
+            THEN ("All events are found")
+            {
+                REQUIRE(events == expected);
+            }
+        }
+
+        WHEN ("The empty line after the last event is missing")
+        {
+            parser.feed("event: update\ndata: x\n");
+
+            THEN ("The event is passed on by finish()")
+            {
+                REQUIRE(events.empty());
+                parser.finish();
+                REQUIRE(events.size() == 1);
+                REQUIRE(events[0].second == "x");
+            }
+        }
+    }
+
+    GIVEN ("A parser that remembers where the data is")
+    {
+        const char *data = nullptr;
+        sse_parser parser([&data](const sse_event &event)
+                          {
+                              data = event.data;
+                          });
+
+        WHEN ("An event is completely inside one piece")
+        {
+            parser.feed(stream);
+
+            THEN ("The data is not copied")
+            {
+                REQUIRE(data >= stream.data());
+                REQUIRE(data < stream.data() + stream.size());
+            }
+        }
+    }
+}
+
+SCENARIO ("Easy::parse_stream() uses the SSE parser", "[sse][easy]")
+{
+    const string stream =
+        "event: update\ndata: {}\n\n"
+        "event: status.update\ndata: {}\n\n"
+        "event: notification\ndata: {\"id\":\"2\"}\n";
+
+    const auto events = Easy::parse_stream(stream);
+
+    REQUIRE(events.size() == 3);
+    REQUIRE(events[0].type == Easy::event_type::Update);
+    REQUIRE(events[1].type == Easy::event_type::Undefined);
+    REQUIRE(events[2].type == Easy::event_type::Notification);
+    REQUIRE(events[2].data == "{\"id\":\"2\"}");
+}
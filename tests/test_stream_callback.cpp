@@ -0,0 +1,336 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <catch.hpp>
+#include <Poco/Exception.h>
+#include <Poco/Timespan.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/SocketAddress.h>
+#include "mastodon-cpp.hpp"
+#include "easy/easy.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+SCENARIO ("Streams pass events to a callback", "[mock][stream]")
+{
+    GIVEN ("A mock server that sends 3 events")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        std::unique_ptr<API::http> ptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        vector<string> names;
+        vector<Easy::event_type> types;
+        auto callback = [&](const sse_event &event)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            names.push_back(event.get_name());
+            types.push_back(Easy::get_event_type(event));
+            cv.notify_all();
+        };
+        auto wait_for = [&](const std::size_t count)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, seconds(5),
+                        [&] { return names.size() >= count; });
+        };
+
+        WHEN ("The public timeline is streamed")
+        {
+            masto.get_stream(API::v1::streaming_public, ptr, callback);
+            // The server closes the connection after the last event.
+            wait_for(4);
+            ptr->cancel_stream();
+
+            THEN ("Every event is passed to the callback in order")
+                AND_THEN ("The end of the stream is reported")
+            {
+                REQUIRE(names == vector<string>
+                        ({ "update", "notification", "delete", "ERROR" }));
+                REQUIRE(types == vector<Easy::event_type>
+                        ({ Easy::event_type::Update,
+                           Easy::event_type::Notification,
+                           Easy::event_type::Delete,
+                           Easy::event_type::Error }));
+            }
+        }
+
+        WHEN ("The events are run by an executor later")
+        {
+            vector<std::function<void()>> tasks;
+            masto.get_stream(API::v1::streaming_public, ptr, callback,
+                             [&](const std::function<void()> &task)
+                             {
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 tasks.push_back(task);
+                                 cv.notify_all();
+                             });
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(5),
+                            [&] { return tasks.size() >= 4; });
+            }
+            ptr->cancel_stream();
+            for (const auto &task : tasks)
+            {
+                task();
+            }
+
+            THEN ("The executor gets copies of the events")
+            {
+                REQUIRE(names == vector<string>
+                        ({ "update", "notification", "delete", "ERROR" }));
+            }
+        }
+
+        WHEN ("A call that is not a stream is requested")
+        {
+            string data;
+            masto.get_stream(API::v1::instance, ptr,
+                             [&](const sse_event &event)
+                             {
+                                 names.push_back(event.get_name());
+                                 data = event.get_data();
+                             });
+
+            THEN ("An ERROR event is passed to the callback")
+            {
+                REQUIRE(names == vector<string>({ "ERROR" }));
+                REQUIRE(data == "{\"error_code\":1}");
+            }
+        }
+    }
+}
+
+SCENARIO ("Events are passed on before more data arrives", "[mock][stream]")
+{
+    GIVEN ("A mock server that sends 1 small event and then goes idle")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.stream_events = 1;
+        config.stream_interval = milliseconds(0);
+        config.stream_idle = seconds(10);
+        server.set_config(config);
+        API masto(server.instance(), "");
+        std::unique_ptr<API::http> ptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        vector<string> names;
+
+        WHEN ("The public timeline is streamed")
+        {
+            const auto start = steady_clock::now();
+            masto.get_stream(API::v1::streaming_public, ptr,
+                             [&](const sse_event &event)
+                             {
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 names.push_back(event.get_name());
+                                 cv.notify_all();
+                             });
+            steady_clock::duration duration;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(5), [&] { return !names.empty(); });
+                duration = steady_clock::now() - start;
+            }
+            ptr->cancel_stream();
+
+            THEN ("The event is passed on at once")
+            {
+                REQUIRE(names == vector<string>({ "update" }));
+                REQUIRE(duration < milliseconds(100));
+            }
+        }
+    }
+}
+
+SCENARIO ("Streams can be cancelled at any time", "[mock][stream]")
+{
+    GIVEN ("A mock server that sends an event every 100 ms for a minute")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.stream_events = 600;
+        server.set_config(config);
+        API masto(server.instance(), "");
+        std::unique_ptr<API::http> ptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t events = 0;
+
+        masto.get_stream(API::v1::streaming_public, ptr,
+                         [&](const sse_event &)
+                         {
+                             std::lock_guard<std::mutex> lock(mutex);
+                             ++events;
+                             cv.notify_all();
+                         });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, seconds(5), [&] { return events > 0; });
+        }
+
+        WHEN ("The stream is cancelled while waiting for data")
+        {
+            const auto start = steady_clock::now();
+            ptr->cancel_stream();
+            const auto duration = steady_clock::now() - start;
+            const std::size_t seen = events;
+            std::this_thread::sleep_for(milliseconds(300));
+
+            THEN ("cancel_stream() returns without waiting for the server")
+                AND_THEN ("No events arrive afterwards")
+            {
+                REQUIRE(seen > 0);
+                REQUIRE(duration < milliseconds(100));
+                REQUIRE(events == seen);
+            }
+        }
+
+        WHEN ("The stream is cancelled from several threads")
+        {
+            std::thread other([&ptr] { ptr->cancel_stream(); });
+            ptr->cancel_stream();
+            other.join();
+            ptr->cancel_stream();
+
+            THEN ("Nothing happens after the first time")
+            {
+                REQUIRE(events > 0);
+            }
+        }
+
+        WHEN ("The stream is cancelled from its own callback")
+        {
+            ptr.reset();
+            events = 0;
+            masto.get_stream(API::v1::streaming_public, ptr,
+                             [&](const sse_event &)
+                             {
+                                 ptr->cancel_stream();
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 ++events;
+                                 cv.notify_all();
+                             });
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(5), [&] { return events > 0; });
+            }
+            std::this_thread::sleep_for(milliseconds(300));
+            ptr->cancel_stream();
+
+            THEN ("The stream ends after the event")
+            {
+                REQUIRE(events == 1);
+            }
+        }
+    }
+}
+
+SCENARIO ("Streams can be cancelled while they connect", "[mock][stream]")
+{
+    std::mutex mutex;
+    std::size_t events = 0;
+    auto callback = [&](const sse_event &)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++events;
+    };
+
+    GIVEN ("A server that does not accept connections")
+    {
+        // Linux drops connection attempts while the queue of a listening
+        // socket is full, they hang until they time out.
+        using Poco::Net::SocketAddress;
+        Poco::Net::ServerSocket listener(SocketAddress("127.0.0.1", 0), 1);
+        vector<Poco::Net::StreamSocket> queued(4);
+        for (Poco::Net::StreamSocket &socket : queued)
+        {
+            try
+            {
+                socket.connect(listener.address(),
+                               Poco::Timespan(0, 200 * 1000));
+            }
+            catch (const Poco::Exception &)
+            {
+                // The queue is full.
+            }
+        }
+        API masto("http://127.0.0.1:"
+                  + std::to_string(listener.address().port()), "");
+        std::unique_ptr<API::http> ptr;
+
+        WHEN ("The stream is cancelled while it connects")
+        {
+            masto.get_stream(API::v1::streaming_public, ptr, callback);
+            std::this_thread::sleep_for(milliseconds(200));
+
+            const auto start = steady_clock::now();
+            ptr->cancel_stream();
+            const auto duration = steady_clock::now() - start;
+
+            THEN ("cancel_stream() returns without waiting for the timeout")
+                AND_THEN ("No events are passed")
+            {
+                REQUIRE(duration < milliseconds(100));
+                REQUIRE(events == 0);
+            }
+        }
+    }
+
+    GIVEN ("A mock server that waits 5 s before it answers")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.latency = seconds(5);
+        server.set_config(config);
+        API masto(server.instance(), "");
+        std::unique_ptr<API::http> ptr;
+
+        WHEN ("The stream is cancelled while it waits for the answer")
+        {
+            masto.get_stream(API::v1::streaming_public, ptr, callback);
+            std::this_thread::sleep_for(milliseconds(200));
+
+            const auto start = steady_clock::now();
+            ptr->cancel_stream();
+            const auto duration = steady_clock::now() - start;
+
+            THEN ("cancel_stream() returns without waiting for the server")
+                AND_THEN ("No events are passed")
+            {
+                REQUIRE(duration < milliseconds(100));
+                REQUIRE(events == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,277 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <atomic>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::vector;
+using std::chrono::seconds;
+using std::chrono::milliseconds;
+
+SCENARIO ("Subscribed streams share threads", "[mock][stream]")
+{
+    GIVEN ("A mock server that sends 3 events")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::map<std::uint64_t, vector<string>> names;
+        std::size_t total = 0;
+
+        // The ID is known after subscribe_stream() returns, so the events
+        // are counted by the index of the stream.
+        auto subscribe = [&](const std::size_t index)
+        {
+            return masto.subscribe_stream(
+                API::v1::streaming_public,
+                [&, index](const sse_event &event)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    names[index].push_back(event.get_name());
+                    ++total;
+                    cv.notify_all();
+                });
+        };
+        auto wait_for = [&](const std::size_t count)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, seconds(5), [&] { return total >= count; });
+        };
+
+        WHEN ("20 streams are read by 2 threads")
+        {
+            masto.set_stream_threads(2);
+            vector<std::uint64_t> ids;
+            for (std::size_t i = 0; i < 20; ++i)
+            {
+                ids.push_back(subscribe(i));
+            }
+            // The server closes the connections after the last event.
+            wait_for(20 * 4);
+
+            THEN ("Every stream gets its events in order")
+                AND_THEN ("The end of every stream is reported")
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(names.size() == 20);
+                for (const auto &stream : names)
+                {
+                    REQUIRE(stream.second == vector<string>
+                            ({ "update", "notification", "delete",
+                               "ERROR" }));
+                }
+                for (const std::uint64_t id : ids)
+                {
+                    REQUIRE(id != 0);
+                }
+            }
+        }
+
+        WHEN ("A call that is not a stream is subscribed")
+        {
+            string data;
+            const std::uint64_t id = masto.subscribe_stream(
+                API::v1::instance,
+                [&](const sse_event &event)
+                {
+                    data = event.get_data();
+                });
+
+            THEN ("An ERROR event is passed to the callback")
+                AND_THEN ("No ID is returned")
+            {
+                REQUIRE(id == 0);
+                REQUIRE(data == "{\"error_code\":1}");
+            }
+        }
+    }
+
+    GIVEN ("A mock server that sends 1 event and then goes idle")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.stream_events = 1;
+        config.stream_interval = milliseconds(0);
+        config.stream_idle = seconds(10);
+        server.set_config(config);
+        API masto(server.instance(), "");
+        timeout_config timeouts;
+        timeouts.receive = milliseconds(200);
+        masto.set_timeouts(timeouts);
+        std::mutex mutex;
+        std::condition_variable cv;
+        vector<string> names;
+        string ended;
+
+        WHEN ("The stream is subscribed")
+        {
+            masto.subscribe_stream(
+                API::v1::streaming_public,
+                [&](const sse_event &event)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    names.push_back(event.get_name());
+                    if (event.is("ERROR"))
+                    {
+                        ended = event.get_data();
+                    }
+                    cv.notify_all();
+                });
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, seconds(5), [&] { return !ended.empty(); });
+            }
+
+            THEN ("The stream ends with error::CONNECTION_TIMEOUT")
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(names == vector<string>({ "update", "ERROR" }));
+                REQUIRE(ended == "{\"error_code\":"
+                        + std::to_string(static_cast<int>(
+                                             error::CONNECTION_TIMEOUT))
+                        + ",\"http_error\":0}");
+            }
+        }
+    }
+
+    GIVEN ("A mock server that sends an event every 100 ms for a minute")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.stream_events = 600;
+        server.set_config(config);
+        API masto(server.instance(), "");
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t events = 0;
+
+        const std::uint64_t id = masto.subscribe_stream(
+            API::v1::streaming_public,
+            [&](const sse_event &)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++events;
+                cv.notify_all();
+            });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, seconds(5), [&] { return events > 0; });
+        }
+
+        WHEN ("The stream is unsubscribed")
+        {
+            masto.unsubscribe_stream(id);
+            std::size_t after;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                after = events;
+            }
+            std::this_thread::sleep_for(milliseconds(300));
+
+            THEN ("The callback is not called anymore")
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(after > 0);
+                REQUIRE(events == after);
+            }
+        }
+
+        WHEN ("A stream is unsubscribed from its own callback")
+        {
+            std::atomic<std::uint64_t> own(0);
+            std::size_t calls = 0;
+            own = masto.subscribe_stream(
+                API::v1::streaming_public,
+                [&](const sse_event &)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ++calls;
+                    }
+                    if (own != 0)
+                    {
+                        masto.unsubscribe_stream(own);
+                    }
+                });
+            std::this_thread::sleep_for(milliseconds(500));
+            std::size_t after;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                after = calls;
+            }
+            std::this_thread::sleep_for(milliseconds(300));
+
+            THEN ("The callback is not called anymore")
+                AND_THEN ("Unsubscribing again does no harm")
+            {
+                masto.unsubscribe_stream(own);
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(after > 0);
+                REQUIRE(calls == after);
+                REQUIRE(events > 0);
+            }
+        }
+
+        WHEN ("2 streams on different threads unsubscribe each other")
+        {
+            masto.set_stream_threads(2);
+            std::atomic<std::uint64_t> first(0);
+            std::atomic<std::uint64_t> second(0);
+            std::atomic<std::size_t> returned(0);
+            std::atomic<std::size_t> calls(0);
+            auto other = [&](std::atomic<std::uint64_t> &target)
+            {
+                return [&](const sse_event &)
+                {
+                    ++calls;
+                    if (target != 0)
+                    {
+                        masto.unsubscribe_stream(target);
+                        ++returned;
+                    }
+                };
+            };
+            // The first stream is on the first thread, these get one each.
+            first = masto.subscribe_stream(API::v1::streaming_public,
+                                           other(second));
+            second = masto.subscribe_stream(API::v1::streaming_public,
+                                            other(first));
+            std::this_thread::sleep_for(milliseconds(500));
+            const std::size_t after = calls;
+            std::this_thread::sleep_for(milliseconds(300));
+
+            THEN ("Unsubscribing does not block")
+                AND_THEN ("The callbacks are not called anymore")
+            {
+                REQUIRE(returned > 0);
+                REQUIRE(calls == after);
+            }
+        }
+    }
+}
@@ -0,0 +1,197 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "environment_variables.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+
+SCENARIO ("Timeouts are reported", "[api][mastodon][pleroma][glitch-soc]")
+{
+    GIVEN ("instance = " + instance)
+    {
+        Mastodon::API masto(instance, "");
+        return_call ret;
+        bool exception = false;
+
+        WHEN ("GET /api/v1/instance is called with a total timeout of 1 ms")
+        {
+            try
+            {
+                timeout_config timeouts;
+                timeouts.total = std::chrono::milliseconds(1);
+                API::scoped_timeouts guard(masto, timeouts);
+
+                ret = masto.get(API::v1::instance);
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("error::CONNECTION_TIMEOUT is returned")
+            {
+                REQUIRE_FALSE(exception);
+                REQUIRE(ret.error_code
+                        == static_cast<uint8_t>(error::CONNECTION_TIMEOUT));
+            }
+        }
+
+        WHEN ("GET /api/v1/instance is called after the guard is gone")
+        {
+            try
+            {
+                {
+                    timeout_config timeouts;
+                    timeouts.total = std::chrono::milliseconds(1);
+                    API::scoped_timeouts guard(masto, timeouts);
+                }
+
+                ret = masto.get(API::v1::instance);
+            }
+            catch (const std::exception &e)
+            {
+                exception = true;
+                WARN(e.what());
+            }
+
+            THEN("No exception is thrown")
+                AND_THEN ("No errors are returned")
+            {
+                REQUIRE_FALSE(exception);
+                REQUIRE(ret.error_code == 0);
+            }
+        }
+    }
+}
+
+SCENARIO ("Timeouts while the body is read are reported", "[mock]")
+{
+    GIVEN ("A mock server that pauses for 500 ms in the middle of a body")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.body_stall = std::chrono::milliseconds(500);
+        server.set_config(config);
+        API masto(server.instance(), "");
+        timeout_config timeouts;
+        timeouts.receive = std::chrono::milliseconds(100);
+        masto.set_timeouts(timeouts);
+        retry_config retry;
+        retry.max_attempts = 1;
+        masto.set_retry(retry);
+
+        WHEN ("GET /api/v1/instance is called with a receive timeout of "
+              "100 ms")
+        {
+            const return_call ret = masto.get(API::v1::instance);
+
+            server.set_config(mock_config());
+            const return_call second = masto.get(API::v1::instance);
+
+            THEN ("error::CONNECTION_TIMEOUT is returned")
+                AND_THEN ("The connection is not used again")
+            {
+                REQUIRE(ret.error_code
+                        == static_cast<uint8_t>(error::CONNECTION_TIMEOUT));
+                REQUIRE(second.error_code == 0);
+                REQUIRE(server.connections() == 2);
+            }
+        }
+    }
+}
+
+SCENARIO ("Streams use the timeouts of the API object", "[mock][stream]")
+{
+    GIVEN ("A mock server that sends 1 event and then goes idle")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.stream_events = 1;
+        config.stream_interval = std::chrono::milliseconds(0);
+        config.stream_idle = std::chrono::seconds(10);
+        server.set_config(config);
+        API masto(server.instance(), "");
+        std::unique_ptr<API::http> ptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<string> names;
+        string error;
+        auto callback = [&](const sse_event &event)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            names.push_back(event.get_name());
+            if (event.is("ERROR"))
+            {
+                error = event.get_data();
+            }
+            cv.notify_all();
+        };
+        auto wait_for_end = [&]
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, std::chrono::seconds(5),
+                        [&] { return !error.empty(); });
+        };
+        timeout_config timeouts;
+        timeouts.receive = std::chrono::milliseconds(200);
+        const string expected = "{\"error_code\":"
+            + std::to_string(static_cast<int>(error::CONNECTION_TIMEOUT))
+            + ",\"http_error\":0}";
+
+        WHEN ("The idle timeout is set with set_timeouts()")
+        {
+            masto.set_timeouts(timeouts);
+            const auto start = std::chrono::steady_clock::now();
+            masto.get_stream(API::v1::streaming_public, ptr, callback);
+            wait_for_end();
+            const auto duration = std::chrono::steady_clock::now() - start;
+            ptr->cancel_stream();
+
+            THEN ("The stream ends with error::CONNECTION_TIMEOUT")
+            {
+                REQUIRE(names == std::vector<string>({ "update", "ERROR" }));
+                REQUIRE(error == expected);
+                REQUIRE(duration < std::chrono::seconds(2));
+            }
+        }
+
+        WHEN ("The idle timeout is set with scoped_timeouts")
+        {
+            {
+                API::scoped_timeouts guard(masto, timeouts);
+                masto.get_stream(API::v1::streaming_public, ptr, callback);
+            }
+            wait_for_end();
+            ptr->cancel_stream();
+
+            THEN ("The stream ends with error::CONNECTION_TIMEOUT")
+            {
+                REQUIRE(error == expected);
+            }
+        }
+    }
+}
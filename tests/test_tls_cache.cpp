@@ -0,0 +1,106 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>
+#include <istream>
+#include <catch.hpp>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/Context.h>
+#include <Poco/Net/SSLManager.h>
+#include <Poco/Net/AcceptCertificateHandler.h>
+#include <Poco/Net/SecureStreamSocket.h>
+#include "tls_cache.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using Poco::Net::HTTPRequest;
+using Poco::Net::HTTPResponse;
+using Poco::Net::Context;
+using Poco::Net::SSLManager;
+
+SCENARIO ("TLS sessions are handed to new connections", "[mock]")
+{
+    GIVEN ("A mock server with TLS and a tls_cache")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES, 0, true);
+
+        // The certificate of the mock server is self-signed.
+        Context::Ptr context = new Context(Context::CLIENT_USE, "", "", "",
+                                           Context::VERIFY_NONE);
+        context->enableExtendedCertificateVerification(false);
+        SSLManager::instance().initializeClient(
+            SSLManager::PrivateKeyPassphraseHandlerPtr(),
+            SSLManager::InvalidCertificateHandlerPtr(
+                new Poco::Net::AcceptCertificateHandler(false)),
+            context);
+        tls_cache cache;
+
+        // Makes a request, so that the server has sent its session.
+        auto call = [](HTTPClientSession &session)
+        {
+            HTTPRequest request(HTTPRequest::HTTP_GET, "/api/v1/instance",
+                                HTTPRequest::HTTP_1_1);
+            session.sendRequest(request);
+            HTTPResponse response;
+            session.receiveResponse(response).ignore(
+                std::numeric_limits<std::streamsize>::max());
+            return response.getStatus();
+        };
+
+        WHEN ("The session of a connection is stored")
+        {
+            unique_ptr<HTTPSClientSession> first =
+                cache.make_session("127.0.0.1", server.port());
+            const int status = call(*first);
+            cache.store("127.0.0.1", *first);
+            const Poco::Net::Session::Ptr stored =
+                Poco::Net::SecureStreamSocket(first->socket())
+                .currentSession();
+
+            THEN ("The next session to the host resumes it")
+                AND_THEN ("Sessions to other hosts don't")
+            {
+                REQUIRE(status == HTTPResponse::HTTP_OK);
+                REQUIRE_FALSE(stored.isNull());
+
+                unique_ptr<HTTPSClientSession> second =
+                    cache.make_session("127.0.0.1", server.port());
+                REQUIRE(second->sslSession().get() == stored.get());
+                REQUIRE(call(*second) == HTTPResponse::HTTP_OK);
+
+                unique_ptr<HTTPSClientSession> other =
+                    cache.make_session("localhost", server.port());
+                REQUIRE(other->sslSession().isNull());
+            }
+        }
+
+        WHEN ("The cache is cleared")
+        {
+            unique_ptr<HTTPSClientSession> first =
+                cache.make_session("127.0.0.1", server.port());
+            call(*first);
+            cache.store("127.0.0.1", *first);
+            cache.clear();
+
+            THEN ("New sessions start without a TLS session")
+            {
+                REQUIRE(cache.make_session("127.0.0.1", server.port())
+                        ->sslSession().isNull());
+            }
+        }
+    }
+}
@@ -0,0 +1,208 @@
+/*  This file is part of mastodon-cpp.
+ *  Copyright © 2019 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <iterator>
+#include <Poco/Version.h>
+#include <Poco/Exception.h>
+#include <Poco/TemporaryFile.h>
+#include <catch.hpp>
+#include "mastodon-cpp.hpp"
+#include "file_part_source.hpp"
+#include "easy/easy.hpp"
+#include "easy/entities/status.hpp"
+#include "easy/entities/attachment.hpp"
+#include "mock_server.hpp"
+
+using namespace Mastodon;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace
+{
+    // Writes size bytes to file.
+    void fill_file(const Poco::TemporaryFile &file, const std::size_t size)
+    {
+        std::ofstream out(file.path(), std::ios::binary);
+        // The last byte differs, to notice a missing end.
+        string block(4096, 'x');
+        for (std::size_t written = 0; written < size; written += block.size())
+        {
+            const std::size_t piece = std::min(block.size(), size - written);
+            if (written + piece == size)
+            {
+                block[piece - 1] = 'y';
+            }
+            out.write(block.data(), static_cast<std::streamsize>(piece));
+        }
+    }
+
+    // Returns the contents of file.
+    string read_file(const string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return string(std::istreambuf_iterator<char>(in),
+                      std::istreambuf_iterator<char>());
+    }
+}
+
+SCENARIO ("Files are uploaded in parts")
+{
+    GIVEN ("A file of 1 MB")
+    {
+        Poco::TemporaryFile file;
+        fill_file(file, 1024 * 1024);
+
+        WHEN ("It is read")
+        {
+            file_part_source part(file.path());
+            const string content(
+                (std::istreambuf_iterator<char>(part.stream())),
+                std::istreambuf_iterator<char>());
+
+            THEN ("The whole file was read")
+            {
+                REQUIRE(content == read_file(file.path()));
+            }
+        }
+
+        WHEN ("It gets shorter while it is read")
+        {
+            file_part_source part(file.path());
+            char buffer[8192];
+            part.stream().read(buffer, sizeof(buffer));
+            std::ofstream(file.path(), std::ios::trunc).close();
+
+            THEN ("Reading throws")
+            {
+                REQUIRE_THROWS_AS(part.stream().read(buffer, sizeof(buffer)),
+                                  Poco::IOException);
+            }
+        }
+    }
+
+    GIVEN ("An empty file")
+    {
+        Poco::TemporaryFile file;
+        fill_file(file, 0);
+
+        WHEN ("A part is created from it")
+        {
+            file_part_source part(file.path());
+            const string content(
+                (std::istreambuf_iterator<char>(part.stream())),
+                std::istreambuf_iterator<char>());
+
+            THEN ("Nothing is read")
+            {
+                REQUIRE(content.empty());
+            }
+        }
+    }
+}
+
+SCENARIO ("Uploads report their progress", "[mock][upload]")
+{
+    GIVEN ("A mock server and a file of 1 MB")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        API masto(server.instance(), "");
+        Poco::TemporaryFile file;
+        fill_file(file, 1024 * 1024);
+        std::size_t calls = 0;
+        std::uint64_t total = 0;
+        std::uint64_t sent = 0;
+        masto.set_progress_callback(
+            [&](const std::uint64_t, const std::uint64_t,
+                const std::uint64_t ultotal, const std::uint64_t ulnow)
+            {
+                if (ulnow > 0)
+                {
+                    ++calls;
+                    total = ultotal;
+                    sent = ulnow;
+                }
+            });
+
+        WHEN ("The file is uploaded")
+        {
+            const return_call ret = masto.post(API::v1::media,
+                                               {{ "file", { file.path() }}});
+
+            THEN ("The progress is reported while it is sent")
+            {
+                REQUIRE(ret.error_code == 0);
+                REQUIRE(calls > 1);
+                REQUIRE(sent > 1024 * 1024);
+#if POCO_VERSION >= 0x01070000
+                REQUIRE(total == sent);
+#endif
+            }
+        }
+    }
+}
+
+SCENARIO ("A failed upload cancels the other uploads", "[mock][upload]")
+{
+    GIVEN ("A mock server that reads 1 MB/s and fails every request")
+    {
+        mock_server server(MASTODON_CPP_FIXTURES);
+        mock_config config;
+        config.upload_bandwidth = 1024 * 1024;
+        config.error_every = 1;
+        server.set_config(config);
+        Easy::API masto(server.instance(), "");
+
+        // The small file fails first, the large ones take 8 s each.
+        Poco::TemporaryFile small;
+        fill_file(small, 1024);
+        Poco::TemporaryFile large[3];
+        vector<Easy::Attachment> attachments;
+        attachments.push_back(Easy::Attachment().file(small.path()));
+        for (const Poco::TemporaryFile &file : large)
+        {
+            fill_file(file, 8 * 1024 * 1024);
+            attachments.push_back(Easy::Attachment().file(file.path()));
+        }
+
+        Easy::Status status;
+        status.content("Test");
+        status.media_attachments(attachments);
+
+        WHEN ("A post with 4 attachments is sent")
+        {
+            const steady_clock::time_point start = steady_clock::now();
+            const Easy::return_entity<Easy::Status> ret = masto.send_post(status);
+            const milliseconds elapsed = std::chrono::duration_cast
+                <milliseconds>(steady_clock::now() - start);
+
+            THEN ("The error of the first upload is returned")
+                AND_THEN ("The other uploads were stopped")
+            {
+                REQUIRE(ret.error_code
+                        == static_cast<uint8_t>(error::CONNECTION_REFUSED));
+                REQUIRE(ret.http_error_code == 503);
+                REQUIRE(elapsed < seconds(2));
+            }
+        }
+    }
+}